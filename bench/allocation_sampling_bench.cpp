@@ -0,0 +1,58 @@
+// Sampling overhead benchmark: allocates and frees small objects through
+// AllocatorWrapper over the thread-cached pool, with and without allocation
+// sampling at the default rate. Unsampled allocations only pay for a
+// thread-local countdown and a filter lookup on free.
+#include <cstddef>
+#include <vector>
+
+#include "allocation_sampler.h"
+#include "allocator_wrapper.h"
+#include "bench_util.h"
+
+using namespace easystl;
+
+namespace {
+constexpr int kOps = 1 << 22;
+constexpr int kLive = 1024;
+constexpr int kMaxThreads = 4;
+
+struct Node {
+  long long value[4];
+};
+
+struct PlainPool : ThreadCachedPoolAllocator {
+  static constexpr bool kSampled = false;
+};
+struct SampledPool : ThreadCachedPoolAllocator {
+  static constexpr bool kSampled = true;
+};
+
+template <class Pool> auto Run(const char *label, const int threads) -> void {
+  using Wrapper = AllocatorWrapper<Node, Pool>;
+  const double ns = bench::MeasureThreadsNs(threads, [](int /*index*/) {
+    std::vector<Node *> live(kLive, nullptr);
+    for (int i = 0; i < kOps; ++i) {
+      Node *&slot = live[static_cast<std::size_t>(i % kLive)];
+      if (slot != nullptr) {
+        Wrapper::Deallocate(slot, 1);
+      }
+      slot = Wrapper::Allocate(1);
+      slot->value[0] = i;
+    }
+    for (Node *node : live) {
+      Wrapper::Deallocate(node, 1);
+    }
+  });
+  bench::Report(label, threads, ns, static_cast<double>(kOps) * threads);
+}
+} // namespace
+
+auto main() -> int {
+  std::printf("%-28s %8s   (sample rate %zu bytes)\n", "variant", "threads",
+              AllocationSampler::SampleRate());
+  for (int threads = 1; threads <= kMaxThreads; threads *= 2) {
+    Run<PlainPool>("unsampled", threads);
+    Run<SampledPool>("sampled", threads);
+  }
+  return 0;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#ifndef EASYSTL_BENCH_UTIL_H_
+#define EASYSTL_BENCH_UTIL_H_
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace easystl::bench {
+/**
+ * @brief Measures the wall-clock time of a callable.
+ * @tparam Func The type of the callable.
+ * @param func The callable to run once.
+ * @return The elapsed time in nanoseconds.
+ */
+template <class Func> auto MeasureNs(Func &&func) -> double {
+  const auto start = std::chrono::steady_clock::now();
+  func();
+  const auto stop = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(stop - start).count();
+}
+
+/**
+ * @brief Runs a callable on `threads` threads at once and measures the time
+ * until all of them finished.
+ * @tparam Func The type of the callable, invoked with the thread index.
+ * @param threads The number of threads to start.
+ * @param func The callable each thread runs.
+ * @return The elapsed time in nanoseconds.
+ */
+template <class Func>
+auto MeasureThreadsNs(const int threads, Func &&func) -> double {
+  return MeasureNs([&] {
+    std::vector<std::thread> workers;
+    workers.reserve(static_cast<std::size_t>(threads));
+    for (int i = 0; i < threads; ++i) {
+      workers.emplace_back(func, i);
+    }
+    for (auto &worker : workers) {
+      worker.join();
+    }
+  });
+}
+
+/**
+ * @brief Prints one result row: a label, a parameter and a per-op time.
+ * @param label The name of the measured variant.
+ * @param param The varied parameter (threads, size, ...).
+ * @param ns The total elapsed time in nanoseconds.
+ * @param ops The number of operations performed in that time.
+ */
+inline auto Report(const char *label, const long long param, const double ns,
+                   const double ops) -> void {
+  std::printf("%-28s %8lld %12.2f ns/op %14.0f ops/s\n", label, param,
+              ns / ops, ops * 1e9 / ns);
+}
+} // namespace easystl::bench
+
+#endif // !EASYSTL_BENCH_UTIL_H_
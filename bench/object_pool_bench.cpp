@@ -0,0 +1,65 @@
+// Object churn benchmark: a ring of live message objects is replaced one by
+// one, as connection and message objects are in a server. Each message owns a
+// reserved payload buffer, so constructing one costs an extra allocation.
+// ObjectPool reuses slots without searching; with KeepConstructed it also
+// keeps the payload buffers and skips the constructor altogether.
+#include <cstddef>
+#include <vector>
+
+#include "bench_util.h"
+#include "object_pool.h"
+
+using namespace easystl;
+
+namespace {
+constexpr int kOps = 1 << 22;
+constexpr int kLive = 4096;
+
+struct Message {
+  Message() { payload.reserve(256); }
+  explicit Message(const int newid) : Message() { id = newid; }
+  auto Reset(const int newid) -> void {
+    id = newid;
+    payload.clear();
+  }
+
+  int id = 0;
+  std::vector<char> payload;
+};
+
+template <class Create, class Recycle>
+auto Run(const char *label, Create &&create, Recycle &&recycle) -> void {
+  std::vector<Message *> ring(kLive, nullptr);
+  const double ns = bench::MeasureNs([&] {
+    for (int i = 0; i < kOps; ++i) {
+      Message *&slot = ring[static_cast<std::size_t>(i % kLive)];
+      if (slot != nullptr) {
+        recycle(slot);
+      }
+      slot = create(i);
+      slot->payload.push_back('x');
+    }
+  });
+  bench::Report(label, kLive, ns, kOps);
+  for (Message *message : ring) {
+    recycle(message);
+  }
+}
+} // namespace
+
+auto main() -> int {
+  std::printf("%-28s %8s\n", "variant", "live");
+  Run(
+      "new/delete", [](const int id) { return new Message(id); },
+      [](Message *message) { delete message; });
+  ObjectPool<Message> destroying;
+  Run(
+      "ObjectPool", [&](const int id) { return destroying.Create(id); },
+      [&](Message *message) { destroying.Recycle(message); });
+  ObjectPool<Message, DefaultAllocator, KeepConstructed> keeping;
+  Run(
+      "ObjectPool KeepConstructed",
+      [&](const int id) { return keeping.Create(id); },
+      [&](Message *message) { keeping.Recycle(message); });
+  return 0;
+}
@@ -0,0 +1,54 @@
+// Batch benchmark: AllocateBatch/DeallocateBatch against the same number of
+// single Allocate/Deallocate calls, for the single-threaded and thread-cached
+// pools. Each round takes `batch` blocks and gives all of them back, as a
+// container building and tearing down that many nodes would.
+#include <vector>
+
+#include "bench_util.h"
+#include "memory_pool_allocator.h"
+
+using namespace easystl;
+
+namespace {
+constexpr std::size_t kBlockSize = 32;
+constexpr std::size_t kBlocksPerRun = 1 << 22;
+
+template <class Pool>
+auto RunSingle(const char *label, const std::size_t batch) -> void {
+  std::vector<void *> ptrs(batch);
+  const double ns = bench::MeasureNs([&] {
+    for (std::size_t done = 0; done < kBlocksPerRun; done += batch) {
+      for (std::size_t i = 0; i < batch; ++i) {
+        ptrs[i] = Pool::Allocate(kBlockSize);
+      }
+      for (std::size_t i = 0; i < batch; ++i) {
+        Pool::Deallocate(ptrs[i], kBlockSize);
+      }
+    }
+  });
+  bench::Report(label, static_cast<long long>(batch), ns, kBlocksPerRun);
+}
+
+template <class Pool>
+auto RunBatch(const char *label, const std::size_t batch) -> void {
+  std::vector<void *> ptrs(batch);
+  const double ns = bench::MeasureNs([&] {
+    for (std::size_t done = 0; done < kBlocksPerRun; done += batch) {
+      Pool::AllocateBatch(kBlockSize, batch, ptrs.data());
+      Pool::DeallocateBatch(kBlockSize, batch, ptrs.data());
+    }
+  });
+  bench::Report(label, static_cast<long long>(batch), ns, kBlocksPerRun);
+}
+} // namespace
+
+auto main() -> int {
+  std::printf("%-28s %8s\n", "variant", "batch");
+  for (std::size_t batch = 8; batch <= 4096; batch *= 4) {
+    RunSingle<MemoryPoolAllocator>("pool Allocate", batch);
+    RunBatch<MemoryPoolAllocator>("pool AllocateBatch", batch);
+    RunSingle<ThreadCachedPoolAllocator>("thread-cached Allocate", batch);
+    RunBatch<ThreadCachedPoolAllocator>("thread-cached AllocateBatch", batch);
+  }
+  return 0;
+}
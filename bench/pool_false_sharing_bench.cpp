@@ -0,0 +1,55 @@
+// False-sharing benchmark: every thread allocates its own counter from the
+// pool and increments it. Plain 8-byte blocks are carved back to back, so the
+// counters of up to eight threads share one cache line and every increment
+// steals the line from the other cores; cache-aligned blocks give each
+// counter a line of its own.
+#include <atomic>
+#include <new>
+#include <vector>
+
+#include "bench_util.h"
+#include "memory_pool_allocator.h"
+
+using namespace easystl;
+
+namespace {
+constexpr long long kIncrements = 1 << 24;
+constexpr int kMaxThreads = 8;
+
+using Counter = std::atomic<long long>;
+
+template <bool CacheAligned>
+auto Run(const char *label, const int threads) -> void {
+  using Pool = MemoryPoolAllocator;
+  std::vector<Counter *> counters;
+  for (int i = 0; i < threads; ++i) {
+    void *block = CacheAligned ? Pool::AllocateCacheAligned(sizeof(Counter))
+                               : Pool::Allocate(sizeof(Counter));
+    counters.push_back(new (block) Counter(0));
+  }
+  const double ns = bench::MeasureThreadsNs(threads, [&](const int index) {
+    Counter &counter = *counters[static_cast<std::size_t>(index)];
+    for (long long i = 0; i < kIncrements; ++i) {
+      counter.fetch_add(1, std::memory_order_relaxed);
+    }
+  });
+  bench::Report(label, threads, ns, static_cast<double>(kIncrements));
+  for (Counter *counter : counters) {
+    counter->~Counter();
+    if constexpr (CacheAligned) {
+      Pool::DeallocateCacheAligned(counter, sizeof(Counter));
+    } else {
+      Pool::Deallocate(counter, sizeof(Counter));
+    }
+  }
+}
+} // namespace
+
+auto main() -> int {
+  std::printf("%-28s %8s\n", "variant", "threads");
+  for (int threads = 1; threads <= kMaxThreads; threads *= 2) {
+    Run<false>("packed counters", threads);
+    Run<true>("cache-aligned counters", threads);
+  }
+  return 0;
+}
@@ -0,0 +1,84 @@
+// Fragmentation benchmark: a "request" subsystem allocates bursts of
+// short-lived blocks while a "session" subsystem keeps a few long-lived blocks
+// allocated between them. In a shared pool the session blocks pin the chunks
+// the bursts were carved from, so Trim gives little back after the requests
+// are gone; with one tagged pool per subsystem the request chunks hold only
+// request blocks and are released entirely.
+#include <cstddef>
+#include <cstdio>
+#include <type_traits>
+#include <vector>
+
+#include "bench_util.h"
+#include "memory_pool_allocator.h"
+
+using namespace easystl;
+
+namespace {
+constexpr int kRounds = 64;
+constexpr int kBurst = 4096;
+
+struct SharedTag {};
+struct RequestTag {};
+struct SessionTag {};
+
+/**
+ * @brief Runs the mixed workload and prints the time per allocation and the
+ * footprint left after every request block was freed and the pools trimmed.
+ * @tparam RequestPool The pool of the request subsystem.
+ * @tparam SessionPool The pool of the session subsystem.
+ * @param label The name of the variant.
+ * @param sessionevery One session block is kept per this many request blocks.
+ */
+template <class RequestPool, class SessionPool>
+auto Run(const char *label, const int sessionevery) -> void {
+  std::vector<void *> sessions;
+  std::vector<void *> requests;
+  requests.reserve(kBurst);
+  const double ns = bench::MeasureNs([&] {
+    for (int round = 0; round < kRounds; ++round) {
+      for (int i = 0; i < kBurst; ++i) {
+        const std::size_t size = 16 + static_cast<std::size_t>(i * 8) % 112;
+        requests.push_back(RequestPool::Allocate(size));
+        if (i % sessionevery == 0) {
+          sessions.push_back(SessionPool::Allocate(48));
+        }
+      }
+      for (int i = 0; i < kBurst; ++i) {
+        RequestPool::Deallocate(requests[static_cast<std::size_t>(i)],
+                                16 + static_cast<std::size_t>(i * 8) % 112);
+      }
+      requests.clear();
+    }
+  });
+  bench::Report(label, sessionevery, ns,
+                static_cast<double>(kRounds) * kBurst +
+                    static_cast<double>(sessions.size()));
+
+  RequestPool::Trim();
+  SessionPool::Trim();
+  std::size_t footprint = SessionPool::Footprint();
+  if constexpr (!std::is_same_v<RequestPool, SessionPool>) {
+    footprint += RequestPool::Footprint();
+  }
+  std::printf("%-28s %8d %12zu KiB footprint %8zu KiB live\n", "  after trim",
+              sessionevery, footprint / 1024, sessions.size() * 48 / 1024);
+
+  for (void *session : sessions) {
+    SessionPool::Deallocate(session, 48);
+  }
+  SessionPool::Trim();
+  RequestPool::Trim();
+}
+} // namespace
+
+auto main() -> int {
+  std::printf("%-28s %8s\n", "variant", "requests/session");
+  for (const int sessionevery : {1000, 100, 10}) {
+    Run<TaggedPoolAllocator<SharedTag>, TaggedPoolAllocator<SharedTag>>(
+        "shared pool", sessionevery);
+    Run<TaggedPoolAllocator<RequestTag>, TaggedPoolAllocator<SessionTag>>(
+        "isolated pools", sessionevery);
+  }
+  return 0;
+}
@@ -0,0 +1,68 @@
+// Contention benchmark: lock-free ConcurrentMemoryPoolList against a
+// MemoryPoolList guarded by a std::mutex. Every thread repeatedly pops a few
+// nodes from the shared list and pushes them back, which is what thread
+// caches do to the central free lists of the pool.
+#include <array>
+#include <mutex>
+
+#include "bench_util.h"
+#include "concurrent_pool_list.h"
+
+using namespace easystl;
+
+namespace {
+constexpr int kOpsPerThread = 200000;
+constexpr int kNodesPerThread = 8;
+
+using Node = std::array<void *, 2>;
+
+class LockedList {
+public:
+  auto Push(void *node) -> void {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    list_.Push(node);
+  }
+
+  auto Pop() -> void * {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    return list_.Empty() ? nullptr : list_.Pop();
+  }
+
+private:
+  std::mutex mutex_;
+  MemoryPoolList list_;
+};
+
+template <class List> auto Run(const char *label, const int threads) -> void {
+  List list;
+  std::vector<Node> nodes(static_cast<std::size_t>(threads) * kNodesPerThread);
+  for (auto &node : nodes) {
+    list.Push(node.data());
+  }
+  const double ns = bench::MeasureThreadsNs(threads, [&list](int) {
+    void *owned[kNodesPerThread];
+    for (int op = 0; op < kOpsPerThread; op += 2 * kNodesPerThread) {
+      int count = 0;
+      for (int i = 0; i < kNodesPerThread; ++i) {
+        if (void *node = list.Pop()) {
+          owned[count++] = node;
+        }
+      }
+      for (int i = 0; i < count; ++i) {
+        list.Push(owned[i]);
+      }
+    }
+  });
+  bench::Report(label, threads, ns,
+                static_cast<double>(threads) * kOpsPerThread);
+}
+} // namespace
+
+auto main() -> int {
+  std::printf("%-28s %8s\n", "list", "threads");
+  for (int threads = 1; threads <= 64; threads *= 2) {
+    Run<ConcurrentMemoryPoolList>("ConcurrentMemoryPoolList", threads);
+    Run<LockedList>("mutex + MemoryPoolList", threads);
+  }
+  return 0;
+}
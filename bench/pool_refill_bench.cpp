@@ -0,0 +1,78 @@
+// Refill benchmark: FixedRefill against AdaptiveRefill on a pool with
+// geometric size classes. A hot class allocates and frees a large working set
+// in waves while every other class allocates a single block, so the output
+// shows how often the hot class refills and how much memory cold classes
+// strand in chunks.
+#include <vector>
+
+#include "bench_util.h"
+#include "memory_pool_allocator.h"
+
+using namespace easystl;
+
+namespace {
+constexpr std::size_t kHotSize = 32;
+constexpr std::size_t kHotBlocks = 1 << 16;
+constexpr int kWaves = 64;
+
+struct FixedTraits : LargeClassPoolTraits {
+  static constexpr bool kStats = true;
+};
+struct AdaptiveTraits : LargeClassPoolTraits {
+  static constexpr bool kStats = true;
+  using RefillPolicy = AdaptiveRefill<>;
+};
+
+template <class Traits> auto Run(const char *label) -> void {
+  using Pool = BasicMemoryPoolAllocator<Traits>;
+  using SizeClasses = typename Traits::SizeClasses;
+
+  std::vector<void *> cold;
+  for (std::size_t i = 0; i < SizeClasses::kNum; ++i) {
+    if (SizeClasses::Size(i) != kHotSize) {
+      cold.push_back(Pool::Allocate(SizeClasses::Size(i)));
+    }
+  }
+
+  std::vector<void *> hot(kHotBlocks);
+  const double ns = bench::MeasureNs([&] {
+    for (int wave = 0; wave < kWaves; ++wave) {
+      for (auto &ptr : hot) {
+        ptr = Pool::Allocate(kHotSize);
+      }
+      for (auto *ptr : hot) {
+        Pool::Deallocate(ptr, kHotSize);
+      }
+    }
+  });
+
+  const auto stats = Pool::Stats();
+  std::size_t coldrefills = 0;
+  std::size_t coldcached = 0;
+  for (std::size_t i = 0; i < SizeClasses::kNum; ++i) {
+    if (SizeClasses::Size(i) != kHotSize) {
+      coldrefills += stats.classes[i].refills;
+      coldcached += stats.classes[i].CachedBytes();
+    }
+  }
+  bench::Report(label, kHotSize, ns,
+                static_cast<double>(kWaves) * kHotBlocks);
+  std::printf("  hot refills %zu, cold refills %zu, cold bytes cached %zu, "
+              "system bytes %zu\n",
+              stats.classes[SizeClasses::Index(kHotSize)].refills, coldrefills,
+              coldcached, stats.systembytes);
+
+  for (std::size_t i = 0, j = 0; i < SizeClasses::kNum; ++i) {
+    if (SizeClasses::Size(i) != kHotSize) {
+      Pool::Deallocate(cold[j++], SizeClasses::Size(i));
+    }
+  }
+}
+} // namespace
+
+auto main() -> int {
+  std::printf("%-28s %8s\n", "policy", "size");
+  Run<FixedTraits>("FixedRefill<20>");
+  Run<AdaptiveTraits>("AdaptiveRefill<4, 512>");
+  return 0;
+}
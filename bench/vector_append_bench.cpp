@@ -0,0 +1,78 @@
+// Append benchmark for the vector growth policies. "small" fills 64Ki vectors
+// with 1 to 300 ints each from a pool with geometric size classes and reports
+// the pool footprint at the peak, which includes the slack of every block;
+// "large" appends 4Mi ints to one vector over malloc, which grows it with
+// realloc, and reports the peak of live bytes. A factor of 1.5 keeps less
+// unused capacity than 2 on average at the cost of more reallocations;
+// rounding to the size class turns the slack of each block into capacity,
+// saving reallocations and memory.
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+
+#include "allocator_policy.h"
+#include "bench_util.h"
+#include "memory_pool_allocator.h"
+#include "vector.h"
+
+using namespace easystl;
+
+namespace {
+constexpr int kVectors = 1 << 16;
+constexpr int kMaxLength = 300;
+constexpr int kLarge = 1 << 22;
+
+template <class Tag>
+using Pool = StatsAllocator<TaggedPoolAllocator<Tag, LargeClassPoolTraits>, Tag>;
+template <class Tag> using Malloc = StatsAllocator<MallocAllocator, Tag>;
+
+template <class Tag, class Growth> auto RunSmall(const char *label) -> void {
+  using Vector = vector<int, Pool<Tag>, Growth>;
+  std::vector<Vector> vectors(kVectors);
+  std::size_t ops = 0;
+  const double ns = bench::MeasureNs([&] {
+    for (int i = 0; i < kVectors; ++i) {
+      const int length = 1 + (i * 7919) % kMaxLength;
+      Vector &v = vectors[static_cast<std::size_t>(i)];
+      for (int j = 0; j < length; ++j) {
+        v.push_back(j);
+      }
+      ops += static_cast<std::size_t>(length);
+    }
+  });
+  bench::Report(label, kVectors, ns, static_cast<double>(ops));
+  const AllocationStats stats = Pool<Tag>::Stats();
+  std::printf("%-28s %8s %12zu KiB footprint %8zu (re)allocations\n", "", "",
+              TaggedPoolAllocator<Tag, LargeClassPoolTraits>::Footprint() /
+                  1024,
+              stats.allocations + stats.reallocations);
+}
+
+template <class Tag, class Growth> auto RunLarge(const char *label) -> void {
+  using Vector = vector<int, Malloc<Tag>, Growth>;
+  const double ns = bench::MeasureNs([] {
+    Vector v;
+    for (int i = 0; i < kLarge; ++i) {
+      v.push_back(i);
+    }
+  });
+  bench::Report(label, kLarge, ns, kLarge);
+  const AllocationStats stats = Malloc<Tag>::Stats();
+  std::printf("%-28s %8s %12zu KiB peak %13zu (re)allocations\n", "", "",
+              stats.peakbytes / 1024, stats.allocations + stats.reallocations);
+}
+
+template <int N> struct Tag {};
+} // namespace
+
+auto main() -> int {
+  std::printf("%-28s %8s\n", "small: variant", "vectors");
+  RunSmall<Tag<0>, GeometricGrowth<2, 1, 16, false>>("x2");
+  RunSmall<Tag<1>, GeometricGrowth<2, 1, 16, true>>("x2, size classes");
+  RunSmall<Tag<2>, GeometricGrowth<3, 2, 16, false>>("x1.5");
+  RunSmall<Tag<3>, GeometricGrowth<3, 2, 16, true>>("x1.5, size classes");
+  std::printf("%-28s %8s\n", "large: variant", "ints");
+  RunLarge<Tag<4>, DoublingGrowth>("x2");
+  RunLarge<Tag<5>, HalfGrowth>("x1.5");
+  return 0;
+}
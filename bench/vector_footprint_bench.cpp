@@ -0,0 +1,79 @@
+// Footprint benchmark for tiny vectors: builds 1Mi vectors of 1 to 4 ints,
+// as an index with many short posting lists does, and reports the memory the
+// pool took from the system for their elements. Growth from empty allocates
+// the minimum capacity of 16 elements for each of them; without a minimum,
+// with exact construction, reserve or shrink_to_fit every vector only keeps
+// the block its elements need.
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+
+#include "bench_util.h"
+#include "memory_pool_allocator.h"
+#include "vector.h"
+
+using namespace easystl;
+
+namespace {
+constexpr int kVectors = 1 << 20;
+
+template <class Tag> using Pool = TaggedPoolAllocator<Tag>;
+
+auto Length(const int i) -> int { return 1 + i % 4; }
+
+template <class Tag, class Growth, class Build>
+auto Run(const char *label, Build &&build) -> void {
+  using Vector = vector<int, Pool<Tag>, Growth>;
+  std::vector<Vector> vectors(kVectors);
+  const double ns = bench::MeasureNs([&] {
+    for (int i = 0; i < kVectors; ++i) {
+      build(vectors[static_cast<std::size_t>(i)], Length(i));
+    }
+  });
+  bench::Report(label, kVectors, ns, kVectors);
+  const std::size_t footprint = Pool<Tag>::Footprint();
+  std::printf("%-28s %8s %12zu KiB footprint %8.1f bytes/vector\n", "", "",
+              footprint / 1024, static_cast<double>(footprint) / kVectors);
+}
+
+template <int N> struct Tag {};
+
+struct PushBack {
+  template <class Vector> auto operator()(Vector &v, const int length) const {
+    for (int j = 0; j < length; ++j) {
+      v.push_back(j);
+    }
+  }
+};
+
+struct PushBackShrink {
+  template <class Vector> auto operator()(Vector &v, const int length) const {
+    PushBack()(v, length);
+    v.shrink_to_fit();
+  }
+};
+
+struct ReservePushBack {
+  template <class Vector> auto operator()(Vector &v, const int length) const {
+    v.reserve(static_cast<std::size_t>(length));
+    PushBack()(v, length);
+  }
+};
+
+struct ConstructExact {
+  template <class Vector> auto operator()(Vector &v, const int length) const {
+    const int values[] = {0, 1, 2, 3};
+    v = Vector(values, values + length);
+  }
+};
+} // namespace
+
+auto main() -> int {
+  std::printf("%-28s %8s   (1 to 4 ints each)\n", "variant", "vectors");
+  Run<Tag<0>, DefaultGrowth>("push_back", PushBack());
+  Run<Tag<1>, CompactGrowth>("push_back, CompactGrowth", PushBack());
+  Run<Tag<2>, DefaultGrowth>("push_back + shrink_to_fit", PushBackShrink());
+  Run<Tag<3>, DefaultGrowth>("reserve + push_back", ReservePushBack());
+  Run<Tag<4>, DefaultGrowth>("exact construction", ConstructExact());
+  return 0;
+}
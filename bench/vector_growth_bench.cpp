@@ -0,0 +1,61 @@
+// Vector growth benchmark: appends heap-allocated strings to an empty
+// vector<std::string>, so every growth relocates all strings appended so far.
+// "copy growth" wraps the string in a type whose move constructor may throw,
+// which makes growth copy every payload; "move growth" uses std::string, whose
+// noexcept move lets growth just hand the buffers over. push_back of an rvalue
+// also moves the appended string instead of copying it.
+#include <string>
+#include <utility>
+
+#include "bench_util.h"
+#include "vector.h"
+
+using namespace easystl;
+
+namespace {
+constexpr int kStrings = 1 << 18;
+constexpr int kRounds = 8;
+constexpr std::size_t kLength = 64;
+
+// A string whose move constructor may throw, as a type without a noexcept
+// move would be.
+struct CopiedString {
+  CopiedString(std::string &&newtext) : text(std::move(newtext)) {}
+  CopiedString(const CopiedString &) = default;
+  CopiedString(CopiedString &&other) noexcept(false)
+      : text(std::move(other.text)) {}
+
+  std::string text;
+};
+
+template <class T, class Append>
+auto Run(const char *label, Append &&append) -> void {
+  std::size_t total = 0;
+  const double ns = bench::MeasureNs([&] {
+    for (int round = 0; round < kRounds; ++round) {
+      vector<T> strings;
+      for (int i = 0; i < kStrings; ++i) {
+        append(strings, std::string(kLength, static_cast<char>('a' + i % 26)));
+      }
+      total += strings.size();
+    }
+  });
+  bench::Report(label, kStrings, ns, static_cast<double>(total));
+}
+} // namespace
+
+auto main() -> int {
+  std::printf("%-28s %8s   (strings of %zu bytes)\n", "variant", "strings",
+              kLength);
+  Run<CopiedString>("copy growth, rvalue", [](auto &strings, auto &&text) {
+    strings.push_back(CopiedString(std::move(text)));
+  });
+  Run<std::string>("move growth, lvalue", [](auto &strings, auto &&text) {
+    const std::string &lvalue = text;
+    strings.push_back(lvalue);
+  });
+  Run<std::string>("move growth, rvalue", [](auto &strings, auto &&text) {
+    strings.push_back(std::move(text));
+  });
+  return 0;
+}
@@ -3,6 +3,8 @@
 #ifndef EASYSTL_ALGO_H
 #define EASYSTL_ALGO_H
 
+#include <utility>
+
 namespace easystl {
 /**
  * @brief Returns the maximum of two values.
@@ -53,6 +55,44 @@ auto CopyBackward(BidirectionalIterator1 first, BidirectionalIterator1 last,
   return result;
 }
 
+/**
+ * @brief Moves elements from one range to another.
+ * @tparam InputIterator The type of the input iterator.
+ * @tparam OutputIterator The type of the output iterator.
+ * @param first The beginning of the range to move from.
+ * @param last The end of the range to move from.
+ * @param result The beginning of the range to move to.
+ * @return The iterator to the end of the destination range.
+ */
+template <typename InputIterator, typename OutputIterator>
+auto Move(InputIterator first, InputIterator last,
+          OutputIterator result) noexcept -> OutputIterator {
+  while (first != last) {
+    *result = std::move(*first);
+    ++result;
+    ++first;
+  }
+  return result;
+}
+
+/**
+ * @brief Moves elements from one range to another in reverse.
+ * @tparam BidirectionalIterator1 The type of the input iterator.
+ * @tparam BidirectionalIterator2 The type of the output iterator.
+ * @param first The beginning of the range to move from.
+ * @param last The end of the range to move from.
+ * @param result The iterator to the end of the destination range.
+ * @return The iterator to the beginning of the destination range.
+ */
+template <typename BidirectionalIterator1, typename BidirectionalIterator2>
+auto MoveBackward(BidirectionalIterator1 first, BidirectionalIterator1 last,
+                  BidirectionalIterator2 result) -> BidirectionalIterator2 {
+  while (first != last) {
+    *(--result) = std::move(*(--last));
+  }
+  return result;
+}
+
 /**
  * @brief Fills a range with a specified value.
  * @tparam ForwardIterator The type of the forward iterator.
@@ -77,9 +117,9 @@ auto Fill(ForwardIterator first, ForwardIterator last, const T &value) noexcept
  * @param b Second value.
  */
 template <typename T> auto Swap(T &a, T &b) noexcept -> void {
-  T temp = a;
-  a = b;
-  b = temp;
+  T temp = std::move(a);
+  a = std::move(b);
+  b = std::move(temp);
 }
 } // namespace easystl
 
@@ -0,0 +1,377 @@
+#pragma once
+
+#ifndef EASYSTL_ALLOCATION_SAMPLER_H_
+#define EASYSTL_ALLOCATION_SAMPLER_H_
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if __has_include(<execinfo.h>)
+#include <execinfo.h>
+#define EASYSTL_HAS_BACKTRACE 1
+#endif
+#if __has_include(<cxxabi.h>)
+#include <cxxabi.h>
+#define EASYSTL_HAS_DEMANGLE 1
+#endif
+
+// Allocation sampling is opt-in. Define `EASYSTL_ENABLE_ALLOCATION_SAMPLING`
+// for the whole program to sample the allocations of every AllocatorWrapper
+// whose allocator does not set `kSampled` itself. Without it the wrapper's
+// allocation paths are unchanged.
+#ifdef EASYSTL_ENABLE_ALLOCATION_SAMPLING
+#define EASYSTL_ALLOCATION_SAMPLING_DEFAULT true
+#else
+#define EASYSTL_ALLOCATION_SAMPLING_DEFAULT false
+#endif
+
+namespace easystl {
+/**
+ * @class AllocationSampler
+ * @brief A heap profiler attributing live memory to call sites.
+ *
+ * Allocations are sampled by bytes, as in tcmalloc: every thread counts down
+ * an exponentially distributed number of bytes (mean SampleRate) and the
+ * allocation that crosses zero is sampled, so on average one sample is taken
+ * per SampleRate bytes and large allocations are likelier to be picked. Only
+ * sampled allocations pay for a stack trace (`backtrace`) and a table entry;
+ * the others cost a thread-local subtraction, and a deallocation a lookup in a
+ * small counting filter of sampled addresses.
+ *
+ * WriteHeapProfile dumps the live samples in the legacy gperftools heap
+ * format that `pprof` reads (it scales the samples back up itself);
+ * WriteFolded dumps estimated bytes per stack for flame graphs. Stacks are
+ * symbolized from the dynamic symbol table, so link with `-rdynamic`.
+ */
+class AllocationSampler {
+public:
+  static constexpr std::size_t kDefaultSampleRate =
+      512 * 1024; ///< Mean bytes between samples by default.
+  static constexpr int kMaxFrames = 32; ///< Deepest stack recorded.
+
+  /**
+   * @brief Sets the mean number of bytes between two samples.
+   * @param bytes The new rate, or 0 to stop sampling. Threads notice a rate
+   * change at their next sample, or within 1 MiB after sampling was off.
+   * @return The previous rate.
+   */
+  static auto SetSampleRate(const std::size_t bytes) -> std::size_t {
+    return rate_.exchange(bytes, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Returns the mean number of bytes between two samples.
+   * @return The rate, 0 if sampling is off.
+   */
+  static auto SampleRate() -> std::size_t {
+    return rate_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Counts an allocation against this thread's sampling interval.
+   * @param size The size of the allocation.
+   * @return `true` if the allocation must be recorded with RecordAllocation.
+   */
+  static auto ShouldSample(const std::size_t size) -> bool {
+    remaining_ -= static_cast<std::int64_t>(size);
+    if (remaining_ > 0) [[likely]] {
+      return false;
+    }
+    return SampleSlow();
+  }
+
+  /**
+   * @brief Records a sampled allocation with the current stack.
+   * @param ptr The allocated memory.
+   * @param size The size of the allocation.
+   */
+  [[gnu::noinline]] static auto RecordAllocation(void *ptr,
+                                                 const std::size_t size)
+      -> void {
+    if (ptr == nullptr) {
+      return;
+    }
+    Sample sample;
+    sample.size = size;
+    sample.rate = SampleRate();
+#ifdef EASYSTL_HAS_BACKTRACE
+    void *frames[kMaxFrames + 1];
+    const int depth = backtrace(frames, kMaxFrames + 1);
+    // Drop this function's own frame.
+    sample.depth = depth > 0 ? depth - 1 : 0;
+    std::memcpy(sample.frames, frames + 1,
+                static_cast<std::size_t>(sample.depth) * sizeof(void *));
+#endif
+    const std::lock_guard<std::mutex> lock(mutex_);
+    if (Live().insert_or_assign(ptr, sample).second) {
+      filter_[Slot(ptr)].fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * @brief Forgets a deallocated block if it was sampled.
+   * @param ptr The memory being deallocated.
+   */
+  static auto RecordDeallocation(void *ptr) -> void {
+    if (filter_[Slot(ptr)].load(std::memory_order_relaxed) == 0) [[likely]] {
+      return;
+    }
+    ForgetSlow(ptr);
+  }
+
+  /**
+   * @brief Returns the number of sampled allocations still alive.
+   * @return The number of live samples.
+   */
+  static auto LiveSamples() -> std::size_t {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    return Live().size();
+  }
+
+  /**
+   * @brief Writes the live samples as a legacy heap profile for `pprof`:
+   * a `heap_v2/<rate>` header, one line per stack and the memory map.
+   * @param out The stream to write to.
+   */
+  static auto WriteHeapProfile(std::FILE *out) -> void {
+    const std::map<std::vector<void *>, Totals> stacks = Aggregate();
+    Totals total;
+    for (const auto &[stack, totals] : stacks) {
+      total.count += totals.count;
+      total.bytes += totals.bytes;
+    }
+    std::fprintf(out, "heap profile: %zu: %zu [ %zu: %zu] @ heap_v2/%zu\n",
+                 total.count, total.bytes, total.count, total.bytes,
+                 SampleRate());
+    for (const auto &[stack, totals] : stacks) {
+      std::fprintf(out, "%zu: %zu [ %zu: %zu] @", totals.count, totals.bytes,
+                   totals.count, totals.bytes);
+      for (void *frame : stack) {
+        std::fprintf(out, " %p", frame);
+      }
+      std::fputc('\n', out);
+    }
+    std::fputs("\nMAPPED_LIBRARIES:\n", out);
+    if (std::FILE *maps = std::fopen("/proc/self/maps", "r")) {
+      char buffer[4096];
+      std::size_t n;
+      while ((n = std::fread(buffer, 1, sizeof(buffer), maps)) != 0) {
+        std::fwrite(buffer, 1, n, out);
+      }
+      std::fclose(maps);
+    }
+  }
+
+  /**
+   * @brief Writes the live samples as folded stacks: one line per stack with
+   * its frames from the outermost call to the allocation, separated by `;`,
+   * then the estimated live bytes.
+   * @param out The stream to write to.
+   */
+  static auto WriteFolded(std::FILE *out) -> void {
+    // Different call sites in one function fold into the same line.
+    std::map<std::string, double> lines;
+    for (const auto &[stack, totals] : Aggregate()) {
+      std::string line;
+      for (std::size_t i = stack.size(); i-- > 0;) {
+        line += Symbolize(stack[i]);
+        if (i != 0) {
+          line += ';';
+        }
+      }
+      lines[line.empty() ? "[unknown]" : line] += totals.estimate;
+    }
+    for (const auto &[line, bytes] : lines) {
+      std::fprintf(out, "%s %.0f\n", line.c_str(), bytes);
+    }
+  }
+
+private:
+  static constexpr int kFilterBits = 15; ///< log2 of the filter size.
+  static constexpr std::int64_t kDisabledRecheck =
+      1 << 20; ///< Bytes between rate checks while sampling is off.
+
+  /**
+   * @struct Sample
+   * @brief A live sampled allocation.
+   */
+  struct Sample {
+    std::size_t size = 0;      ///< Requested bytes.
+    std::size_t rate = 0;      ///< Sample rate when it was taken.
+    int depth = 0;             ///< Number of frames.
+    void *frames[kMaxFrames]{}; ///< Return addresses, innermost first.
+  };
+
+  /**
+   * @struct Totals
+   * @brief Samples aggregated by stack.
+   */
+  struct Totals {
+    std::size_t count = 0; ///< Sampled allocations.
+    std::size_t bytes = 0; ///< Sampled bytes.
+    double estimate = 0;   ///< Estimated bytes of all allocations.
+  };
+
+  /**
+   * @brief Decides about the allocation that crossed the sampling interval
+   * and draws the next one.
+   * @return `true` if the allocation is sampled.
+   */
+  static auto SampleSlow() -> bool {
+    const std::size_t rate = SampleRate();
+    if (rate == 0) {
+      remaining_ = kDisabledRecheck;
+      return false;
+    }
+    if (rng_ == 0) {
+      // First sample decision of this thread: start a random interval.
+      int local = 0;
+      rng_ = (reinterpret_cast<std::uintptr_t>(&local) ^
+              static_cast<std::uint64_t>(std::chrono::steady_clock::now()
+                                             .time_since_epoch()
+                                             .count())) |
+             1;
+      remaining_ += NextInterval(rate);
+      if (remaining_ > 0) {
+        return false;
+      }
+    }
+    remaining_ = NextInterval(rate);
+    return true;
+  }
+
+  /**
+   * @brief Draws an exponentially distributed interval.
+   * @param rate The mean of the distribution.
+   * @return The interval in bytes, at least 1.
+   */
+  static auto NextInterval(const std::size_t rate) -> std::int64_t {
+    // xorshift64, then the top 53 bits as a uniform value in (0, 1].
+    rng_ ^= rng_ << 13;
+    rng_ ^= rng_ >> 7;
+    rng_ ^= rng_ << 17;
+    const double uniform =
+        static_cast<double>((rng_ >> 11) + 1) * 0x1.0p-53;
+    const double interval = -std::log(uniform) * static_cast<double>(rate);
+    return interval < 1 ? 1 : static_cast<std::int64_t>(interval);
+  }
+
+  /**
+   * @brief Removes a block from the live samples if it is there.
+   * @param ptr The memory being deallocated.
+   */
+  static auto ForgetSlow(void *ptr) -> void {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    if (Live().erase(ptr) != 0) {
+      filter_[Slot(ptr)].fetch_sub(1, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * @brief Maps an address to its counter in the filter.
+   * @param ptr The address.
+   * @return The index of the counter.
+   */
+  static auto Slot(const void *ptr) -> std::size_t {
+    const auto addr = static_cast<std::uint64_t>(
+        reinterpret_cast<std::uintptr_t>(ptr));
+    return static_cast<std::size_t>((addr * 0x9e3779b97f4a7c15ULL) >>
+                                    (64 - kFilterBits));
+  }
+
+  /**
+   * @brief Groups the live samples by stack.
+   * @return The totals of every stack.
+   */
+  static auto Aggregate() -> std::map<std::vector<void *>, Totals> {
+    std::map<std::vector<void *>, Totals> stacks;
+    const std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto &[ptr, sample] : Live()) {
+      Totals &totals = stacks[std::vector<void *>(
+          sample.frames, sample.frames + sample.depth)];
+      ++totals.count;
+      totals.bytes += sample.size;
+      // An allocation of `size` bytes is sampled with probability
+      // 1 - exp(-size / rate); weight it by the inverse.
+      const double size = static_cast<double>(sample.size);
+      const double rate = static_cast<double>(sample.rate);
+      const double probability =
+          sample.size == 0 ? 1.0 : 1.0 - std::exp(-size / rate);
+      totals.estimate += size / (probability > 0 ? probability : 1.0);
+    }
+    return stacks;
+  }
+
+  /**
+   * @brief Names the function containing a return address.
+   * @param frame The return address.
+   * @return The demangled function name, or the address in hex.
+   */
+  static auto Symbolize(void *frame) -> std::string {
+    char address[2 + 2 * sizeof(void *) + 1];
+    std::snprintf(address, sizeof(address), "%p", frame);
+    std::string name;
+#ifdef EASYSTL_HAS_BACKTRACE
+    if (char **symbols = backtrace_symbols(&frame, 1)) {
+      // glibc writes "object(function+offset) [address]".
+      const char *begin = std::strchr(symbols[0], '(');
+      const char *end = begin == nullptr ? nullptr : std::strchr(begin, '+');
+      if (begin != nullptr && end != nullptr && end > begin + 1) {
+        name.assign(begin + 1, end);
+      }
+      std::free(symbols);
+    }
+#endif
+#ifdef EASYSTL_HAS_DEMANGLE
+    if (!name.empty()) {
+      int status = 0;
+      if (char *demangled =
+              abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status)) {
+        name = demangled;
+        std::free(demangled);
+      }
+    }
+#endif
+    return name.empty() ? std::string(address) : name;
+  }
+
+  /**
+   * @brief The live samples by address. Never destroyed, so blocks freed by
+   * static destructors can still be looked up.
+   * @return The table.
+   */
+  static auto Live() -> std::unordered_map<void *, Sample> & {
+    static auto *live = new std::unordered_map<void *, Sample>();
+    return *live;
+  }
+
+  static std::atomic<std::size_t> rate_; ///< Mean bytes between samples.
+  static std::mutex mutex_;              ///< Guards the live samples.
+  static std::atomic<std::uint16_t>
+      filter_[std::size_t{1} << kFilterBits]; ///< Live samples per slot.
+  static thread_local std::int64_t
+      remaining_; ///< Bytes until this thread's next sample.
+  static thread_local std::uint64_t rng_; ///< This thread's random state.
+};
+
+inline std::atomic<std::size_t> AllocationSampler::rate_{
+    AllocationSampler::kDefaultSampleRate};
+inline std::mutex AllocationSampler::mutex_;
+inline std::atomic<std::uint16_t>
+    AllocationSampler::filter_[std::size_t{1} << kFilterBits];
+inline thread_local std::int64_t AllocationSampler::remaining_ = 0;
+inline thread_local std::uint64_t AllocationSampler::rng_ = 0;
+} // namespace easystl
+
+#endif // !EASYSTL_ALLOCATION_SAMPLER_H_
@@ -0,0 +1,817 @@
+#pragma once
+
+#ifndef EASYSTL_ALLOCATOR_POLICY_H_
+#define EASYSTL_ALLOCATOR_POLICY_H_
+
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "allocation_sampler.h"
+#include "allocator_stats.h"
+#include "memory_pool_allocator.h"
+
+namespace easystl {
+/**
+ * @concept AllocatorConcept
+ * @brief What AllocatorWrapper and the adapters below need from an allocator:
+ * `Allocate(size)` returning the memory (or `nullptr`) and a sized
+ * `Deallocate(ptr, size)`, as static or member functions.
+ */
+template <class A>
+concept AllocatorConcept =
+    requires(A &allocator, void *ptr, const std::size_t size) {
+      { allocator.Allocate(size) } -> std::convertible_to<void *>;
+      allocator.Deallocate(ptr, size);
+    };
+
+/**
+ * @concept StaticAllocator
+ * @brief An allocator without per-instance state, used through static
+ * functions. The adapters compose only these, so a composed allocator is
+ * stateless too and every call is resolved at compile time.
+ */
+template <class A>
+concept StaticAllocator =
+    AllocatorConcept<A> && std::is_empty_v<A> &&
+    requires(void *ptr, const std::size_t size) {
+      { A::Allocate(size) } -> std::convertible_to<void *>;
+      A::Deallocate(ptr, size);
+    };
+
+/**
+ * @concept ReallocatingAllocator
+ * @brief An allocator that can resize blocks with
+ * `Reallocate(ptr, oldsize, newsize)`, leaving the block untouched when it
+ * returns `nullptr`.
+ */
+template <class A>
+concept ReallocatingAllocator =
+    AllocatorConcept<A> &&
+    requires(A &allocator, void *ptr, const std::size_t size) {
+      { allocator.Reallocate(ptr, size, size) } -> std::convertible_to<void *>;
+    };
+
+/**
+ * @concept AlignedAllocator
+ * @brief An allocator that takes an alignment: `Allocate(size, align)` and
+ * `Deallocate(ptr, size, align)`.
+ */
+template <class A>
+concept AlignedAllocator =
+    AllocatorConcept<A> &&
+    requires(A &allocator, void *ptr, const std::size_t size) {
+      { allocator.Allocate(size, size) } -> std::convertible_to<void *>;
+      allocator.Deallocate(ptr, size, size);
+    };
+
+/**
+ * @concept OwningAllocator
+ * @brief An allocator that can tell its blocks apart with `Owns(ptr, size)`;
+ * FallbackAllocator needs it from its primary.
+ */
+template <class A>
+concept OwningAllocator =
+    AllocatorConcept<A> &&
+    requires(A &allocator, const void *ptr, const std::size_t size) {
+      { allocator.Owns(ptr, size) } -> std::convertible_to<bool>;
+    };
+
+/**
+ * @concept SizingAllocator
+ * @brief An allocator that reports with `GoodSize(size)` how many bytes the
+ * block serving a request really holds, so containers can size their
+ * capacity to it.
+ */
+template <class A>
+concept SizingAllocator =
+    AllocatorConcept<A> && requires(A &allocator, const std::size_t size) {
+      { allocator.GoodSize(size) } -> std::convertible_to<std::size_t>;
+    };
+
+/**
+ * @concept ReportingAllocator
+ * @brief An allocator that reports counters through `Stats()`.
+ */
+template <class A>
+concept ReportingAllocator = AllocatorConcept<A> && requires { A::Stats(); };
+
+/**
+ * @typedef DefaultAllocator
+ * @brief The allocator containers use unless told otherwise.
+ */
+using DefaultAllocator = MemoryPoolAllocator;
+
+/**
+ * @typedef Allo
+ * @brief The former name of DefaultAllocator.
+ */
+using Allo [[deprecated("use DefaultAllocator")]] = DefaultAllocator;
+
+/**
+ * @brief Moves a block between two allocators: allocates from `To`, copies
+ * the contents and frees the block to `From`.
+ * @tparam From The allocator the block came from.
+ * @tparam To The allocator the new block comes from.
+ * @param obj The block, or `nullptr`.
+ * @param oldsize The size of the block.
+ * @param newsize The size of the new block.
+ * @return The new block, or `nullptr` (then `obj` is left untouched).
+ */
+template <StaticAllocator From, StaticAllocator To>
+auto MoveBlock(void *obj, const std::size_t oldsize, const std::size_t newsize)
+    -> void * {
+  void *result = To::Allocate(newsize);
+  if (result != nullptr && obj != nullptr) {
+    std::memcpy(result, obj, oldsize < newsize ? oldsize : newsize);
+    From::Deallocate(obj, oldsize);
+  }
+  return result;
+}
+
+/**
+ * @class FixedBufferAllocator
+ * @brief Bump-allocates from a static buffer of `Bytes` and returns `nullptr`
+ * once it is full, which makes it the natural primary of a
+ * FallbackAllocator. Only the most recent block is given back on
+ * Deallocate. Safe to share between threads.
+ * @tparam Bytes The size of the buffer.
+ * @tparam Tag Distinguishes independent buffers.
+ */
+template <std::size_t Bytes, class Tag = void> class FixedBufferAllocator {
+public:
+  static constexpr std::size_t kAlign =
+      alignof(std::max_align_t); ///< Alignment of every block.
+
+  /**
+   * @brief Allocates memory from the buffer.
+   * @param size The size of the memory block to allocate.
+   * @return A pointer to the block, or `nullptr` if the buffer is full.
+   */
+  static auto Allocate(const std::size_t size) -> void * {
+    const std::size_t bytes = RoundUp(size);
+    std::size_t used = used_.load(std::memory_order_relaxed);
+    do {
+      if (Bytes - used < bytes) {
+        return nullptr;
+      }
+    } while (!used_.compare_exchange_weak(used, used + bytes,
+                                          std::memory_order_relaxed));
+    return buffer_ + used;
+  }
+
+  /**
+   * @brief Allocates memory of a specified alignment from the buffer,
+   * skipping to the next multiple of `align`.
+   * @param size The size of the memory block to allocate.
+   * @param align The alignment, a power of two.
+   * @return A pointer to the block, or `nullptr` if the buffer is full.
+   */
+  static auto Allocate(const std::size_t size, const std::size_t align)
+      -> void * {
+    if (align <= kAlign) {
+      return Allocate(size);
+    }
+    const std::size_t bytes = RoundUp(size);
+    const auto base = reinterpret_cast<std::uintptr_t>(buffer_);
+    std::size_t used = used_.load(std::memory_order_relaxed);
+    std::size_t start;
+    do {
+      start = ((base + used + align - 1) & ~(align - 1)) - base;
+      if (start > Bytes || Bytes - start < bytes) {
+        return nullptr;
+      }
+    } while (!used_.compare_exchange_weak(used, start + bytes,
+                                          std::memory_order_relaxed));
+    return buffer_ + start;
+  }
+
+  /**
+   * @brief Gives the block back if it is the most recent one.
+   * @param obj Pointer to the memory block to deallocate.
+   * @param size The size of the memory block.
+   */
+  static auto Deallocate(void *obj, const std::size_t size) -> void {
+    const std::size_t bytes = RoundUp(size);
+    std::size_t end =
+        static_cast<std::size_t>(static_cast<unsigned char *>(obj) - buffer_) +
+        bytes;
+    used_.compare_exchange_strong(end, end - bytes,
+                                  std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Gives an aligned block back if it is the most recent one; the
+   * padding in front of it stays used.
+   * @param obj Pointer to the memory block to deallocate.
+   * @param size The size of the memory block.
+   * @param{unnamed} The alignment the block was allocated with (unused).
+   */
+  static auto Deallocate(void *obj, const std::size_t size,
+                         std::size_t /*align*/) -> void {
+    Deallocate(obj, size);
+  }
+
+  /**
+   * @brief Checks whether a block lies in the buffer.
+   * @param obj Pointer to the memory block.
+   * @param{unnamed} The size of the memory block (unused).
+   * @return `true` if the block came from this allocator.
+   */
+  static auto Owns(const void *obj, std::size_t /*size*/) -> bool {
+    const auto *byte = static_cast<const unsigned char *>(obj);
+    return byte >= buffer_ && byte < buffer_ + Bytes;
+  }
+
+  /**
+   * @brief Gets the size of the block a request is served from.
+   * @param size The requested size.
+   * @return The size rounded up to kAlign.
+   */
+  static auto GoodSize(const std::size_t size) -> std::size_t {
+    return RoundUp(size);
+  }
+
+  /**
+   * @brief Returns the number of bytes handed out.
+   * @return The used part of the buffer.
+   */
+  static auto Used() -> std::size_t {
+    return used_.load(std::memory_order_relaxed);
+  }
+
+private:
+  static constexpr auto RoundUp(const std::size_t bytes) -> std::size_t {
+    return (bytes + kAlign - 1) & ~(kAlign - 1);
+  }
+
+  alignas(kAlign) static inline unsigned char buffer_[Bytes]; ///< The memory.
+  static inline std::atomic<std::size_t> used_{0}; ///< Bytes handed out.
+};
+
+/**
+ * @class FallbackAllocator
+ * @brief Serves requests from `Primary` and, when it returns `nullptr`, from
+ * `Fallback`. Blocks go back to the allocator that `Primary::Owns` says they
+ * came from.
+ * @tparam Primary The allocator tried first; must be an OwningAllocator.
+ * @tparam Fallback The allocator used when `Primary` is out of memory.
+ */
+template <StaticAllocator Primary, StaticAllocator Fallback>
+  requires OwningAllocator<Primary>
+class FallbackAllocator {
+public:
+  /**
+   * @brief Allocates from `Primary`, or from `Fallback` if that fails.
+   * @param size The size of the memory block to allocate.
+   * @return A pointer to the block, or `nullptr` if both failed.
+   */
+  static auto Allocate(const std::size_t size) -> void * {
+    if (void *result = Primary::Allocate(size)) {
+      return result;
+    }
+    return Fallback::Allocate(size);
+  }
+
+  /**
+   * @brief Gives a block back to the allocator it came from.
+   * @param obj Pointer to the memory block to deallocate.
+   * @param size The size of the memory block.
+   */
+  static auto Deallocate(void *obj, const std::size_t size) -> void {
+    if (Primary::Owns(obj, size)) {
+      Primary::Deallocate(obj, size);
+    } else {
+      Fallback::Deallocate(obj, size);
+    }
+  }
+
+  /**
+   * @brief Resizes a block in its allocator when it can, and moves it to
+   * `Fallback` when `Primary` cannot hold the new size.
+   * @param obj Pointer to the memory block to reallocate.
+   * @param oldsize The current size of the memory block.
+   * @param newsize The new size of the memory block.
+   * @return A pointer to the block, or `nullptr` (the old block is then left
+   * untouched).
+   */
+  static auto Reallocate(void *obj, const std::size_t oldsize,
+                         const std::size_t newsize) -> void * {
+    if (obj != nullptr && Primary::Owns(obj, oldsize)) {
+      if constexpr (ReallocatingAllocator<Primary>) {
+        if (void *result = Primary::Reallocate(obj, oldsize, newsize)) {
+          return result;
+        }
+      }
+      return MoveBlock<Primary, Fallback>(obj, oldsize, newsize);
+    }
+    if constexpr (ReallocatingAllocator<Fallback>) {
+      return Fallback::Reallocate(obj, oldsize, newsize);
+    } else {
+      return MoveBlock<Fallback, Fallback>(obj, oldsize, newsize);
+    }
+  }
+
+  /**
+   * @brief Allocates an aligned block from `Primary`, or from `Fallback` if
+   * that fails.
+   * @param size The size of the memory block to allocate.
+   * @param align The alignment, a power of two.
+   * @return A pointer to the block, or `nullptr` if both failed.
+   */
+  static auto Allocate(const std::size_t size, const std::size_t align)
+      -> void *
+    requires(AlignedAllocator<Primary> && AlignedAllocator<Fallback>)
+  {
+    if (void *result = Primary::Allocate(size, align)) {
+      return result;
+    }
+    return Fallback::Allocate(size, align);
+  }
+
+  /**
+   * @brief Gives an aligned block back to the allocator it came from.
+   * @param obj Pointer to the memory block to deallocate.
+   * @param size The size of the memory block.
+   * @param align The alignment the block was allocated with.
+   */
+  static auto Deallocate(void *obj, const std::size_t size,
+                         const std::size_t align) -> void
+    requires(AlignedAllocator<Primary> && AlignedAllocator<Fallback>)
+  {
+    if (Primary::Owns(obj, size)) {
+      Primary::Deallocate(obj, size, align);
+    } else {
+      Fallback::Deallocate(obj, size, align);
+    }
+  }
+
+  /**
+   * @brief Checks whether a block came from either allocator.
+   * @param obj Pointer to the memory block.
+   * @param size The size of the memory block.
+   * @return `true` if one of the allocators owns the block.
+   */
+  static auto Owns(const void *obj, const std::size_t size) -> bool
+    requires OwningAllocator<Fallback>
+  {
+    return Primary::Owns(obj, size) || Fallback::Owns(obj, size);
+  }
+
+  /**
+   * @brief Gets the usable size of a block from `Primary`, which serves
+   * requests whenever it can.
+   * @param size The requested size.
+   * @return The usable size, at least `size`.
+   */
+  static auto GoodSize(const std::size_t size) -> std::size_t
+    requires SizingAllocator<Primary>
+  {
+    return Primary::GoodSize(size);
+  }
+};
+
+/**
+ * @class Segregator
+ * @brief Sends requests of up to `Threshold` bytes to `Small` and larger ones
+ * to `Large`, deciding by the size alone (also on Deallocate), so the choice
+ * costs one comparison.
+ * @tparam Threshold The largest size served by `Small`.
+ * @tparam Small The allocator for small requests.
+ * @tparam Large The allocator for large requests.
+ */
+template <std::size_t Threshold, StaticAllocator Small, StaticAllocator Large>
+class Segregator {
+public:
+  /**
+   * @brief Allocates from the allocator responsible for the size.
+   * @param size The size of the memory block to allocate.
+   * @return A pointer to the block, or `nullptr`.
+   */
+  static auto Allocate(const std::size_t size) -> void * {
+    return size <= Threshold ? Small::Allocate(size) : Large::Allocate(size);
+  }
+
+  /**
+   * @brief Gives a block back to the allocator responsible for the size.
+   * @param obj Pointer to the memory block to deallocate.
+   * @param size The size of the memory block.
+   */
+  static auto Deallocate(void *obj, const std::size_t size) -> void {
+    if (size <= Threshold) {
+      Small::Deallocate(obj, size);
+    } else {
+      Large::Deallocate(obj, size);
+    }
+  }
+
+  /**
+   * @brief Resizes a block; it moves between the allocators when the new size
+   * falls on the other side of the threshold.
+   * @param obj Pointer to the memory block to reallocate.
+   * @param oldsize The current size of the memory block.
+   * @param newsize The new size of the memory block.
+   * @return A pointer to the block, or `nullptr` (the old block is then left
+   * untouched).
+   */
+  static auto Reallocate(void *obj, const std::size_t oldsize,
+                         const std::size_t newsize) -> void * {
+    if (oldsize <= Threshold) {
+      if (newsize <= Threshold) {
+        return ResizeIn<Small>(obj, oldsize, newsize);
+      }
+      return MoveBlock<Small, Large>(obj, oldsize, newsize);
+    }
+    if (newsize > Threshold) {
+      return ResizeIn<Large>(obj, oldsize, newsize);
+    }
+    return MoveBlock<Large, Small>(obj, oldsize, newsize);
+  }
+
+  /**
+   * @brief Allocates an aligned block from the allocator responsible for the
+   * size.
+   * @param size The size of the memory block to allocate.
+   * @param align The alignment, a power of two.
+   * @return A pointer to the block, or `nullptr`.
+   */
+  static auto Allocate(const std::size_t size, const std::size_t align)
+      -> void *
+    requires(AlignedAllocator<Small> && AlignedAllocator<Large>)
+  {
+    return size <= Threshold ? Small::Allocate(size, align)
+                             : Large::Allocate(size, align);
+  }
+
+  /**
+   * @brief Gives an aligned block back to the allocator responsible for the
+   * size.
+   * @param obj Pointer to the memory block to deallocate.
+   * @param size The size of the memory block.
+   * @param align The alignment the block was allocated with.
+   */
+  static auto Deallocate(void *obj, const std::size_t size,
+                         const std::size_t align) -> void
+    requires(AlignedAllocator<Small> && AlignedAllocator<Large>)
+  {
+    if (size <= Threshold) {
+      Small::Deallocate(obj, size, align);
+    } else {
+      Large::Deallocate(obj, size, align);
+    }
+  }
+
+  /**
+   * @brief Checks whether a block came from the allocator responsible for
+   * its size.
+   * @param obj Pointer to the memory block.
+   * @param size The size of the memory block.
+   * @return `true` if the block is owned.
+   */
+  static auto Owns(const void *obj, const std::size_t size) -> bool
+    requires(OwningAllocator<Small> && OwningAllocator<Large>)
+  {
+    return size <= Threshold ? Small::Owns(obj, size)
+                             : Large::Owns(obj, size);
+  }
+
+  /**
+   * @brief Gets the usable size of a block from the allocator responsible for
+   * the size, never crossing the threshold (a larger request would go to the
+   * other allocator).
+   * @param size The requested size.
+   * @return The usable size, at least `size`.
+   */
+  static auto GoodSize(const std::size_t size) -> std::size_t
+    requires(SizingAllocator<Small> || SizingAllocator<Large>)
+  {
+    if (size <= Threshold) {
+      if constexpr (SizingAllocator<Small>) {
+        const std::size_t good = Small::GoodSize(size);
+        return good <= Threshold ? good : size;
+      } else {
+        return size;
+      }
+    }
+    if constexpr (SizingAllocator<Large>) {
+      return Large::GoodSize(size);
+    } else {
+      return size;
+    }
+  }
+
+private:
+  template <class A>
+  static auto ResizeIn(void *obj, const std::size_t oldsize,
+                       const std::size_t newsize) -> void * {
+    if constexpr (ReallocatingAllocator<A>) {
+      return A::Reallocate(obj, oldsize, newsize);
+    } else {
+      return MoveBlock<A, A>(obj, oldsize, newsize);
+    }
+  }
+};
+
+/**
+ * @class StatsAllocator
+ * @brief Forwards to `Parent` and counts calls and bytes, including the live
+ * and peak byte counts, whatever the build's stats setting.
+ * @tparam Parent The allocator doing the work.
+ * @tparam Tag Distinguishes independent sets of counters.
+ */
+template <StaticAllocator Parent, class Tag = void> class StatsAllocator {
+public:
+  /**
+   * @brief Allocates from `Parent` and counts the request.
+   * @param size The size of the memory block to allocate.
+   * @return A pointer to the block, or `nullptr`.
+   */
+  static auto Allocate(const std::size_t size) -> void * {
+    void *result = Parent::Allocate(size);
+    if (result != nullptr) {
+      NoteAllocate(size);
+    }
+    return result;
+  }
+
+  /**
+   * @brief Counts the block and gives it back to `Parent`.
+   * @param obj Pointer to the memory block to deallocate.
+   * @param size The size of the memory block.
+   */
+  static auto Deallocate(void *obj, const std::size_t size) -> void {
+    NoteDeallocate(size);
+    Parent::Deallocate(obj, size);
+  }
+
+  /**
+   * @brief Resizes a block in `Parent` and counts the change.
+   * @param obj Pointer to the memory block to reallocate.
+   * @param oldsize The current size of the memory block.
+   * @param newsize The new size of the memory block.
+   * @return A pointer to the block, or `nullptr`.
+   */
+  static auto Reallocate(void *obj, const std::size_t oldsize,
+                         const std::size_t newsize) -> void *
+    requires ReallocatingAllocator<Parent>
+  {
+    // Counted up front: `oldsize` derives from `obj`, and using it once the
+    // block may have been freed trips GCC's -Wuse-after-free.
+    counters_.reallocations.fetch_add(1, std::memory_order_relaxed);
+    NoteLive(newsize, oldsize); // `oldsize` is 0 when `obj` is null.
+    void *result = Parent::Reallocate(obj, oldsize, newsize);
+    if (result == nullptr) {
+      counters_.reallocations.fetch_sub(1, std::memory_order_relaxed);
+      NoteLive(oldsize, newsize);
+    }
+    return result;
+  }
+
+  /**
+   * @brief Allocates an aligned block from `Parent` and counts the request.
+   * @param size The size of the memory block to allocate.
+   * @param align The alignment, a power of two.
+   * @return A pointer to the block, or `nullptr`.
+   */
+  static auto Allocate(const std::size_t size, const std::size_t align)
+      -> void *
+    requires AlignedAllocator<Parent>
+  {
+    void *result = Parent::Allocate(size, align);
+    if (result != nullptr) {
+      NoteAllocate(size);
+    }
+    return result;
+  }
+
+  /**
+   * @brief Counts an aligned block and gives it back to `Parent`.
+   * @param obj Pointer to the memory block to deallocate.
+   * @param size The size of the memory block.
+   * @param align The alignment the block was allocated with.
+   */
+  static auto Deallocate(void *obj, const std::size_t size,
+                         const std::size_t align) -> void
+    requires AlignedAllocator<Parent>
+  {
+    NoteDeallocate(size);
+    Parent::Deallocate(obj, size, align);
+  }
+
+  /**
+   * @brief Forwards to `Parent::Owns`.
+   * @param obj Pointer to the memory block.
+   * @param size The size of the memory block.
+   * @return `true` if `Parent` owns the block.
+   */
+  static auto Owns(const void *obj, const std::size_t size) -> bool
+    requires OwningAllocator<Parent>
+  {
+    return Parent::Owns(obj, size);
+  }
+
+  /**
+   * @brief Forwards to `Parent::GoodSize`.
+   * @param size The requested size.
+   * @return The usable size, at least `size`.
+   */
+  static auto GoodSize(const std::size_t size) -> std::size_t
+    requires SizingAllocator<Parent>
+  {
+    return Parent::GoodSize(size);
+  }
+
+  /**
+   * @brief Takes a snapshot of the counters.
+   * @return The current counter values.
+   */
+  static auto Stats() -> AllocationStats {
+    AllocationStats stats;
+    stats.allocations = counters_.allocations.load(std::memory_order_relaxed);
+    stats.deallocations =
+        counters_.deallocations.load(std::memory_order_relaxed);
+    stats.reallocations =
+        counters_.reallocations.load(std::memory_order_relaxed);
+    stats.allocatedbytes =
+        counters_.allocatedbytes.load(std::memory_order_relaxed);
+    stats.freedbytes = counters_.freedbytes.load(std::memory_order_relaxed);
+    stats.livebytes = counters_.livebytes.load(std::memory_order_relaxed);
+    stats.peakbytes = counters_.peakbytes.load(std::memory_order_relaxed);
+    return stats;
+  }
+
+private:
+  static auto NoteAllocate(const std::size_t size) -> void {
+    counters_.allocations.fetch_add(1, std::memory_order_relaxed);
+    counters_.allocatedbytes.fetch_add(size, std::memory_order_relaxed);
+    NoteLive(size, 0);
+  }
+
+  static auto NoteDeallocate(const std::size_t size) -> void {
+    counters_.deallocations.fetch_add(1, std::memory_order_relaxed);
+    counters_.freedbytes.fetch_add(size, std::memory_order_relaxed);
+    NoteLive(0, size);
+  }
+
+  static auto NoteLive(const std::size_t added, const std::size_t removed)
+      -> void {
+    const std::size_t live =
+        counters_.livebytes.fetch_add(added - removed,
+                                      std::memory_order_relaxed) +
+        added - removed;
+    std::size_t peak = counters_.peakbytes.load(std::memory_order_relaxed);
+    while (live > peak && !counters_.peakbytes.compare_exchange_weak(
+                              peak, live, std::memory_order_relaxed)) {
+    }
+  }
+
+  /**
+   * @struct Counters
+   * @brief Live counters behind Stats(); updated from any thread.
+   */
+  struct Counters {
+    std::atomic<std::size_t> allocations{0};
+    std::atomic<std::size_t> deallocations{0};
+    std::atomic<std::size_t> reallocations{0};
+    std::atomic<std::size_t> allocatedbytes{0};
+    std::atomic<std::size_t> freedbytes{0};
+    std::atomic<std::size_t> livebytes{0};
+    std::atomic<std::size_t> peakbytes{0};
+  };
+
+  static inline Counters counters_; ///< Counters behind Stats().
+};
+
+/**
+ * @struct SamplingTracer
+ * @brief The default tracer of TracingAllocator: feeds AllocationSampler.
+ */
+struct SamplingTracer {
+  static auto OnAllocate(void *ptr, const std::size_t size) -> void {
+    if (AllocationSampler::ShouldSample(size)) {
+      AllocationSampler::RecordAllocation(ptr, size);
+    }
+  }
+  static auto OnDeallocate(void *ptr, std::size_t /*size*/) -> void {
+    AllocationSampler::RecordDeallocation(ptr);
+  }
+};
+
+/**
+ * @class TracingAllocator
+ * @brief Forwards to `Parent` and reports every block to `Tracer`, whose
+ * static `OnAllocate(ptr, size)` runs after a successful allocation and
+ * `OnDeallocate(ptr, size)` before a block is freed.
+ * @tparam Parent The allocator doing the work.
+ * @tparam Tracer The hooks, SamplingTracer by default.
+ */
+template <StaticAllocator Parent, class Tracer = SamplingTracer>
+class TracingAllocator {
+public:
+  /**
+   * @brief Allocates from `Parent` and reports the block.
+   * @param size The size of the memory block to allocate.
+   * @return A pointer to the block, or `nullptr`.
+   */
+  static auto Allocate(const std::size_t size) -> void * {
+    void *result = Parent::Allocate(size);
+    if (result != nullptr) {
+      Tracer::OnAllocate(result, size);
+    }
+    return result;
+  }
+
+  /**
+   * @brief Reports the block and gives it back to `Parent`.
+   * @param obj Pointer to the memory block to deallocate.
+   * @param size The size of the memory block.
+   */
+  static auto Deallocate(void *obj, const std::size_t size) -> void {
+    Tracer::OnDeallocate(obj, size);
+    Parent::Deallocate(obj, size);
+  }
+
+  /**
+   * @brief Resizes a block in `Parent`, reporting it as freed and allocated
+   * again.
+   * @param obj Pointer to the memory block to reallocate.
+   * @param oldsize The current size of the memory block.
+   * @param newsize The new size of the memory block.
+   * @return A pointer to the block, or `nullptr`.
+   */
+  static auto Reallocate(void *obj, const std::size_t oldsize,
+                         const std::size_t newsize) -> void *
+    requires ReallocatingAllocator<Parent>
+  {
+    if (obj != nullptr) {
+      Tracer::OnDeallocate(obj, oldsize);
+    }
+    void *result = Parent::Reallocate(obj, oldsize, newsize);
+    if (result != nullptr) {
+      Tracer::OnAllocate(result, newsize);
+    } else if (obj != nullptr) {
+      Tracer::OnAllocate(obj, oldsize); // The old block is still there.
+    }
+    return result;
+  }
+
+  /**
+   * @brief Allocates an aligned block from `Parent` and reports it.
+   * @param size The size of the memory block to allocate.
+   * @param align The alignment, a power of two.
+   * @return A pointer to the block, or `nullptr`.
+   */
+  static auto Allocate(const std::size_t size, const std::size_t align)
+      -> void *
+    requires AlignedAllocator<Parent>
+  {
+    void *result = Parent::Allocate(size, align);
+    if (result != nullptr) {
+      Tracer::OnAllocate(result, size);
+    }
+    return result;
+  }
+
+  /**
+   * @brief Reports an aligned block and gives it back to `Parent`.
+   * @param obj Pointer to the memory block to deallocate.
+   * @param size The size of the memory block.
+   * @param align The alignment the block was allocated with.
+   */
+  static auto Deallocate(void *obj, const std::size_t size,
+                         const std::size_t align) -> void
+    requires AlignedAllocator<Parent>
+  {
+    Tracer::OnDeallocate(obj, size);
+    Parent::Deallocate(obj, size, align);
+  }
+
+  /**
+   * @brief Forwards to `Parent::Owns`.
+   * @param obj Pointer to the memory block.
+   * @param size The size of the memory block.
+   * @return `true` if `Parent` owns the block.
+   */
+  static auto Owns(const void *obj, const std::size_t size) -> bool
+    requires OwningAllocator<Parent>
+  {
+    return Parent::Owns(obj, size);
+  }
+
+  /**
+   * @brief Forwards to `Parent::GoodSize`.
+   * @param size The requested size.
+   * @return The usable size, at least `size`.
+   */
+  static auto GoodSize(const std::size_t size) -> std::size_t
+    requires SizingAllocator<Parent>
+  {
+    return Parent::GoodSize(size);
+  }
+};
+} // namespace easystl
+
+#endif // !EASYSTL_ALLOCATOR_POLICY_H_
@@ -0,0 +1,194 @@
+#pragma once
+
+#ifndef EASYSTL_ALLOCATOR_STATS_H_
+#define EASYSTL_ALLOCATOR_STATS_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+// Allocator statistics are opt-in. Define `EASYSTL_ENABLE_ALLOCATOR_STATS`
+// for the whole program to count MallocAllocator calls and to turn on the
+// counters of every pool whose traits keep the default `kStats`. Without it
+// no counter exists and the allocation paths are unchanged.
+#ifdef EASYSTL_ENABLE_ALLOCATOR_STATS
+#define EASYSTL_ALLOCATOR_STATS_DEFAULT true
+#else
+#define EASYSTL_ALLOCATOR_STATS_DEFAULT false
+#endif
+
+namespace easystl {
+/**
+ * @struct SizeClassStats
+ * @brief Counters of a single size class of a memory pool.
+ */
+struct SizeClassStats {
+  std::size_t size = 0;          ///< Block size of the class (in bytes).
+  std::size_t allocations = 0;   ///< Blocks handed out.
+  std::size_t deallocations = 0; ///< Blocks given back.
+  std::size_t refills = 0;       ///< Times new blocks were carved from chunks.
+  std::size_t cachedblocks = 0;  ///< Blocks sitting in the central free list.
+
+  ///< @brief Bytes sitting in the central free list.
+  [[nodiscard]] auto CachedBytes() const -> std::size_t {
+    return cachedblocks * size;
+  }
+};
+
+/**
+ * @struct PoolStats
+ * @brief A snapshot of the counters of a memory pool.
+ * @tparam N The number of size classes of the pool.
+ */
+template <std::size_t N> struct PoolStats {
+  std::array<SizeClassStats, N> classes{}; ///< Per size-class counters.
+  std::size_t chunks = 0;                  ///< Chunks currently held.
+  std::size_t systembytes = 0; ///< Bytes currently held in chunks.
+  std::size_t largeallocations = 0;   ///< Requests forwarded to malloc.
+  std::size_t largedeallocations = 0; ///< Frees forwarded to malloc.
+
+  /**
+   * @brief Formats the snapshot as a human-readable table.
+   * @return The formatted text.
+   */
+  [[nodiscard]] auto ToText() const -> std::string {
+    std::string result;
+    char line[160];
+    std::snprintf(line, sizeof(line), "%6s %8s %12s %12s %10s %12s %14s\n",
+                  "class", "size", "allocs", "frees", "refills", "cached",
+                  "cached bytes");
+    result += line;
+    for (std::size_t i = 0; i < N; ++i) {
+      const SizeClassStats &stats = classes[i];
+      std::snprintf(line, sizeof(line),
+                    "%6zu %8zu %12zu %12zu %10zu %12zu %14zu\n", i, stats.size,
+                    stats.allocations, stats.deallocations, stats.refills,
+                    stats.cachedblocks, stats.CachedBytes());
+      result += line;
+    }
+    std::snprintf(line, sizeof(line),
+                  "chunks: %zu, system bytes: %zu, large allocs: %zu, "
+                  "large frees: %zu\n",
+                  chunks, systembytes, largeallocations, largedeallocations);
+    result += line;
+    return result;
+  }
+
+  /**
+   * @brief Formats the snapshot as a JSON object.
+   * @return The formatted JSON.
+   */
+  [[nodiscard]] auto ToJson() const -> std::string {
+    std::string result;
+    char field[192];
+    std::snprintf(field, sizeof(field),
+                  "{\"chunks\":%zu,\"system_bytes\":%zu,"
+                  "\"large_allocations\":%zu,\"large_deallocations\":%zu,"
+                  "\"classes\":[",
+                  chunks, systembytes, largeallocations, largedeallocations);
+    result += field;
+    for (std::size_t i = 0; i < N; ++i) {
+      const SizeClassStats &stats = classes[i];
+      std::snprintf(field, sizeof(field),
+                    "%s{\"size\":%zu,\"allocations\":%zu,"
+                    "\"deallocations\":%zu,\"refills\":%zu,"
+                    "\"cached_blocks\":%zu,\"cached_bytes\":%zu}",
+                    i == 0 ? "" : ",", stats.size, stats.allocations,
+                    stats.deallocations, stats.refills, stats.cachedblocks,
+                    stats.CachedBytes());
+      result += field;
+    }
+    result += "]}";
+    return result;
+  }
+};
+
+/**
+ * @struct MallocStats
+ * @brief A snapshot of the counters of MallocAllocator.
+ */
+struct MallocStats {
+  std::size_t allocations = 0;    ///< Successful `Allocate` calls.
+  std::size_t deallocations = 0;  ///< `Deallocate` calls.
+  std::size_t reallocations = 0;  ///< Successful `Reallocate` calls.
+  std::size_t allocatedbytes = 0; ///< Bytes requested by `Allocate`.
+  std::size_t freedbytes = 0;     ///< Bytes passed to `Deallocate`.
+  std::size_t oomretries = 0;     ///< Times the OOM handler was invoked.
+
+  /**
+   * @brief Formats the snapshot as a human-readable line.
+   * @return The formatted text.
+   */
+  [[nodiscard]] auto ToText() const -> std::string {
+    char line[192];
+    std::snprintf(line, sizeof(line),
+                  "allocs: %zu, frees: %zu, reallocs: %zu, allocated bytes: "
+                  "%zu, freed bytes: %zu, oom retries: %zu\n",
+                  allocations, deallocations, reallocations, allocatedbytes,
+                  freedbytes, oomretries);
+    return line;
+  }
+
+  /**
+   * @brief Formats the snapshot as a JSON object.
+   * @return The formatted JSON.
+   */
+  [[nodiscard]] auto ToJson() const -> std::string {
+    char line[192];
+    std::snprintf(line, sizeof(line),
+                  "{\"allocations\":%zu,\"deallocations\":%zu,"
+                  "\"reallocations\":%zu,\"allocated_bytes\":%zu,"
+                  "\"freed_bytes\":%zu,\"oom_retries\":%zu}",
+                  allocations, deallocations, reallocations, allocatedbytes,
+                  freedbytes, oomretries);
+    return line;
+  }
+};
+
+/**
+ * @struct AllocationStats
+ * @brief A snapshot of the counters of a StatsAllocator.
+ */
+struct AllocationStats {
+  std::size_t allocations = 0;    ///< Successful `Allocate` calls.
+  std::size_t deallocations = 0;  ///< `Deallocate` calls.
+  std::size_t reallocations = 0;  ///< Successful `Reallocate` calls.
+  std::size_t allocatedbytes = 0; ///< Bytes requested by `Allocate`.
+  std::size_t freedbytes = 0;     ///< Bytes passed to `Deallocate`.
+  std::size_t livebytes = 0;      ///< Bytes allocated and not yet freed.
+  std::size_t peakbytes = 0;      ///< Highest `livebytes` seen.
+
+  /**
+   * @brief Formats the snapshot as a human-readable line.
+   * @return The formatted text.
+   */
+  [[nodiscard]] auto ToText() const -> std::string {
+    char line[224];
+    std::snprintf(line, sizeof(line),
+                  "allocs: %zu, frees: %zu, reallocs: %zu, allocated bytes: "
+                  "%zu, freed bytes: %zu, live bytes: %zu, peak bytes: %zu\n",
+                  allocations, deallocations, reallocations, allocatedbytes,
+                  freedbytes, livebytes, peakbytes);
+    return line;
+  }
+
+  /**
+   * @brief Formats the snapshot as a JSON object.
+   * @return The formatted JSON.
+   */
+  [[nodiscard]] auto ToJson() const -> std::string {
+    char line[224];
+    std::snprintf(line, sizeof(line),
+                  "{\"allocations\":%zu,\"deallocations\":%zu,"
+                  "\"reallocations\":%zu,\"allocated_bytes\":%zu,"
+                  "\"freed_bytes\":%zu,\"live_bytes\":%zu,"
+                  "\"peak_bytes\":%zu}",
+                  allocations, deallocations, reallocations, allocatedbytes,
+                  freedbytes, livebytes, peakbytes);
+    return line;
+  }
+};
+} // namespace easystl
+
+#endif // !EASYSTL_ALLOCATOR_STATS_H_
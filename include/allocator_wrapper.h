@@ -3,48 +3,180 @@
 #ifndef EASYSTL_ALLOCATOR_WRAPPER_H_
 #define EASYSTL_ALLOCATOR_WRAPPER_H_
 
-#include "memory_pool_allocator.h"
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <type_traits>
+
+#include "allocation_sampler.h"
+#include "allocator_policy.h"
 
 namespace easystl {
-// Switch between different allocators: MemoryPoolAllocator or MallocAllocator.
-// The preprocessor directive allows choosing the allocator based on
-// `USEMALLOC`.
-#define USEMALLOC
-#ifdef USEMALLOC
-using Allo = MemoryPoolAllocator; ///< Default to use MemoryPoolAllocator if
-                                  ///< `USEMALLOC` is defined.
-#else                             // !USEMALLOC
-#include "malloc_allocator.h"
-using Alloc =
-    MallocAllocator; ///< Use MallocAllocator if `USEMALLOC` is not defined.
-#endif // !USEMALLOC
+/**
+ * @struct AllocatorTraits
+ * @brief Describes how containers treat an allocator object.
+ *
+ * Allocators whose class is empty (every pool and MallocAllocator) are
+ * stateless: all instances are interchangeable and cost no storage. Any other
+ * allocator is stateful, its instances are compared with `==`, and the
+ * container stores and propagates a copy. A stateful allocator may declare
+ * `static constexpr bool` members with the names below to override the
+ * defaults: a copy-assigned container keeps its own allocator, while move
+ * assignment and swap carry the allocator along with the elements. Any
+ * allocator may set `kSampled` to opt in or out of allocation sampling.
+ * @tparam Allocator The allocator class.
+ */
+template <class Allocator> struct AllocatorTraits {
+  static constexpr bool kStateless =
+      std::is_empty_v<Allocator>; ///< No per-instance state.
+
+  static constexpr bool kPropagateOnCopyAssign = [] {
+    if constexpr (requires { bool{Allocator::kPropagateOnCopyAssign}; }) {
+      return Allocator::kPropagateOnCopyAssign;
+    } else {
+      return false;
+    }
+  }(); ///< Copy assignment adopts the source's allocator.
+
+  static constexpr bool kPropagateOnMoveAssign = [] {
+    if constexpr (requires { bool{Allocator::kPropagateOnMoveAssign}; }) {
+      return Allocator::kPropagateOnMoveAssign;
+    } else {
+      return true;
+    }
+  }(); ///< Move assignment adopts the source's allocator.
+
+  static constexpr bool kPropagateOnSwap = [] {
+    if constexpr (requires { bool{Allocator::kPropagateOnSwap}; }) {
+      return Allocator::kPropagateOnSwap;
+    } else {
+      return true;
+    }
+  }(); ///< Swap exchanges the allocators.
+
+  static constexpr bool kSampled = [] {
+    if constexpr (requires { bool{Allocator::kSampled}; }) {
+      return Allocator::kSampled;
+    } else {
+      return EASYSTL_ALLOCATION_SAMPLING_DEFAULT;
+    }
+  }(); ///< Allocations go through AllocationSampler.
+
+  /**
+   * @brief Checks whether memory from one allocator can be freed by another.
+   * @param lhs The first allocator.
+   * @param rhs The second allocator.
+   * @return `true` if the allocators are interchangeable.
+   */
+  static auto Equal(const Allocator &lhs, const Allocator &rhs) -> bool {
+    if constexpr (kStateless) {
+      return true;
+    } else {
+      return lhs == rhs;
+    }
+  }
+};
+
 /**
  * @class AllocatorWrapper
  * @brief A wrapper class that provides allocation and deallocation methods for
- * a specific type T. The default allocator used can be chosen based on th
- * definition of `USEMALLOC`
+ * a specific type T on top of any AllocatorConcept allocator, including those
+ * composed from the adapters in allocator_policy.h.
+ *
+ * Stateless allocators are used through static functions, so the wrapper
+ * takes no space (it derives from the allocator to get the empty-base
+ * optimization). For a stateful allocator the wrapper stores a copy and the
+ * functions become members that forward to it.
  * @tparam T The type of objects this allocator will manage.
  * @tparam Allocator The allocator class to use for memory management. (default
- * is `Alloc`)
+ * is `DefaultAllocator`)
  */
-template <class T, class Allocator = Allo> class AllocatorWrapper {
+template <class T, AllocatorConcept Allocator = DefaultAllocator>
+class AllocatorWrapper : private Allocator {
 public:
+  static constexpr bool kStateless =
+      AllocatorTraits<Allocator>::kStateless; ///< No allocator to store.
+  static constexpr bool kAligned =
+      AlignedAllocator<Allocator>; ///< The allocator takes an alignment.
+  static constexpr bool kPassAlign =
+      kAligned && alignof(T) > alignof(void *); ///< `T` is over-aligned.
+  static constexpr bool kSampled =
+      AllocatorTraits<Allocator>::kSampled; ///< Allocations are sampled.
+  static constexpr bool kReallocate =
+      ReallocatingAllocator<Allocator> &&
+      (!kPassAlign || requires(Allocator &allocator) {
+        allocator.Reallocate(nullptr, std::size_t{}, std::size_t{},
+                             std::size_t{});
+      }); ///< The allocator can resize blocks, see Reallocate.
+  static constexpr bool kGoodSize =
+      SizingAllocator<Allocator> &&
+      !kPassAlign; ///< The allocator reports usable sizes, see GoodSize.
+
+  static_assert(kAligned || alignof(T) <= alignof(std::max_align_t),
+                "over-aligned types need an allocator that takes an alignment "
+                "(Allocate(size, align) and Deallocate(ptr, size, align))");
+
+  AllocatorWrapper() = default;
+  /**
+   * @brief Wraps a copy of an allocator object.
+   * @param allocator The allocator to use.
+   */
+  explicit AllocatorWrapper(const Allocator &allocator)
+      : Allocator(allocator) {}
+
   /**
-   * @brief Allocates memory fot `n` objects of type `T`.
+   * @brief Returns the wrapped allocator object.
+   * @return Reference to the allocator.
+   */
+  auto GetAllocator() const -> const Allocator & { return *this; }
+  auto GetAllocator() -> Allocator & { return *this; }
+
+  /**
+   * @brief Allocates memory fot `n` objects of type `T`. Over-aligned types
+   * pass `alignof(T)` to allocators that accept an alignment.
    * @param n The number of objects to allocate memory for.
    * @return A pointer to the allocated memory, or nullptr if `n == 0`.
+   * @throws std::bad_alloc If the allocator returns `nullptr`, or if `n`
+   * objects would take more than `PTRDIFF_MAX` bytes.
    */
-  static auto Allocate(const std::size_t n) -> T * {
-    return n == 0 ? nullptr
-                  : static_cast<T *>(Allocator::Allocate(n * sizeof(T)));
+  static auto Allocate(const std::size_t n) -> T *
+    requires(kStateless)
+  {
+    if (n == 0) {
+      return nullptr;
+    }
+    if constexpr (kPassAlign) {
+      return Sampled(Checked(Allocator::Allocate(Bytes(n), alignof(T))), n);
+    } else {
+      return Sampled(Checked(Allocator::Allocate(Bytes(n))), n);
+    }
+  }
+  auto Allocate(const std::size_t n) -> T *
+    requires(!kStateless)
+  {
+    if (n == 0) {
+      return nullptr;
+    }
+    if constexpr (kPassAlign) {
+      return Sampled(Checked(GetAllocator().Allocate(Bytes(n), alignof(T))), n);
+    } else {
+      return Sampled(Checked(GetAllocator().Allocate(Bytes(n))), n);
+    }
   }
 
   /**
    * @brief Allocates memory for a single object of type `T`.
    * @return A pointer to the allocated memory.
    */
-  static auto Allocate() -> T * {
-    return static_cast<T *>(Allocator::Allocate(sizeof(T)));
+  static auto Allocate() -> T *
+    requires(kStateless)
+  {
+    return Allocate(1);
+  }
+  auto Allocate() -> T *
+    requires(!kStateless)
+  {
+    return Allocate(1);
   }
 
   /**
@@ -52,18 +184,179 @@ public:
    * @param ptr The pointer to the memory to deallocate.
    * @param n The number of objects to deallocate memory for.
    */
-  static auto Deallocate(T *ptr, std::size_t n) -> void {
-    if (n != 0) {
+  static auto Deallocate(T *ptr, std::size_t n) -> void
+    requires(kStateless)
+  {
+    if (n == 0) {
+      return;
+    }
+    if constexpr (kSampled) {
+      AllocationSampler::RecordDeallocation(ptr);
+    }
+    if constexpr (kPassAlign) {
+      Allocator::Deallocate(ptr, n * sizeof(T), alignof(T));
+    } else {
       Allocator::Deallocate(ptr, n * sizeof(T));
     }
   }
+  auto Deallocate(T *ptr, std::size_t n) -> void
+    requires(!kStateless)
+  {
+    if (n == 0) {
+      return;
+    }
+    if constexpr (kSampled) {
+      AllocationSampler::RecordDeallocation(ptr);
+    }
+    if constexpr (kPassAlign) {
+      GetAllocator().Deallocate(ptr, n * sizeof(T), alignof(T));
+    } else {
+      GetAllocator().Deallocate(ptr, n * sizeof(T));
+    }
+  }
+
+  /**
+   * @brief Gets how many objects of type `T` fit into the block that serves a
+   * request for `n` of them, so that a container can use the whole block.
+   * @param n The number of objects to allocate memory for.
+   * @return The number of objects that fit, at least `n`; `n` itself if the
+   * allocator does not report usable sizes.
+   * @throws std::bad_alloc If the allocator reports usable sizes and `n`
+   * objects would take more than `PTRDIFF_MAX` bytes.
+   */
+  static auto GoodSize(const std::size_t n) -> std::size_t
+    requires(kStateless)
+  {
+    if constexpr (kGoodSize) {
+      return n == 0 ? 0 : Allocator::GoodSize(Bytes(n)) / sizeof(T);
+    } else {
+      return n;
+    }
+  }
+  auto GoodSize(const std::size_t n) -> std::size_t
+    requires(!kStateless)
+  {
+    if constexpr (kGoodSize) {
+      return n == 0 ? 0 : GetAllocator().GoodSize(Bytes(n)) / sizeof(T);
+    } else {
+      return n;
+    }
+  }
+
+  /**
+   * @brief Resizes memory for `oldn` objects of type `T` to `newn` objects,
+   * keeping the bytes of the first `min(oldn, newn)` objects. Only meaningful
+   * for trivially relocatable `T` (see IsTriviallyRelocatable), since objects
+   * are moved bytewise.
+   * @param ptr The pointer to the memory to resize.
+   * @param oldn The number of objects the memory holds.
+   * @param newn The number of objects the memory should hold.
+   * @return A pointer to the resized memory.
+   * @throws std::bad_alloc If the allocator returns `nullptr` for `newn > 0`,
+   * or if `newn` objects would take more than `PTRDIFF_MAX` bytes; the old
+   * memory is then left untouched.
+   */
+  static auto Reallocate(T *ptr, std::size_t oldn, std::size_t newn) -> T *
+    requires(kStateless && kReallocate)
+  {
+    const std::size_t newbytes = Bytes(newn);
+    if constexpr (kSampled) {
+      AllocationSampler::RecordDeallocation(ptr);
+    }
+    if constexpr (kPassAlign) {
+      return Sampled(Checked(Allocator::Reallocate(ptr, oldn * sizeof(T),
+                                                   newbytes, alignof(T)),
+                             newn),
+                     newn);
+    } else {
+      return Sampled(
+          Checked(Allocator::Reallocate(ptr, oldn * sizeof(T), newbytes),
+                  newn),
+          newn);
+    }
+  }
+  auto Reallocate(T *ptr, std::size_t oldn, std::size_t newn) -> T *
+    requires(!kStateless && kReallocate)
+  {
+    const std::size_t newbytes = Bytes(newn);
+    if constexpr (kSampled) {
+      AllocationSampler::RecordDeallocation(ptr);
+    }
+    if constexpr (kPassAlign) {
+      return Sampled(Checked(GetAllocator().Reallocate(ptr, oldn * sizeof(T),
+                                                       newbytes, alignof(T)),
+                             newn),
+                     newn);
+    } else {
+      return Sampled(
+          Checked(GetAllocator().Reallocate(ptr, oldn * sizeof(T), newbytes),
+                  newn),
+          newn);
+    }
+  }
 
   /**
    * @brief Deallocates memory for a single object of type `T`/
    * @param ptr The pointer to the memory yo deallocate.
    */
-  static auto Deallocate(T *ptr) -> void {
-    Allocator::Deallocate(ptr, sizeof(T));
+  static auto Deallocate(T *ptr) -> void
+    requires(kStateless)
+  {
+    Deallocate(ptr, 1);
+  }
+  auto Deallocate(T *ptr) -> void
+    requires(!kStateless)
+  {
+    Deallocate(ptr, 1);
+  }
+
+private:
+  /**
+   * @brief Gets the size in bytes of `n` objects, refusing counts whose size
+   * overflows or exceeds what any object may take.
+   * @param n The number of objects.
+   * @return `n * sizeof(T)`.
+   * @throws std::bad_alloc If `n` objects would take more than `PTRDIFF_MAX`
+   * bytes.
+   */
+  static auto Bytes(const std::size_t n) -> std::size_t {
+    constexpr auto kMaxCount =
+        static_cast<std::size_t>(std::numeric_limits<std::ptrdiff_t>::max()) /
+        sizeof(T);
+    if (n > kMaxCount) {
+      throw std::bad_alloc();
+    }
+    return n * sizeof(T);
+  }
+
+  /**
+   * @brief Turns a failed allocation into `std::bad_alloc`, so containers
+   * never store a null buffer. Whether the raw allocator returned null at all
+   * is up to its OOM policy, see MallocAllocator::SetOomPolicy.
+   * @param memory The memory returned by the allocator.
+   * @param n The number of objects requested.
+   * @return `memory` as `T *`.
+   */
+  static auto Checked(void *memory, const std::size_t n = 1) -> T * {
+    if (memory == nullptr && n != 0) {
+      throw std::bad_alloc();
+    }
+    return static_cast<T *>(memory);
+  }
+
+  /**
+   * @brief Offers a new allocation to AllocationSampler when sampling is on.
+   * @param ptr The allocated memory.
+   * @param n The number of objects allocated.
+   * @return `ptr`.
+   */
+  static auto Sampled(T *ptr, const std::size_t n) -> T * {
+    if constexpr (kSampled) {
+      if (AllocationSampler::ShouldSample(n * sizeof(T))) {
+        AllocationSampler::RecordAllocation(ptr, n * sizeof(T));
+      }
+    }
+    return ptr;
   }
 };
 } // namespace easystl
@@ -0,0 +1,392 @@
+#pragma once
+
+#ifndef EASYSTL_ARENA_ALLOCATOR_H_
+#define EASYSTL_ARENA_ALLOCATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "malloc_allocator.h"
+
+namespace easystl {
+/**
+ * @class MonotonicArena
+ * @brief A bump-pointer arena. Allocation moves a pointer forward inside the
+ * current chunk; when the chunk is exhausted a new one, at least twice as
+ * large, is chained in front of it. Individual deallocations are no-ops
+ * (except for the most recent block, which is rolled back), and all memory is
+ * reclaimed at once by Release().
+ */
+class MonotonicArena {
+public:
+  static constexpr std::size_t kAlign =
+      alignof(std::max_align_t); ///< Alignment of every block.
+  static constexpr std::size_t kInitialSize =
+      4096; ///< Usable size of the first chunk.
+
+  MonotonicArena() noexcept = default;
+  MonotonicArena(const MonotonicArena &) = delete;
+  auto operator=(const MonotonicArena &) -> MonotonicArena & = delete;
+
+  ///< @brief Destructor, returns every chunk to the system.
+  ~MonotonicArena() noexcept {
+    FreeChunks(head_);
+    head_ = nullptr;
+  }
+
+  /**
+   * @brief Allocates memory of a specified size from the current chunk.
+   * @param size The size of the memory block to allocate.
+   * @return A pointer to the allocated memory block, or `nullptr` if a new
+   * chunk could not be obtained.
+   * @throws std::bad_alloc If no chunk could be obtained and the OOM policy
+   * of MallocAllocator says to throw.
+   */
+  auto Allocate(const std::size_t size) -> void * {
+    const std::size_t bytes = RoundUp(size);
+    if (static_cast<std::size_t>(end_ - current_) < bytes && !Grow(bytes)) {
+      return nullptr;
+    }
+    void *result = current_;
+    current_ += bytes;
+    return result;
+  }
+
+  /**
+   * @brief Allocates memory of a specified size and alignment, skipping to
+   * the next multiple of `align` in the current chunk.
+   * @param size The size of the memory block to allocate.
+   * @param align The alignment, a power of two.
+   * @return A pointer to the allocated memory block, or `nullptr` if a new
+   * chunk could not be obtained.
+   * @throws std::bad_alloc As Allocate(size).
+   */
+  auto Allocate(const std::size_t size, const std::size_t align) -> void * {
+    if (align <= kAlign) {
+      return Allocate(size);
+    }
+    const std::size_t bytes = RoundUp(size);
+    char *result = AlignUp(current_, align);
+    if (result > end_ || static_cast<std::size_t>(end_ - result) < bytes) {
+      // Chunks start at a multiple of kAlign, so this much always fits.
+      if (!Grow(bytes + align - kAlign)) {
+        return nullptr;
+      }
+      result = AlignUp(current_, align);
+    }
+    current_ = result + bytes;
+    return result;
+  }
+
+  /**
+   * @brief Deallocates a memory block. Only the most recently allocated
+   * block is actually reclaimed; everything else waits for Release().
+   * @param obj Pointer to the memory block to deallocate.
+   * @param size The size of the memory block.
+   */
+  auto Deallocate(void *obj, const std::size_t size) noexcept -> void {
+    if (static_cast<char *>(obj) + RoundUp(size) == current_) {
+      current_ = static_cast<char *>(obj);
+    }
+  }
+
+  /**
+   * @brief Deallocates an aligned memory block; see Deallocate. The padding
+   * in front of the block is only reclaimed by Release().
+   * @param obj Pointer to the memory block to deallocate.
+   * @param size The size of the memory block.
+   * @param{unnamed} The alignment the block was allocated with (unused).
+   */
+  auto Deallocate(void *obj, const std::size_t size,
+                  std::size_t /*align*/) noexcept -> void {
+    Deallocate(obj, size);
+  }
+
+  /**
+   * @brief Reallocates a memory block, growing the most recent block in place
+   * when the chunk has room for it.
+   * @param obj Pointer to the memory block to reallocate.
+   * @param oldsize The current size of the memory block.
+   * @param newsize The new size of the memory block.
+   * @return A pointer to the reallocated memory block.
+   * @throws std::bad_alloc As Allocate(size).
+   */
+  auto Reallocate(void *obj, const std::size_t oldsize,
+                  const std::size_t newsize) -> void * {
+    auto *block = static_cast<char *>(obj);
+    if (block + RoundUp(oldsize) == current_ &&
+        static_cast<std::size_t>(end_ - block) >= RoundUp(newsize)) {
+      current_ = block + RoundUp(newsize);
+      return obj;
+    }
+    void *result = Allocate(newsize);
+    if (result != nullptr && obj != nullptr) {
+      std::memcpy(result, obj, oldsize < newsize ? oldsize : newsize);
+    }
+    return result;
+  }
+
+  /**
+   * @brief Frees everything allocated from the arena at once. The current
+   * (largest) chunk is kept and rewound, so an arena that is reused for
+   * similar workloads settles on a single chunk and Release() becomes a
+   * pointer reset.
+   */
+  auto Release() noexcept -> void {
+    if (head_ == nullptr) {
+      return;
+    }
+    FreeChunks(head_->next);
+    head_->next = nullptr;
+    current_ = reinterpret_cast<char *>(head_) + kHeaderSize;
+  }
+
+  /**
+   * @brief Returns the number of bytes consumed since the last Release(),
+   * counting the unused tails of older chunks as consumed.
+   * @return The used size of the arena in bytes.
+   */
+  [[nodiscard]] auto Used() const noexcept -> std::size_t {
+    std::size_t used = 0;
+    for (Chunk *chunk = head_; chunk != nullptr; chunk = chunk->next) {
+      const char *begin = reinterpret_cast<const char *>(chunk) + kHeaderSize;
+      used += chunk == head_ ? static_cast<std::size_t>(current_ - begin)
+                             : chunk->size - kHeaderSize;
+    }
+    return used;
+  }
+
+  /**
+   * @brief Returns the number of bytes held in chunks.
+   * @return The total size of all chunks in bytes.
+   */
+  [[nodiscard]] auto Capacity() const noexcept -> std::size_t {
+    std::size_t capacity = 0;
+    for (Chunk *chunk = head_; chunk != nullptr; chunk = chunk->next) {
+      capacity += chunk->size;
+    }
+    return capacity;
+  }
+
+private:
+  /**
+   * @struct Chunk
+   * @brief Header at the start of every chunk; chunks form a list with the
+   * current one at its head.
+   */
+  struct Chunk {
+    Chunk *next;      ///< The previously used chunk.
+    std::size_t size; ///< Size of the chunk including this header.
+  };
+
+  static constexpr auto RoundUp(const std::size_t bytes) -> std::size_t {
+    return (bytes + kAlign - 1) & ~(kAlign - 1);
+  }
+
+  static auto AlignUp(char *ptr, const std::size_t align) -> char * {
+    const auto address = reinterpret_cast<std::uintptr_t>(ptr);
+    return ptr + (((address + align - 1) & ~(align - 1)) - address);
+  }
+
+  static constexpr std::size_t kHeaderSize =
+      (sizeof(Chunk) + kAlign - 1) &
+      ~(kAlign - 1); ///< Bytes reserved for the chunk header.
+
+  /**
+   * @brief Chains in a new chunk with room for at least `bytes`.
+   * @param bytes The rounded size of the pending allocation.
+   * @return `true` on success, `false` if no memory could be obtained.
+   * @throws std::bad_alloc As Allocate(size).
+   */
+  auto Grow(const std::size_t bytes) -> bool {
+    std::size_t size = head_ == nullptr ? kInitialSize : head_->size * 2;
+    if (size < bytes + kHeaderSize) {
+      size = bytes + kHeaderSize;
+    }
+    auto *chunk = static_cast<Chunk *>(MallocAllocator::Allocate(size));
+    if (chunk == nullptr) {
+      return false;
+    }
+    chunk->next = head_;
+    chunk->size = size;
+    head_ = chunk;
+    current_ = reinterpret_cast<char *>(chunk) + kHeaderSize;
+    end_ = reinterpret_cast<char *>(chunk) + size;
+    return true;
+  }
+
+  static auto FreeChunks(Chunk *chunk) noexcept -> void {
+    while (chunk != nullptr) {
+      Chunk *next = chunk->next;
+      MallocAllocator::Deallocate(chunk, chunk->size);
+      chunk = next;
+    }
+  }
+
+  Chunk *head_ = nullptr;    ///< The current chunk.
+  char *current_ = nullptr;  ///< Next free byte of the current chunk.
+  char *end_ = nullptr;      ///< End of the current chunk.
+};
+
+/**
+ * @class ArenaAllocator
+ * @brief A static allocator policy that serves every request from a
+ * thread-local MonotonicArena, so it plugs into AllocatorWrapper and `vector`
+ * like MemoryPoolAllocator does. Call Release() when a unit of work (e.g. a
+ * request) is done to reclaim everything it allocated at once.
+ *
+ * Memory must be released on the thread that allocated it, and containers
+ * using the arena must not outlive the Release() call.
+ * @tparam Tag Distinguishes independent arenas.
+ */
+template <class Tag = void> class ArenaAllocator {
+public:
+  /**
+   * @brief Allocates memory of a specified size from the arena.
+   * @param size The size of the memory block to allocate.
+   * @return A pointer to the allocated memory block.
+   */
+  static auto Allocate(const std::size_t size) -> void * {
+    return Arena().Allocate(size);
+  }
+
+  /**
+   * @brief Allocates an aligned memory block from the arena.
+   * @param size The size of the memory block to allocate.
+   * @param align The alignment, a power of two.
+   * @return A pointer to the allocated memory block.
+   */
+  static auto Allocate(const std::size_t size, const std::size_t align)
+      -> void * {
+    return Arena().Allocate(size, align);
+  }
+
+  /**
+   * @brief Deallocates a memory block; see MonotonicArena::Deallocate.
+   * @param obj Pointer to the memory block to deallocate.
+   * @param size The size of the memory block.
+   */
+  static auto Deallocate(void *obj, const std::size_t size) -> void {
+    Arena().Deallocate(obj, size);
+  }
+
+  /**
+   * @brief Deallocates an aligned memory block; see
+   * MonotonicArena::Deallocate.
+   * @param obj Pointer to the memory block to deallocate.
+   * @param size The size of the memory block.
+   * @param align The alignment the block was allocated with.
+   */
+  static auto Deallocate(void *obj, const std::size_t size,
+                         const std::size_t align) -> void {
+    Arena().Deallocate(obj, size, align);
+  }
+
+  /**
+   * @brief Reallocates a memory block; see MonotonicArena::Reallocate.
+   * @param obj Pointer to the memory block to reallocate.
+   * @param oldsize The current size of the memory block.
+   * @param newsize The new size of the memory block.
+   * @return A pointer to the reallocated memory block.
+   */
+  static auto Reallocate(void *obj, const std::size_t oldsize,
+                         const std::size_t newsize) -> void * {
+    return Arena().Reallocate(obj, oldsize, newsize);
+  }
+
+  ///< @brief Frees everything allocated from this thread's arena.
+  static auto Release() -> void { Arena().Release(); }
+
+  /**
+   * @brief Returns the calling thread's arena.
+   * @return Reference to the thread-local arena.
+   */
+  static auto Arena() -> MonotonicArena & {
+    thread_local MonotonicArena arena;
+    return arena;
+  }
+};
+
+/**
+ * @class ArenaRef
+ * @brief A stateful allocator that refers to a caller-owned MonotonicArena, so
+ * independent arenas (e.g. one per tenant) can back different containers of
+ * the same type. Copies refer to the same arena and compare equal; the arena
+ * must outlive every container using it.
+ */
+class ArenaRef {
+public:
+  /**
+   * @brief Constructs a reference to an arena.
+   * @param arena The arena to allocate from.
+   */
+  explicit ArenaRef(MonotonicArena &arena) noexcept : arena_(&arena) {}
+
+  /**
+   * @brief Allocates memory of a specified size from the arena.
+   * @param size The size of the memory block to allocate.
+   * @return A pointer to the allocated memory block.
+   */
+  auto Allocate(const std::size_t size) const -> void * {
+    return arena_->Allocate(size);
+  }
+
+  /**
+   * @brief Allocates an aligned memory block from the arena.
+   * @param size The size of the memory block to allocate.
+   * @param align The alignment, a power of two.
+   * @return A pointer to the allocated memory block.
+   */
+  auto Allocate(const std::size_t size, const std::size_t align) const
+      -> void * {
+    return arena_->Allocate(size, align);
+  }
+
+  /**
+   * @brief Deallocates a memory block; see MonotonicArena::Deallocate.
+   * @param obj Pointer to the memory block to deallocate.
+   * @param size The size of the memory block.
+   */
+  auto Deallocate(void *obj, const std::size_t size) const -> void {
+    arena_->Deallocate(obj, size);
+  }
+
+  /**
+   * @brief Deallocates an aligned memory block; see
+   * MonotonicArena::Deallocate.
+   * @param obj Pointer to the memory block to deallocate.
+   * @param size The size of the memory block.
+   * @param align The alignment the block was allocated with.
+   */
+  auto Deallocate(void *obj, const std::size_t size,
+                  const std::size_t align) const -> void {
+    arena_->Deallocate(obj, size, align);
+  }
+
+  /**
+   * @brief Reallocates a memory block; see MonotonicArena::Reallocate.
+   * @param obj Pointer to the memory block to reallocate.
+   * @param oldsize The current size of the memory block.
+   * @param newsize The new size of the memory block.
+   * @return A pointer to the reallocated memory block.
+   */
+  auto Reallocate(void *obj, const std::size_t oldsize,
+                  const std::size_t newsize) const -> void * {
+    return arena_->Reallocate(obj, oldsize, newsize);
+  }
+
+  /**
+   * @brief Returns the referenced arena.
+   * @return Reference to the arena.
+   */
+  [[nodiscard]] auto Arena() const -> MonotonicArena & { return *arena_; }
+
+  auto operator==(const ArenaRef &) const -> bool = default;
+
+private:
+  MonotonicArena *arena_; ///< The arena memory comes from.
+};
+} // namespace easystl
+
+#endif // !EASYSTL_ARENA_ALLOCATOR_H_
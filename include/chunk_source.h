@@ -0,0 +1,153 @@
+#pragma once
+
+#ifndef EASYSTL_CHUNK_SOURCE_H_
+#define EASYSTL_CHUNK_SOURCE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "malloc_allocator.h"
+
+namespace easystl {
+/**
+ * @brief Returns the physical pages inside a range to the system while
+ * keeping the range mapped. Only whole pages are dropped; this is a no-op on
+ * platforms without `madvise`.
+ * @param begin The start of the range.
+ * @param bytes The size of the range.
+ */
+inline auto DecommitPages(void *begin, const std::size_t bytes) -> void {
+#if defined(__unix__) || defined(__APPLE__)
+  const auto page = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+  const auto first =
+      (reinterpret_cast<std::uintptr_t>(begin) + page - 1) & ~(page - 1);
+  const auto last =
+      (reinterpret_cast<std::uintptr_t>(begin) + bytes) & ~(page - 1);
+  if (first < last) {
+    madvise(reinterpret_cast<void *>(first), last - first, MADV_DONTNEED);
+  }
+#else
+  (void)begin;
+  (void)bytes;
+#endif
+}
+
+/**
+ * @struct MallocChunkSource
+ * @brief Chunk source that takes chunks from `malloc`, falling back to
+ * MallocAllocator (and its OOM handler) when `malloc` fails.
+ *
+ * A chunk source provides the backing memory of a memory pool. `Allocate`
+ * may round the requested size up and reports the size it actually obtained;
+ * `Deallocate` gets that size back.
+ */
+struct MallocChunkSource {
+  /**
+   * @brief Obtains a chunk.
+   * @param bytes The requested size; updated to the size obtained.
+   * @return Pointer to the chunk, or `nullptr` if out of memory.
+   */
+  static auto Allocate(std::size_t &bytes) -> void * {
+    void *chunk = malloc(bytes);
+    return chunk != nullptr ? chunk : MallocAllocator::Allocate(bytes);
+  }
+
+  /**
+   * @brief Returns a chunk to the system.
+   * @param chunk Pointer to the chunk.
+   * @param bytes The size reported by Allocate.
+   */
+  static auto Deallocate(void *chunk, std::size_t /*bytes*/) -> void {
+    free(chunk);
+  }
+};
+
+/**
+ * @struct MmapChunkSource
+ * @brief Chunk source that maps chunks directly with `mmap`.
+ *
+ * With `HugePages` every chunk is a multiple of 2 MiB, aligned to 2 MiB and
+ * marked with `madvise(MADV_HUGEPAGE)`, so that transparent huge pages back
+ * the pool and large pools stop thrashing the TLB. With `Populate` the pages
+ * are pre-faulted when the chunk is mapped instead of on first touch. On
+ * platforms without `mmap` this falls back to MallocChunkSource.
+ * @tparam HugePages Request transparent huge pages.
+ * @tparam Populate Pre-fault the pages of new chunks.
+ */
+template <bool HugePages = true, bool Populate = false> struct MmapChunkSource {
+  static constexpr std::size_t kHugePageSize =
+      std::size_t{2} << 20; ///< Size of a transparent huge page.
+
+  /**
+   * @brief Maps a chunk.
+   * @param bytes The requested size; updated to the mapped size.
+   * @return Pointer to the chunk, or `nullptr` if out of memory.
+   */
+  static auto Allocate(std::size_t &bytes) -> void * {
+#if defined(__unix__) || defined(__APPLE__)
+    const std::size_t align =
+        HugePages ? kHugePageSize
+                  : static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    bytes = (bytes + align - 1) & ~(align - 1);
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_POPULATE
+    if constexpr (Populate && !HugePages) {
+      flags |= MAP_POPULATE;
+    }
+#endif
+    // Over-map by one huge page so an aligned range can be cut out of it.
+    const std::size_t mapped = HugePages ? bytes + kHugePageSize : bytes;
+    void *memory = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (memory == MAP_FAILED) {
+      return nullptr;
+    }
+    auto *chunk = static_cast<char *>(memory);
+    if constexpr (HugePages) {
+      const auto addr = reinterpret_cast<std::uintptr_t>(memory);
+      const std::size_t head = ((addr + align - 1) & ~(align - 1)) - addr;
+      if (head != 0) {
+        munmap(chunk, head);
+      }
+      if (mapped - head - bytes != 0) {
+        munmap(chunk + head + bytes, mapped - head - bytes);
+      }
+      chunk += head;
+#ifdef MADV_HUGEPAGE
+      madvise(chunk, bytes, MADV_HUGEPAGE);
+#endif
+      if constexpr (Populate) {
+        // Fault in after madvise so the faults are served with huge pages.
+        const auto page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        for (std::size_t offset = 0; offset < bytes; offset += page) {
+          chunk[offset] = 0;
+        }
+      }
+    }
+    return chunk;
+#else
+    return MallocChunkSource::Allocate(bytes);
+#endif
+  }
+
+  /**
+   * @brief Unmaps a chunk.
+   * @param chunk Pointer to the chunk.
+   * @param bytes The size reported by Allocate.
+   */
+  static auto Deallocate(void *chunk, const std::size_t bytes) -> void {
+#if defined(__unix__) || defined(__APPLE__)
+    munmap(chunk, bytes);
+#else
+    MallocChunkSource::Deallocate(chunk, bytes);
+#endif
+  }
+};
+} // namespace easystl
+
+#endif // !EASYSTL_CHUNK_SOURCE_H_
@@ -0,0 +1,162 @@
+#pragma once
+
+#ifndef EASYSTL_CONCURRENT_POOL_LIST_H_
+#define EASYSTL_CONCURRENT_POOL_LIST_H_
+
+#include <atomic>
+#include <cstdint>
+
+#include "memory_pool_list.h"
+
+// The speculative link read in Pop may overlap with the new owner of a block
+// writing its payload; the result is discarded, so the read is hidden from
+// ThreadSanitizer.
+#if defined(__GNUC__) || defined(__clang__)
+#define EASYSTL_NO_SANITIZE_THREAD __attribute__((no_sanitize("thread")))
+#else
+#define EASYSTL_NO_SANITIZE_THREAD
+#endif
+
+namespace easystl {
+/**
+ * @class BasicConcurrentMemoryPoolList
+ * @brief A lock-free variant of BasicMemoryPoolList (a Treiber stack) that may
+ * be pushed to and popped from by any number of threads.
+ *
+ * The head pointer is packed together with a modification tag into a single
+ * 64-bit word that is updated with one compare-and-swap. Every successful
+ * update bumps the tag, so a node that is popped and pushed back between a
+ * thread's load and its CAS (the ABA problem) no longer matches and the CAS
+ * retries.
+ *
+ * Pop reads the link of a node it does not own yet, so nodes must stay mapped
+ * for as long as the list may be popped concurrently; pool blocks satisfy this.
+ * @tparam Link How the next pointer is stored, PlainLink or ObfuscatedLink.
+ */
+template <class Link = PlainLink> class BasicConcurrentMemoryPoolList {
+public:
+  /**
+   * @brief Checks if the list is empty.
+   * @return `true` if the list is empty, `false` otherwise.
+   */
+  [[nodiscard]] auto Empty() const -> bool {
+    return GetPointer(head_.load(std::memory_order_acquire)) == nullptr;
+  }
+
+  /**
+   * @brief Pushes a node onto the front of the list.
+   * @param node Pointer to the node to be added.
+   */
+  auto Push(void *node) -> void { PushList(node, node); }
+
+  /**
+   * @brief Pushes an already linked chain of nodes with a single CAS.
+   * @param first The first node of the chain.
+   * @param last The last node of the chain; its link is overwritten.
+   */
+  auto PushList(void *first, void *last) -> void {
+    std::uint64_t old = head_.load(std::memory_order_relaxed);
+    do {
+      LinkRef(last).store(Link::Encode(&List::GetNextNode(last),
+                                       GetPointer(old)),
+                          std::memory_order_relaxed);
+    } while (!head_.compare_exchange_weak(old, Pack(first, GetTag(old) + 1),
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed));
+  }
+
+  /**
+   * @brief Pops a node from the front of the list.
+   * @return Pointer to the removed node, or `nullptr` if the list is empty.
+   */
+  auto Pop() -> void * {
+    std::uint64_t old = head_.load(std::memory_order_acquire);
+    void *node;
+    void *next;
+    do {
+      node = GetPointer(old);
+      if (node == nullptr) {
+        return nullptr;
+      }
+      next = LoadLink(node);
+    } while (!head_.compare_exchange_weak(old, Pack(next, GetTag(old) + 1),
+                                          std::memory_order_acquire,
+                                          std::memory_order_acquire));
+    Link::Check(next); // Only a link that won the CAS is known to be valid.
+    return node;
+  }
+
+  /**
+   * @brief Detaches the whole list at once.
+   * @return The first node of the detached chain, or `nullptr` if empty.
+   */
+  auto PopAll() -> void * {
+    std::uint64_t old = head_.load(std::memory_order_acquire);
+    while (!head_.compare_exchange_weak(old, Pack(nullptr, GetTag(old) + 1),
+                                        std::memory_order_acquire,
+                                        std::memory_order_acquire)) {
+    }
+    return GetPointer(old);
+  }
+
+private:
+  using List = BasicMemoryPoolList<Link>;
+
+  static_assert(sizeof(void *) <= sizeof(std::uint64_t),
+                "pointers must fit into the tagged head word");
+
+  ///< Bits of the head word holding the pointer; the rest hold the tag.
+  ///< User-space addresses on x86-64 and AArch64 fit into 48 bits.
+  static constexpr int kPointerBits = sizeof(void *) == 8 ? 48 : 32;
+  static constexpr std::uint64_t kPointerMask =
+      (std::uint64_t{1} << kPointerBits) - 1;
+
+  static auto Pack(void *node, const std::uint64_t tag) -> std::uint64_t {
+    return (reinterpret_cast<std::uintptr_t>(node) & kPointerMask) |
+           (tag << kPointerBits);
+  }
+
+  static auto GetPointer(const std::uint64_t word) -> void * {
+    return reinterpret_cast<void *>(
+        static_cast<std::uintptr_t>(word & kPointerMask));
+  }
+
+  /**
+   * @brief Views the link of a node atomically. Pop may read the link while
+   * the thread that won the node is already rewriting it; the tag makes the
+   * CAS fail in that case, and the atomic view keeps the read well-defined.
+   */
+  static auto LinkRef(void *node) -> std::atomic_ref<void *> {
+    return std::atomic_ref<void *>(List::GetNextNode(node));
+  }
+
+  /**
+   * @brief Reads the link of a node that another thread may have popped and
+   * reused already; in that case the tag makes the CAS in Pop fail and the
+   * value is discarded.
+   */
+  EASYSTL_NO_SANITIZE_THREAD static auto LoadLink(void *node) -> void * {
+#if defined(__GNUC__) || defined(__clang__)
+    void *stored =
+        __atomic_load_n(&List::GetNextNode(node), __ATOMIC_RELAXED);
+#else
+    void *stored = LinkRef(node).load(std::memory_order_relaxed);
+#endif
+    return Link::Decode(&List::GetNextNode(node), stored);
+  }
+
+  static auto GetTag(const std::uint64_t word) -> std::uint64_t {
+    return word >> kPointerBits;
+  }
+
+  std::atomic<std::uint64_t> head_{0}; ///< Tagged pointer to the first node.
+};
+
+/**
+ * @typedef ConcurrentMemoryPoolList
+ * @brief A lock-free free list storing plain links.
+ */
+using ConcurrentMemoryPoolList = BasicConcurrentMemoryPoolList<>;
+} // namespace easystl
+
+#endif // !EASYSTL_CONCURRENT_POOL_LIST_H_
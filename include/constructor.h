@@ -3,33 +3,26 @@
 #ifndef EASYSTL_CONSTRUCTOR_H_
 #define EASYSTL_CONSTRUCTOR_H_
 
-namespace easystl {
-/**
- * @brief Constructs an object of type T in the memory pointed to by p.
- *
- * This function uses placement new to construct a default-constructed
- * object of type T at the given memory address.
- *
- * @tparam T The type of the object to be constructed.
- * @param p Pointer to the memory location where the object will be constructed.
- */
-template <class T> void Construct(T *p) { new (p) T(); }
+#include <new>
+#include <utility>
 
+namespace easystl {
 /**
  * @brief Constructs an object of type T in the memory pointed to by p
- *        with the provided value.
+ *        from the provided arguments.
  *
  * This function uses placement new to construct an object of type T
- * at the given memory address, initialized with the value of the
- * provided argument.
+ * at the given memory address, passing the arguments on to its constructor
+ * with their value category preserved: rvalues are moved from, and with no
+ * arguments the object is value-initialized.
  *
  * @tparam T The type of the object to be constructed.
- * @tparam U The type of the value used to initialize the object.
+ * @tparam Args The types of the constructor arguments.
  * @param p Pointer to the memory location where the object will be constructed.
- * @param value The value used to initialize the constructed object.
+ * @param args The arguments forwarded to the constructor.
  */
-template <class T, class U> void Construct(T *p, const U &value) {
-  new (p) T(value);
+template <class T, class... Args> void Construct(T *p, Args &&...args) {
+  ::new (static_cast<void *>(p)) T(std::forward<Args>(args)...);
 }
 
 /**
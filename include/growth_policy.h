@@ -0,0 +1,82 @@
+#pragma once
+
+#ifndef EASYSTL_GROWTH_POLICY_H_
+#define EASYSTL_GROWTH_POLICY_H_
+
+#include <cstddef>
+#include <limits>
+
+namespace easystl {
+/**
+ * @struct GeometricGrowth
+ * @brief Growth policy that multiplies the size by `Num / Den` whenever a
+ * vector runs out of capacity.
+ *
+ * A growth policy decides the capacity of the storage a vector reallocates
+ * into. It provides `Grow`, which never returns less than the required size
+ * (so inserting many elements at once always fits), `kMinCapacity`, the
+ * smallest capacity a growing vector allocates, and `kRoundToSizeClass`,
+ * which lets the vector extend the capacity to the usable size of the block
+ * the allocator hands out (see AllocatorWrapper::GoodSize) instead of leaving
+ * that slack unused.
+ *
+ * A factor of 2 reallocates least often; a factor below the golden ratio, such
+ * as 1.5, lets a later buffer fit into the space of earlier ones freed
+ * before it and keeps less unused capacity.
+ * @tparam Num The numerator of the growth factor.
+ * @tparam Den The denominator of the growth factor.
+ * @tparam MinCapacity The smallest capacity allocated on growth.
+ * @tparam RoundToSizeClass Extend capacities to the allocator's block size.
+ */
+template <std::size_t Num = 2, std::size_t Den = 1,
+          std::size_t MinCapacity = 16, bool RoundToSizeClass = true>
+struct GeometricGrowth {
+  static_assert(Den != 0 && Num > Den, "the growth factor must exceed 1");
+
+  static constexpr std::size_t kMinCapacity =
+      MinCapacity; ///< Smallest capacity allocated on growth.
+  static constexpr bool kRoundToSizeClass =
+      RoundToSizeClass; ///< Use the slack of the allocator's blocks.
+
+  /**
+   * @brief Gets the capacity to grow a vector to.
+   * @param size The number of elements in the vector.
+   * @param required The number of elements the storage must hold.
+   * @return The new capacity, at least `required` and `kMinCapacity`.
+   */
+  static constexpr auto Grow(const std::size_t size,
+                             const std::size_t required) -> std::size_t {
+    constexpr std::size_t kMax = std::numeric_limits<std::size_t>::max();
+    const std::size_t grown = size <= kMax / Num ? size * Num / Den : kMax;
+    const std::size_t result = grown > required ? grown : required;
+    return result > kMinCapacity ? result : kMinCapacity;
+  }
+};
+
+/**
+ * @typedef DoublingGrowth
+ * @brief Grows by a factor of 2.
+ */
+using DoublingGrowth = GeometricGrowth<2, 1>;
+
+/**
+ * @typedef HalfGrowth
+ * @brief Grows by a factor of 1.5.
+ */
+using HalfGrowth = GeometricGrowth<3, 2>;
+
+/**
+ * @typedef CompactGrowth
+ * @brief Grows by a factor of 2 from a single element, for containers that
+ * mostly stay tiny: no minimum capacity is allocated up front.
+ */
+using CompactGrowth = GeometricGrowth<2, 1, 0>;
+
+/**
+ * @typedef DefaultGrowth
+ * @brief The growth policy of vector unless told otherwise.
+ */
+using DefaultGrowth = DoublingGrowth;
+} // namespace easystl
+
+#endif // !EASYSTL_GROWTH_POLICY_H_
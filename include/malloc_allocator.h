@@ -3,14 +3,27 @@
 #ifndef EASYSTL_MALLOC_ALLOCATOR_H_
 #define EASYSTL_MALLOC_ALLOCATOR_H_
 
+#include <cstddef>
 #include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <thread>
+
+#include "allocator_stats.h"
+#include "oom_policy.h"
+
+#ifdef EASYSTL_ENABLE_ALLOCATOR_STATS
+#include <atomic>
+#endif
 
 namespace easystl {
 /**
  * @class MallocAllocator
  * @brief A memory allocator that use `malloc`, `realloc`, and `free` for memory
  * management. This allocator allows fow the ise of a custom out-of-memory(OOM)
- * handler.
+ * handler, MemoryPressure callbacks and an OomPolicy.
  */
 class MallocAllocator {
 public:
@@ -25,6 +38,12 @@ public:
     if (result == nullptr) {
       result = MallocInOom(size);
     } // Call OOM handler if allocation fails
+#ifdef EASYSTL_ENABLE_ALLOCATOR_STATS
+    if (result != nullptr) {
+      counters_.allocations.fetch_add(1, std::memory_order_relaxed);
+      counters_.allocatedbytes.fetch_add(size, std::memory_order_relaxed);
+    }
+#endif
     return result;
   }
 
@@ -34,7 +53,15 @@ public:
    * @param{unnamed} Unused parameter, present for compatibility with other
    * allocators.
    */
+#ifdef EASYSTL_ENABLE_ALLOCATOR_STATS
+  static auto Deallocate(void *obj, const std::size_t size) -> void {
+    counters_.deallocations.fetch_add(1, std::memory_order_relaxed);
+    counters_.freedbytes.fetch_add(size, std::memory_order_relaxed);
+    free(obj);
+  }
+#else
   static auto Deallocate(void *obj, std::size_t /*size*/) -> void { free(obj); }
+#endif
 
   /**
    * @brief Reallocates a memory block to a new size using `realloc`.
@@ -50,6 +77,86 @@ public:
     if (result == nullptr) {
       result = ReallocInOom(obj, newsize);
     } // Call OOM handler if reallocation fails.
+#ifdef EASYSTL_ENABLE_ALLOCATOR_STATS
+    if (result != nullptr) {
+      counters_.reallocations.fetch_add(1, std::memory_order_relaxed);
+    }
+#endif
+    return result;
+  }
+
+  /**
+   * @brief Allocates memory of a specified size and alignment. Alignments
+   * up to `alignof(std::max_align_t)` use `malloc`; larger ones use
+   * `aligned_alloc` (`_aligned_malloc` on MSVC).
+   * @param size The size of the memory block to allocate.
+   * @param align The alignment, a power of two.
+   * @return A pointer to the allocated memory block, or invokes an OOM handler
+   * if the allocation fails.
+   */
+  static auto Allocate(const std::size_t size, const std::size_t align)
+      -> void * {
+    if (align <= alignof(std::max_align_t)) {
+      return Allocate(size);
+    }
+    void *result = AlignedMalloc(size, align);
+    if (result == nullptr) {
+      result = RetryInOom(size, [=] { return AlignedMalloc(size, align); });
+    }
+#ifdef EASYSTL_ENABLE_ALLOCATOR_STATS
+    if (result != nullptr) {
+      counters_.allocations.fetch_add(1, std::memory_order_relaxed);
+      counters_.allocatedbytes.fetch_add(size, std::memory_order_relaxed);
+    }
+#endif
+    return result;
+  }
+
+  /**
+   * @brief Deallocates a memory block previously allocated with the aligned
+   * `Allocate`.
+   * @param obj Pointer to the memory block to deallocate.
+   * @param size The size of the memory block.
+   * @param align The alignment the block was allocated with.
+   */
+  static auto Deallocate(void *obj, const std::size_t size,
+                         const std::size_t align) -> void {
+    if (align <= alignof(std::max_align_t)) {
+      Deallocate(obj, size);
+      return;
+    }
+#ifdef EASYSTL_ENABLE_ALLOCATOR_STATS
+    counters_.deallocations.fetch_add(1, std::memory_order_relaxed);
+    counters_.freedbytes.fetch_add(size, std::memory_order_relaxed);
+#endif
+#ifdef _MSC_VER
+    _aligned_free(obj);
+#else
+    free(obj);
+#endif
+  }
+
+  /**
+   * @brief Reallocates a memory block allocated with the aligned `Allocate`,
+   * keeping its alignment and contents.
+   * @param obj Pointer to the memory block to reallocate.
+   * @param oldsize The current size of the memory block.
+   * @param newsize The new size of the memory block.
+   * @param align The alignment the block was allocated with.
+   * @return A pointer to the reallocated memory block, or `nullptr` if out of
+   * memory (the old block is then left untouched).
+   */
+  static auto Reallocate(void *obj, const std::size_t oldsize,
+                         const std::size_t newsize, const std::size_t align)
+      -> void * {
+    if (align <= alignof(std::max_align_t)) {
+      return Reallocate(obj, oldsize, newsize);
+    }
+    void *result = Allocate(newsize, align);
+    if (result != nullptr && obj != nullptr) {
+      std::memcpy(result, obj, oldsize < newsize ? oldsize : newsize);
+      Deallocate(obj, oldsize, align);
+    }
     return result;
   }
 
@@ -65,6 +172,47 @@ public:
     return old;                // return the previous handler
   }
 
+  /**
+   * @brief Sets how allocations retry and fail when out of memory.
+   * @param policy The new policy.
+   * @return The previous policy.
+   */
+  static auto SetOomPolicy(const OomPolicy &policy) -> OomPolicy {
+    const std::lock_guard<std::mutex> lock(policymutex_);
+    OomPolicy old = policy_;
+    policy_ = policy;
+    return old;
+  }
+
+  /**
+   * @brief Returns the current OOM policy.
+   * @return The policy.
+   */
+  static auto GetOomPolicy() -> OomPolicy {
+    const std::lock_guard<std::mutex> lock(policymutex_);
+    return policy_;
+  }
+
+#ifdef EASYSTL_ENABLE_ALLOCATOR_STATS
+  /**
+   * @brief Takes a snapshot of the allocator counters.
+   * @return The current counter values.
+   */
+  static auto Stats() -> MallocStats {
+    MallocStats stats;
+    stats.allocations = counters_.allocations.load(std::memory_order_relaxed);
+    stats.deallocations =
+        counters_.deallocations.load(std::memory_order_relaxed);
+    stats.reallocations =
+        counters_.reallocations.load(std::memory_order_relaxed);
+    stats.allocatedbytes =
+        counters_.allocatedbytes.load(std::memory_order_relaxed);
+    stats.freedbytes = counters_.freedbytes.load(std::memory_order_relaxed);
+    stats.oomretries = counters_.oomretries.load(std::memory_order_relaxed);
+    return stats;
+  }
+#endif
+
 private:
   /**
    * @brief Handles memory allocation failures by invoking the OOM handler.
@@ -83,49 +231,91 @@ private:
    */
   static auto ReallocInOom(void *obj, std::size_t size) -> void *;
 
+  /**
+   * @brief Retries an allocation as the OOM policy says.
+   * @tparam Func The type of the allocation attempt.
+   * @param size The size of the failed request.
+   * @param attempt Callable returning the allocated block or `nullptr`.
+   * @return The result of the first successful attempt, or `nullptr`.
+   */
+  template <class Func>
+  static auto RetryInOom(std::size_t size, Func &&attempt) -> void *;
+
+  /**
+   * @brief Allocates an over-aligned block without running the OOM handler.
+   * @param size The size of the memory block.
+   * @param align The alignment, a power of two.
+   * @return A pointer to the block, or `nullptr`.
+   */
+  static auto AlignedMalloc(const std::size_t size, const std::size_t align)
+      -> void * {
+#ifdef _MSC_VER
+    return _aligned_malloc(size, align);
+#else
+    // aligned_alloc requires the size to be a multiple of the alignment; a
+    // size that cannot be rounded up to one fails like any oversized request
+    // instead of wrapping around.
+    constexpr auto kMaxSize =
+        static_cast<std::size_t>(std::numeric_limits<std::ptrdiff_t>::max());
+    if (size > kMaxSize - (align - 1)) {
+      return nullptr;
+    }
+    return aligned_alloc(align, (size + align - 1) & ~(align - 1));
+#endif
+  }
+
   /**
    * @brief The user-defined OOM handler.
    * If memory allocation or reallocation fails, this handler is invoked.
    */
   static auto (*CustomerOomHandler)() -> void;
+
+  static OomPolicy policy_;       ///< The current OOM policy.
+  static std::mutex policymutex_; ///< Guards policy_.
+
+#ifdef EASYSTL_ENABLE_ALLOCATOR_STATS
+  /**
+   * @struct Counters
+   * @brief Live counters behind Stats(); updated from any thread.
+   */
+  struct Counters {
+    std::atomic<std::size_t> allocations{0};
+    std::atomic<std::size_t> deallocations{0};
+    std::atomic<std::size_t> reallocations{0};
+    std::atomic<std::size_t> allocatedbytes{0};
+    std::atomic<std::size_t> freedbytes{0};
+    std::atomic<std::size_t> oomretries{0};
+  };
+
+  static Counters counters_; ///< Counters behind Stats().
+#endif
 };
 
 /**
  * @brief Initialize the OOM handler to `nullptr` by default.
  */
-void (*MallocAllocator::CustomerOomHandler)() = nullptr;
+inline void (*MallocAllocator::CustomerOomHandler)() = nullptr;
+inline OomPolicy MallocAllocator::policy_;
+inline std::mutex MallocAllocator::policymutex_;
+
+#ifdef EASYSTL_ENABLE_ALLOCATOR_STATS
+inline MallocAllocator::Counters MallocAllocator::counters_;
+#endif
 
 /**
- * @brief Attempts to allocate memory when `malloc` fails, invoking the OOM
- * handler. If the handler is set, it will retry 3 times before returning
- * `nullptr` or aborting.
+ * @brief Attempts to allocate memory when `malloc` fails, as the OOM policy
+ * says.
  * @param size The size of memory to allocate.
  * @return A pointer to the allocated memory, or `nullptr` if allocation fails
  * after retries.
  */
 inline auto MallocAllocator::MallocInOom(const std::size_t size) -> void * {
-  int retry_count = 0;
-  constexpr int max_retries = 3;
-
-  while (retry_count < max_retries) {
-    void (*my_malloc_handler)() = CustomerOomHandler;
-    // If no OOM handler is set, abort the program
-    if (my_malloc_handler == nullptr) {
-      std::abort();
-    }
-    (*my_malloc_handler)(); // Invoke the OOM handler
-    if (void *result = malloc(size)) {
-      return result;
-    } // Try allocating memory again
-    retry_count++;
-  }
-  return nullptr;
+  return RetryInOom(size, [size] { return malloc(size); });
 }
 
 /**
- * @brief Attempts to reallocate memory when `realloc` fails, invoking the OOM
- * handler. If the handler is set, it will retry up to 3 times before returning
- * `nullptr` or aborting.
+ * @brief Attempts to reallocate memory when `realloc` fails, as the OOM policy
+ * says.
  * @param obj Pointer to the existing memory block to reallocate.
  * @param size The new size of the memory block.
  * @return A pointer to the reallocated memory, or `nullptr` if reallocation
@@ -133,19 +323,52 @@ inline auto MallocAllocator::MallocInOom(const std::size_t size) -> void * {
  */
 inline auto MallocAllocator::ReallocInOom(void *obj, const std::size_t size)
     -> void * {
-  int retry_count = 0;
-  constexpr int max_retries = 3;
+  return RetryInOom(size, [obj, size] { return realloc(obj, size); });
+}
 
-  while (retry_count < max_retries) {
+/**
+ * @brief Runs the OOM handler and the MemoryPressure callbacks, waits for the
+ * backoff and retries an allocation, up to `OomPolicy::retries` times. When
+ * nothing can free memory (no handler, no callback) or every retry failed,
+ * takes the policy's action.
+ * @tparam Func The type of the allocation attempt.
+ * @param size The size of the failed request.
+ * @param attempt Callable returning the allocated block or `nullptr`.
+ * @return The result of the first successful attempt, or `nullptr` if every
+ * retry failed and the action is OomAction::kReturnNull.
+ */
+template <class Func>
+auto MallocAllocator::RetryInOom(const std::size_t size, Func &&attempt)
+    -> void * {
+  const OomPolicy policy = GetOomPolicy();
+  auto backoff = policy.backoff;
+  for (int retry = 0; retry < policy.retries; ++retry) {
     void (*my_malloc_handler)() = CustomerOomHandler;
-    if (my_malloc_handler == nullptr) {
-      std::abort();
+    if (my_malloc_handler == nullptr && !MemoryPressure::Registered()) {
+      break; // Nothing can free memory.
     }
-    (*my_malloc_handler)();
-    if (void *result = realloc(obj, size)) {
-      return result;
+    if (my_malloc_handler != nullptr) {
+      (*my_malloc_handler)(); // Invoke the OOM handler
     }
-    retry_count++;
+    MemoryPressure::Relieve(size);
+#ifdef EASYSTL_ENABLE_ALLOCATOR_STATS
+    counters_.oomretries.fetch_add(1, std::memory_order_relaxed);
+#endif
+    if (backoff.count() > 0) {
+      std::this_thread::sleep_for(backoff);
+      backoff *= 2;
+    }
+    if (void *result = attempt()) {
+      return result;
+    } // Try allocating memory again
+  }
+  switch (policy.action) {
+  case OomAction::kThrow:
+    throw std::bad_alloc();
+  case OomAction::kAbort:
+    std::abort();
+  case OomAction::kReturnNull:
+    break;
   }
   return nullptr;
 }
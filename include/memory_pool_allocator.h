@@ -3,145 +3,677 @@
 #ifndef EASYSTL_MEMORY_POOL_ALLOCATOR_H_
 #define EASYSTL_MEMORY_POOL_ALLOCATOR_H_
 
-#include <malloc_allocator.h>
-#include <memory_pool_allocator.h>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <type_traits>
+
+#include "allocator_stats.h"
+#include "chunk_source.h"
+#include "concurrent_pool_list.h"
+#include "malloc_allocator.h"
+#include "memory_pool_list.h"
+#include "oom_policy.h"
+#include "pool_hardening.h"
+#include "refill_policy.h"
+#include "size_class.h"
 
 namespace easystl {
+// Constants for memory alignment and size limits of the default size classes.
+static constexpr int kAlign = 8; ///< Alignment size (in bytes).
+static constexpr int kMaxBytes =
+    128; ///< Maximum size of memory blocks managed by the pool.
+static constexpr int kFreeListNum =
+    kMaxBytes / kAlign; ///< Number of free lists based on size.
+
+/**
+ * @struct DefaultPoolTraits
+ * @brief Compile-time configuration of a BasicMemoryPoolAllocator. The
+ * default is the classic single-threaded pool with no synchronization.
+ */
+struct DefaultPoolTraits {
+  ///< Size classes served from free lists; larger requests go to malloc.
+  using SizeClasses = LinearSizeClasses<kAlign, kMaxBytes>;
+  ///< How many blocks a size class carves from a chunk when it runs dry.
+  using RefillPolicy = FixedRefill<20>;
+  ///< Where chunks come from; see chunk_source.h.
+  using ChunkSource = MallocChunkSource;
+  ///< Serve allocations from per-thread caches backed by a shared central pool.
+  static constexpr bool kThreadCache = false;
+  ///< Number of blocks moved between a thread cache and the central pool.
+  static constexpr std::size_t kCacheBatch = 32;
+  ///< Blocks a thread cache may hold per size class before draining a batch.
+  static constexpr std::size_t kCacheCapacity = 4 * kCacheBatch;
+  ///< Trim automatically once this many bytes sit in the central free lists
+  ///< (0 disables automatic trimming).
+  static constexpr std::size_t kTrimThreshold = 0;
+  ///< Keep the counters behind Stats(); see allocator_stats.h.
+  static constexpr bool kStats = EASYSTL_ALLOCATOR_STATS_DEFAULT;
+  ///< Store the requested size in front of every block, enabling the
+  ///< size-less Deallocate and checking the size passed to the sized one.
+  static constexpr bool kSizeHeader = false;
+  ///< Guard, poison and check every block; see pool_hardening.h.
+  static constexpr bool kHardened = EASYSTL_POOL_HARDENED_DEFAULT;
+};
+
+/**
+ * @struct ThreadCachedPoolTraits
+ * @brief Pool configuration that is safe to use from multiple threads. Each
+ * thread owns a cache of the size-class free lists and refills or drains it
+ * a whole batch at a time from lock-free central free lists.
+ */
+struct ThreadCachedPoolTraits : DefaultPoolTraits {
+  static constexpr bool kThreadCache = true;
+  using RefillPolicy = FixedRefill<kCacheBatch>;
+};
+
 /**
- * @class MemoryPoolList
- * @brief A linked list used for managing free nodes in the memory pool.
- * Each node contains a pointer to the next node, facilitating the allocation
- * and deallocation of memory.
+ * @struct LargeClassPoolTraits
+ * @brief Pool configuration with geometrically spaced size classes up to
+ * 32 KiB, so that medium-sized nodes and buffers stay off malloc.
+ */
+struct LargeClassPoolTraits : DefaultPoolTraits {
+  using SizeClasses = GeometricSizeClasses<32768>;
+};
+
+/**
+ * @struct TaggedPoolTraits
+ * @brief Pool configuration `Base` made distinct by a tag type. Every pool
+ * keeps its state in static members of its traits' instantiation, so each tag
+ * gets its own free lists and chunks: subsystems (or threads) with their own
+ * tag never share a chunk, and one can give back all its memory at once with
+ * Release.
+ * @tparam Tag Any type naming the pool instance; only its identity is used.
+ * @tparam Base The configuration to inherit, DefaultPoolTraits by default.
+ */
+template <class Tag, class Base = DefaultPoolTraits>
+struct TaggedPoolTraits : Base {
+  using PoolTag = Tag; ///< The tag naming the pool instance.
+};
+
+/**
+ * @class BasicMemoryPoolAllocator
+ * @brief A memory allocator that uses a memory pool to efficiently manage small
+ * memory allocations. It provides faster allocations for small objects by
+ * maintaining a set of free lists.
+ * @tparam Traits Compile-time pool configuration, see DefaultPoolTraits.
  */
-class MemoryPoolList {
+template <class Traits = DefaultPoolTraits> class BasicMemoryPoolAllocator {
 public:
   /**
-   * @brief Checks if the list is empty.
-   * @return `true` if the list is empty, `false` otherwise.
+   * @brief Allocates memory of a specified size.
+   * @param size The size of the memory block to allocate.
+   * @return A pointer to the allocated memory block, or calls the
+   * MallocAllocator if size exceeds the largest size class.
+   */
+  static auto Allocate(const std::size_t size) -> void * {
+    if constexpr (kWrapped) {
+      return WrappedAllocate(size, kAlign);
+    } else {
+      return RawAllocate(size);
+    }
+  }
+
+  /**
+   * @brief Deallocates a memory block previously allocated with Allocate.
+   * @param obj Pointer to the memory block to deallocate.
+   * @param size The size of the memory block being deallocated.
+   */
+  static auto Deallocate(void *obj, const std::size_t size) -> void {
+    if constexpr (kWrapped) {
+      WrappedDeallocate(obj, size, kAlign);
+    } else {
+      RawDeallocate(obj, size);
+    }
+  }
+
+  /**
+   * @brief Deallocates a memory block without knowing its size, for pools
+   * whose traits set `kSizeHeader`. The size and alignment are read from the
+   * block's header.
+   * @param obj Pointer to the memory block to deallocate.
    */
-  [[nodiscard]] auto Empty() const -> bool { return node_ == nullptr; }
+  static auto Deallocate(void *obj) -> void
+    requires(Traits::kSizeHeader)
+  {
+    const std::uint64_t header = LoadHeader(obj);
+    WrappedDeallocate(obj, HeaderToSize(header), HeaderToAlign(header));
+  }
+
   /**
-   * @brief Retrieves the next node in the list.
-   * @param node Pointer to the current node.
-   * @return Reference to the next node pointer.
+   * @brief Returns the size a block was requested with, for pools whose
+   * traits set `kSizeHeader`.
+   * @param obj Pointer to a memory block allocated from the pool.
+   * @return The size passed to Allocate.
    */
-  static auto GetNextNode(void *node) -> void *& {
-    return *static_cast<void **>(node);
+  static auto SizeOf(const void *obj) -> std::size_t
+    requires(Traits::kSizeHeader)
+  {
+    return HeaderToSize(LoadHeader(obj));
   }
 
   /**
-   * @brief Pushed a node onto the front of the list.
-   * @param node Pointer to the node to be added.
+   * @brief Gets the size of the block a request of `bytes` is served from,
+   * so callers that can use the slack (such as growing containers) can ask
+   * for it up front; allocating the returned size takes the same block. Pools
+   * with a size header or hardening keep their layers inside the block and
+   * return `bytes` unchanged.
+   * @param bytes The requested size.
+   * @return The usable size, at least `bytes`.
    */
-  auto Push(void *node) -> void {
-    GetNextNode(node) = node_;
-    node_ = node;
+  static auto GoodSize(const std::size_t bytes) -> std::size_t {
+    if constexpr (kWrapped) {
+      return bytes;
+    } else {
+      return bytes == 0 ? 0 : BlockSize(bytes);
+    }
   }
 
   /**
-   * @brief Pops a node from the front of the list.
-   * @return Pointer to the node that was removed from the list.
+   * @brief Allocates `n` blocks of the same size in one call. Blocks are popped
+   * from the free list in a single pass and the rest is carved straight from
+   * a chunk, so the size-class lookup, counters and cache lookup are paid
+   * once per batch instead of once per block.
+   * @param size The size of each memory block.
+   * @param n The number of blocks to allocate.
+   * @param out Receives the allocated blocks; must have room for `n`.
+   * @return The number of blocks allocated; less than `n` only if the system
+   * ran out of memory.
    */
-  auto Pop() -> void * {
-    void *result = node_;
-    node_ = GetNextNode(result);
-    return result;
+  static auto AllocateBatch(std::size_t size, std::size_t n, void **out)
+      -> std::size_t;
+
+  /**
+   * @brief Deallocates `n` blocks of the same size in one call.
+   * @param size The size of each memory block.
+   * @param n The number of blocks to deallocate.
+   * @param ptrs The blocks, each previously allocated with `size`.
+   */
+  static auto DeallocateBatch(std::size_t size, std::size_t n,
+                              void *const *ptrs) -> void;
+
+  /**
+   * @brief Reallocates a memory block to a new size, keeping its contents up
+   * to the smaller of both sizes.
+   *
+   * Blocks that stay in the same size class are returned as is and large
+   * blocks are passed on to `realloc`. In single-threaded pools a block that
+   * was the last one carved from the current chunk grows or shrinks in place.
+   * Otherwise a new block is allocated, the contents copied and the old block
+   * freed.
+   * @param obj Pointer to the memory block to reallocate, or `nullptr`.
+   * @param oldsize The current size of the memory block.
+   * @param newsize The new size of the memory block.
+   * @return A pointer to the reallocated memory block, or `nullptr` if out of
+   * memory (the old block is then left untouched).
+   */
+  static auto Reallocate(void *obj, std::size_t oldsize, std::size_t newsize)
+      -> void *;
+
+  /**
+   * @brief Allocates memory of a specified size and alignment.
+   *
+   * Alignments up to the pool's 8 bytes take the normal path. Alignments up
+   * to 64 bytes have their own free lists per size class, whose blocks are
+   * carved at aligned addresses with a stride that is a multiple of the
+   * alignment. Larger alignments and sizes go to MallocAllocator. Thread-cached
+   * pools serve aligned blocks from the central lists, bypassing the cache.
+   * @param size The size of the memory block to allocate.
+   * @param align The alignment, a power of two.
+   * @return A pointer to the allocated memory block.
+   */
+  static auto Allocate(std::size_t size, std::size_t align) -> void *;
+
+  /**
+   * @brief Deallocates a memory block previously allocated with the aligned
+   * Allocate.
+   * @param obj Pointer to the memory block to deallocate.
+   * @param size The size of the memory block.
+   * @param align The alignment the block was allocated with.
+   */
+  static auto Deallocate(void *obj, std::size_t size, std::size_t align)
+      -> void;
+
+  /**
+   * @brief Reallocates a memory block allocated with the aligned Allocate,
+   * keeping its alignment and contents.
+   * @param obj Pointer to the memory block to reallocate, or `nullptr`.
+   * @param oldsize The current size of the memory block.
+   * @param newsize The new size of the memory block.
+   * @param align The alignment the block was allocated with.
+   * @return A pointer to the reallocated memory block, or `nullptr` if out of
+   * memory (the old block is then left untouched).
+   */
+  static auto Reallocate(void *obj, std::size_t oldsize, std::size_t newsize,
+                         std::size_t align) -> void *;
+
+  static constexpr std::size_t kCacheLineSize =
+      64; ///< Cache-line size assumed by AllocateCacheAligned.
+
+  /**
+   * @brief Allocates a block that owns whole cache lines, for objects that
+   * different threads mutate concurrently (counters, per-thread state). The
+   * block is aligned to kCacheLineSize and its class size is padded to a
+   * multiple of it, so no other block shares its lines and writes to it do
+   * not invalidate a neighbour's line on another core.
+   * @param size The size of the memory block to allocate.
+   * @return A pointer to the allocated memory block.
+   */
+  static auto AllocateCacheAligned(const std::size_t size) -> void * {
+    return Allocate(size, kCacheLineSize);
+  }
+
+  /**
+   * @brief Deallocates a block allocated with AllocateCacheAligned.
+   * @param obj Pointer to the memory block to deallocate.
+   * @param size The size of the memory block.
+   */
+  static auto DeallocateCacheAligned(void *obj, const std::size_t size)
+      -> void {
+    Deallocate(obj, size, kCacheLineSize);
+  }
+
+  /**
+   * @brief Returns chunks whose blocks all sit in the central free lists to
+   * the system. In thread-cached mode the calling thread's cache is drained
+   * first; other threads' caches keep their blocks.
+   *
+   * Single-threaded pools give such chunks back to the chunk source. In
+   * thread-cached pools a lock-free pop may still be reading a block of the
+   * chunk, so the chunk's pages are only dropped with `madvise(MADV_DONTNEED)`
+   * and the chunk is reused for later carving.
+   * @return The number of bytes given back.
+   */
+  static auto Trim() -> std::size_t;
+
+  /**
+   * @brief Registers Trim as a MemoryPressure callback, so a failed `malloc`
+   * anywhere makes the pool give its free chunks back before retrying. The
+   * callback skips the pool while it is carving (the failing request may come
+   * from the pool itself) and, in thread-cached mode, while another thread
+   * holds the pool lock. A single-threaded pool is trimmed on the thread that
+   * ran out of memory, so only register one whose allocations all happen on a
+   * single thread.
+   * @return The id to pass to MemoryPressure::Unregister, or 0 if the registry
+   * is full.
+   */
+  static auto RegisterPressureTrim() -> std::size_t {
+    return MemoryPressure::Register(&ShedMemory, nullptr);
+  }
+
+  /**
+   * @brief Gives every chunk back to the chunk source and resets the pool to
+   * its initial state, dropping all its blocks at once. No block of the pool
+   * may be used afterwards; blocks larger than the largest size class came
+   * from malloc and still have to be deallocated one by one. Only for
+   * single-threaded pools, since thread caches may hold blocks of any chunk.
+   * @return The number of bytes given back.
+   */
+  static auto Release() -> std::size_t
+    requires(!Traits::kThreadCache);
+
+  /**
+   * @brief Returns the number of bytes currently held in chunks obtained from
+   * the system.
+   * @return The pool footprint in bytes.
+   */
+  static auto Footprint() -> std::size_t {
+    std::unique_lock<std::mutex> lock(mutex_, std::defer_lock);
+    if constexpr (Traits::kThreadCache) {
+      lock.lock();
+    }
+    return mallocoffset_;
   }
 
+  /**
+   * @brief Takes a snapshot of the pool counters. Only available when
+   * `Traits::kStats` is set. Blocks held in thread caches count as allocated.
+   * @return The current counter values.
+   */
+  static auto Stats() -> PoolStats<Traits::SizeClasses::kNum>
+    requires(Traits::kStats);
+
 private:
-  void *node_ = nullptr; ///< Pointer to the head of the linked list.
-};
+  using SizeClasses = typename Traits::SizeClasses;
+  static constexpr std::size_t kClassNum =
+      SizeClasses::kNum; ///< Number of size classes and free lists.
+  using RefillPolicy = typename Traits::RefillPolicy;
+  using ChunkSource = typename Traits::ChunkSource;
+  static constexpr std::size_t kMaxPoolAlign =
+      kCacheLineSize; ///< Largest alignment served from the pool.
+  static constexpr std::size_t kAlignFamilies =
+      3; ///< Aligned free-list families: 16, 32 and 64 bytes.
+  static constexpr bool kTrackCachedBytes =
+      Traits::kTrimThreshold != 0; ///< Whether automatic trimming is on.
+  static constexpr bool kHardened =
+      Traits::kHardened; ///< Whether blocks are guarded and checked.
+  static constexpr bool kChecked =
+      kHardened || EASYSTL_ASAN_DEFAULT; ///< Blocks go through PoolHardening.
+  static constexpr std::size_t kGuardSize =
+      kHardened ? PoolHardening::kGuardSize
+                : 0; ///< Bytes added to each request for the canary.
+  static constexpr bool kWrapped =
+      kChecked || Traits::kSizeHeader; ///< Blocks go through WrappedAllocate.
+  static constexpr bool kResizeInPlace =
+      !kHardened && !Traits::kSizeHeader; ///< Reallocate may keep the block.
+  ///< Free lists private to one thread (or to the single-threaded pool).
+  using LocalList = BasicMemoryPoolList<
+      std::conditional_t<kHardened, ObfuscatedLink, PlainLink>>;
 
-// Constants for memory alignment and size limits.
-static constexpr int kAlign = 8; ///< Alignment size (in bytes).
-static constexpr int kMaxBytes =
-    128; ///< Maximum size of memory blocks managed by the pool.
-static constexpr int kFreeListNum =
-    kMaxBytes / kAlign; ///< Number of free lists based on size.
+  /**
+   * @struct ThreadCache
+   * @brief Per-thread front end of the pool. Whatever is still cached when the
+   * owning thread exits is handed back to the central free lists.
+   */
+  struct ThreadCache {
+    LocalList lists[kClassNum]; ///< Thread-private free lists.
+    std::size_t counts[kClassNum] = {}; ///< Number of blocks in each list.
+
+    ~ThreadCache() {
+      for (std::size_t i = 0; i < kClassNum; ++i) {
+        ReleaseToCentral(*this, i, counts[i]);
+      }
+    }
+  };
 
-/**
- * @class MemoryPoolAllocator
- * @brief A memory allocator that uses a memory pool to efficiently manage small
- * memory allocations. It provides faster allocations for small objects by
- * maintaining a set of free lists.
- */
-class MemoryPoolAllocator {
-public:
   /**
-   * @brief Allocates memory of a specified size.
+   * @struct ChunkHeader
+   * @brief Bookkeeping stored at the start of every chunk obtained from the
+   * system. Chunks are kept in a list sorted by address.
+   */
+  struct ChunkHeader {
+    ChunkHeader *next;     ///< Next chunk in address order.
+    std::size_t size;      ///< Size of the chunk including this header.
+    std::size_t freebytes; ///< Scratch counter used by Trim.
+  };
+
+  /**
+   * @brief Rounds up the size to the nearest multiple of kAlign.
+   * @param bytes The size of round up.
+   * @return The rounded size, or `SIZE_MAX` if it does not fit in a size.
+   */
+  static constexpr auto RoundUp(const std::size_t bytes) -> std::size_t {
+    constexpr auto kMaxSize = std::numeric_limits<std::size_t>::max();
+    if (bytes > kMaxSize - (kAlign - 1)) {
+      return kMaxSize;
+    }
+    return (bytes + kAlign - 1) & static_cast<std::size_t>(~(kAlign - 1));
+  }
+
+  /**
+   * @brief Gets the bytes from an address to the next multiple of `align`.
+   * @param address The address.
+   * @param align The alignment, a power of two.
+   * @return The padding, 0 if `address` is aligned already.
+   */
+  static auto AlignPad(const char *address, const std::size_t align)
+      -> std::size_t {
+    return (align - reinterpret_cast<std::uintptr_t>(address) % align) % align;
+  }
+
+  static constexpr std::size_t kChunkHeaderSize =
+      RoundUp(sizeof(ChunkHeader)); ///< Bytes reserved for the chunk header.
+
+  /**
+   * @brief Gets the size of the block actually handed out for a request.
+   * @param bytes The requested size.
+   * @return The size-class size, or the rounded size for large requests.
+   */
+  static auto BlockSize(const std::size_t bytes) -> std::size_t {
+    return bytes > SizeClasses::kMaxBytes
+               ? RoundUp(bytes)
+               : SizeClasses::Size(SizeClasses::Index(bytes));
+  }
+
+  /**
+   * @brief Allocates memory of a specified size, without the checks of
+   * hardened pools.
    * @param size The size of the memory block to allocate.
    * @return A pointer to the allocated memory block, or calls the
-   * MallocAllocator if size exceeds kMaxBytes.
+   * MallocAllocator if size exceeds the largest size class.
    */
-  static auto Allocate(const std::size_t size) -> void * {
-    if (size > static_cast<std::size_t>(kMaxBytes)) {
+  static auto RawAllocate(const std::size_t size) -> void * {
+    if (size > SizeClasses::kMaxBytes) {
+      if constexpr (Traits::kStats) {
+        ++largeallocations_;
+      }
       return MallocAllocator::Allocate(
           size); // Use MallocAllocator for larger sizes.
     }
-    const std::size_t index = GetFreelistIndex(size);
-    if (freelist_[index].Empty()) {
-      return Refill(RoundUp(size)); // Refill the free list if empty.
+    const std::size_t index = SizeClasses::Index(size);
+    if constexpr (Traits::kStats) {
+      ++counters_[index].allocations;
+    }
+    if constexpr (Traits::kThreadCache) {
+      ThreadCache &cache = LocalCache();
+      if (cache.lists[index].Empty()) {
+        return FetchFromCentral(cache, index);
+      }
+      --cache.counts[index];
+      return cache.lists[index].Pop();
+    } else {
+      if (freelist_[index].Empty()) {
+        std::size_t chunknums = RefillPolicy::Next(refillstate_[index],
+                                                   SizeClasses::Size(index));
+        void *result = Refill(SizeClasses::Size(index), freelist_[index],
+                              chunknums); // Refill the free list if empty.
+        if (chunknums > 1) {
+          NoteCentralPush(index, chunknums - 1);
+        }
+        if constexpr (Traits::kStats) {
+          ++counters_[index].refills;
+        }
+        return result;
+      }
+      NoteCentralPop(index, 1);
+      return freelist_[index].Pop(); // Pop a node from the free list.
     }
-    return freelist_[index].Pop(); // Pop a node from the free list.
   }
 
   /**
-   * @brief Deallocates a memory block previously allocated with Allocate.
+   * @brief Deallocates a memory block previously allocated with RawAllocate.
    * @param obj Pointer to the memory block to deallocate.
    * @param size The size of the memory block being deallocated.
    */
-  static auto Deallocate(void *obj, const std::size_t size) -> void {
-    if (size > kMaxBytes) {
+  static auto RawDeallocate(void *obj, const std::size_t size) -> void {
+    if (size > SizeClasses::kMaxBytes) {
+      if constexpr (Traits::kStats) {
+        ++largedeallocations_;
+      }
       MallocAllocator::Deallocate(obj,
                                   size); // Use MallocAllocator for larger size.
       return;
     }
-    freelist_[GetFreelistIndex(size)].Push(
-        obj); // Push the block back to the free list.
+    const std::size_t index = SizeClasses::Index(size);
+    if constexpr (Traits::kStats) {
+      ++counters_[index].deallocations;
+    }
+    if constexpr (Traits::kThreadCache) {
+      ThreadCache &cache = LocalCache();
+      cache.lists[index].Push(obj);
+      if (++cache.counts[index] > Traits::kCacheCapacity) {
+        ReleaseToCentral(cache, index, Traits::kCacheBatch);
+      }
+    } else {
+      freelist_[index].Push(obj); // Push the block back to the free list.
+      NoteCentralPush(index, 1);
+    }
+    if constexpr (kTrackCachedBytes) {
+      if (cachedbytes_ > nexttrim_) {
+        Trim();
+      }
+    }
   }
 
   /**
-   * @brief Reallocates a memory block to a new size.
-   * @param obj Pointer to the memory block to reallocate.
-   * @param obj Pointer to the memory block to reallocate.
-   * @param oldsize The current size of the memory block.
-   * @param newsize The new size of the memory block.
-   * @return A pointer to the reallocated memory block.
+   * @brief Allocates a block through the optional layers around RawAllocate:
+   * the size header in front, the hardening checks and ASan annotations.
+   * @param size The requested size.
+   * @param align The alignment; kAlign or less for the unaligned path.
+   * @return A pointer to the usable memory.
    */
-  static auto Reallocate(void *obj, const std::size_t oldsize,
-                         const std::size_t newsize) -> void * {
-    if (RoundUp(newsize) == RoundUp(oldsize)) {
-      return obj;
+  static auto WrappedAllocate(std::size_t size, std::size_t align) -> void *;
+
+  /**
+   * @brief Deallocates a block allocated with WrappedAllocate. With a size
+   * header, a size that does not match the header is reported and the
+   * header's size is used instead.
+   * @param obj Pointer to the usable memory.
+   * @param size The size passed to WrappedAllocate.
+   * @param align The alignment passed to WrappedAllocate.
+   */
+  static auto WrappedDeallocate(void *obj, std::size_t size, std::size_t align)
+      -> void;
+
+  /**
+   * @brief Gets the bytes reserved in front of a block for its size header.
+   * The header word sits right before the block; the reserved space keeps the
+   * block aligned (to malloc's alignment for large blocks).
+   * @param size The requested size.
+   * @param align The requested alignment.
+   * @return The header size, 0 without `kSizeHeader`.
+   */
+  static constexpr auto HeaderSize(const std::size_t size,
+                                   const std::size_t align) -> std::size_t {
+    if constexpr (!Traits::kSizeHeader) {
+      return 0;
+    } else if (align > kAlign) {
+      return align;
+    } else {
+      return size + kAlign + kGuardSize > SizeClasses::kMaxBytes
+                 ? alignof(std::max_align_t)
+                 : kAlign;
     }
-    Deallocate(obj, oldsize); // Deallocate the old memory.
-    return Allocate(newsize); // Allocate new memory.
   }
 
-private:
+  ///< Bits of the header word holding the size; the rest hold log2(align).
+  static constexpr int kHeaderSizeBits = 56;
+
+  static auto StoreHeader(void *obj, const std::size_t size,
+                          const std::size_t align) -> void {
+    const std::uint64_t header =
+        static_cast<std::uint64_t>(size) |
+        (align > kAlign ? static_cast<std::uint64_t>(std::countr_zero(align))
+                              << kHeaderSizeBits
+                        : 0);
+    std::memcpy(static_cast<char *>(obj) - sizeof(header), &header,
+                sizeof(header));
+  }
+
+  static auto LoadHeader(const void *obj) -> std::uint64_t {
+    std::uint64_t header;
+    std::memcpy(&header, static_cast<const char *>(obj) - sizeof(header),
+                sizeof(header));
+    return header;
+  }
+
+  static auto HeaderToSize(const std::uint64_t header) -> std::size_t {
+    return static_cast<std::size_t>(
+        header & ((std::uint64_t{1} << kHeaderSizeBits) - 1));
+  }
+
+  static auto HeaderToAlign(const std::uint64_t header) -> std::size_t {
+    const auto shift = static_cast<unsigned>(header >> kHeaderSizeBits);
+    return shift == 0 ? std::size_t{kAlign} : std::size_t{1} << shift;
+  }
+
   /**
-   * @brief Rounds up the size to the nearest multiple of kAlign.
-   * @param bytes The size of round up.
-   * @return The rounded size.
+   * @brief Allocates an aligned block without the checks of hardened pools.
+   * @param size The size of the memory block to allocate.
+   * @param align The alignment, larger than kAlign.
+   * @return A pointer to the allocated memory block.
    */
-  static auto RoundUp(const std::size_t bytes) -> std::size_t {
-    return (bytes + kAlign - 1) & static_cast<std::size_t>(~(kAlign - 1));
+  static auto RawAllocate(std::size_t size, std::size_t align) -> void *;
+
+  /**
+   * @brief Deallocates a block allocated with the aligned RawAllocate.
+   * @param obj Pointer to the memory block to deallocate.
+   * @param size The size of the memory block.
+   * @param align The alignment the block was allocated with.
+   */
+  static auto RawDeallocate(void *obj, std::size_t size, std::size_t align)
+      -> void;
+
+  /**
+   * @brief Gets the size of the pool block serving a request.
+   * @param bytes The size passed to RawAllocate.
+   * @return The size-class size, or 0 if malloc serves the request.
+   */
+  static constexpr auto PoolBlockSize(const std::size_t bytes) -> std::size_t {
+    return bytes > SizeClasses::kMaxBytes
+               ? 0
+               : SizeClasses::Size(SizeClasses::Index(bytes));
+  }
+
+  /**
+   * @brief Gets the size WrappedAllocate requests for a block: the inner size
+   * plus the canary, and in a hardened pool at least the two words the free
+   * mark of PoolHardening sits behind.
+   * @param inner The header plus the requested size.
+   * @return The size passed to RawAllocate.
+   */
+  static constexpr auto GuardedSize(const std::size_t inner) -> std::size_t {
+    constexpr std::size_t kMinSize = kHardened ? 2 * sizeof(void *) : 0;
+    return inner + kGuardSize > kMinSize ? inner + kGuardSize : kMinSize;
   }
 
   /**
-   * @brief Gets the index of the free list based on the size of the block.
-   * @param bytes The size of the memory block.
-   * @return The index of the corresponding free list.
+   * @brief Gets the size of the aligned pool block serving a request.
+   * @param bytes The size passed to RawAllocate.
+   * @param align The alignment, larger than kAlign.
+   * @return The aligned stride, or 0 if malloc serves the request.
    */
-  static auto GetFreelistIndex(const std::size_t bytes) -> std::size_t {
-    return (bytes + kAlign - 1) / kAlign - 1;
+  static constexpr auto AlignedBlockSize(const std::size_t bytes,
+                                         const std::size_t align)
+      -> std::size_t {
+    return IsPoolAligned(bytes, align)
+               ? AlignedStride(
+                     SizeClasses::Index((bytes + align - 1) & ~(align - 1)),
+                     align)
+               : 0;
   }
 
+  /**
+   * @brief Returns the calling thread's cache, creating it on first use.
+   * @return Reference to the thread-local cache.
+   */
+  static auto LocalCache() -> ThreadCache & {
+    thread_local ThreadCache cache;
+    return cache;
+  }
+
+  /**
+   * @brief Moves up to one batch of blocks from the central free list into a
+   * thread cache, carving new blocks from a chunk if the central list is empty.
+   * @param cache The cache to refill.
+   * @param index The size-class index to refill.
+   * @return One block for the caller; the rest stay in the cache.
+   */
+  static auto FetchFromCentral(ThreadCache &cache, std::size_t index)
+      -> void *;
+
+  /**
+   * @brief Moves blocks from a thread cache back to the central free list.
+   * @param cache The cache to drain.
+   * @param index The size-class index to drain.
+   * @param nums The maximum number of blocks to move.
+   */
+  static auto ReleaseToCentral(ThreadCache &cache, std::size_t index,
+                               std::size_t nums) -> void;
+
   /**
    * @brief Fills a free list by allocating memory for a given size.
    * @param size The size of memory to allocate.
+   * @param list The free list receiving all but the first block.
+   * @param chunknums The number of blocks requested; updated to the number of
+   * blocks actually carved.
    * @return Pointer to the allocated memory.
    */
-  static auto Refill(std::size_t size) -> void *;
+  static auto Refill(std::size_t size, LocalList &list,
+                     std::size_t &chunknums) -> void *;
 
   /**
    * @brief Allocates a chunk of memory from the pool.
@@ -149,27 +681,595 @@ private:
    * @param chunknums The number of blocks to allocate.
    * @return Pointer to the allocated chunk of memory.
    */
-  static auto ChunkAlloc(std::size_t size, std::size_t &chunknums) -> char *;
+  static auto ChunkAlloc(std::size_t size, std::size_t &chunknums,
+                         std::size_t align = kAlign) -> char *;
+
+  /**
+   * @brief Pushes a leftover range onto the free lists, largest fitting class
+   * first. Bytes smaller than the smallest class are lost.
+   * @param begin The start of the range.
+   * @param end The end of the range.
+   */
+  static auto PushRemnant(char *begin, const char *end) -> void;
+
+  /**
+   * @brief Checks whether an aligned request is served by the pool.
+   * @param size The requested size.
+   * @param align The requested alignment, larger than kAlign.
+   * @return `true` if an aligned free list serves the request.
+   */
+  static constexpr auto IsPoolAligned(const std::size_t size,
+                                      const std::size_t align) -> bool {
+    return align <= kMaxPoolAlign &&
+           ((size + align - 1) & ~(align - 1)) <= SizeClasses::kMaxBytes;
+  }
+
+  /**
+   * @brief Gets the aligned free-list family of an alignment.
+   * @param align The alignment, `kAlign < align <= kMaxPoolAlign`.
+   * @return The family index (0 for 16 bytes, 1 for 32, 2 for 64).
+   */
+  static constexpr auto AlignFamily(const std::size_t align) -> std::size_t {
+    return static_cast<std::size_t>(std::countr_zero(align) -
+                                    std::countr_zero(std::size_t{kAlign})) -
+           1;
+  }
+
+  /**
+   * @brief Gets the distance between the aligned blocks of a size class.
+   * @param index The size-class index.
+   * @param align The alignment.
+   * @return The class size rounded up to the alignment.
+   */
+  static constexpr auto AlignedStride(const std::size_t index,
+                                      const std::size_t align) -> std::size_t {
+    return (SizeClasses::Size(index) + align - 1) & ~(align - 1);
+  }
+
+  /**
+   * @brief Obtains a chunk with at least `bytes` of usable space, reusing a
+   * chunk decommitted by Trim when one is large enough.
+   * @param bytes The requested usable size; updated to the size obtained.
+   * @return Pointer to the usable space of the chunk, or `nullptr`.
+   */
+  static auto NewChunk(std::size_t &bytes) -> char *;
+
+  /**
+   * @brief Trims the pool; the caller holds the lock in thread-cached mode.
+   * @return The number of bytes given back.
+   */
+  static auto TrimLocked() -> std::size_t;
+
+  /**
+   * @brief The MemoryPressure callback behind RegisterPressureTrim.
+   * @param{unnamed} Unused context.
+   * @param{unnamed} Unused size of the failed request.
+   * @return The number of bytes given back.
+   */
+  static auto ShedMemory(void * /*context*/, std::size_t /*bytes*/)
+      -> std::size_t;
+
+  /**
+   * @brief Inserts a chunk into an address-ordered chunk list.
+   * @param list The head of the list.
+   * @param chunk The chunk to insert.
+   */
+  static auto LinkChunk(ChunkHeader *&list, ChunkHeader *chunk) -> void;
+
+  /**
+   * @brief Finds the chunk containing an address by binary search.
+   * @param chunks The chunks sorted by address.
+   * @param nums The number of chunks.
+   * @param ptr The address to look up.
+   * @return The chunk containing `ptr`, or `nullptr`.
+   */
+  static auto FindChunk(ChunkHeader **chunks, std::size_t nums, const void *ptr)
+      -> ChunkHeader *;
+
+  ///< Central free lists; lock-free when shared between thread caches.
+  using CentralList = std::conditional_t<
+      Traits::kThreadCache,
+      BasicConcurrentMemoryPoolList<
+          std::conditional_t<kHardened, ObfuscatedLink, PlainLink>>,
+      LocalList>;
+  ///< Counters that thread caches update concurrently.
+  using Counter = std::conditional_t<Traits::kThreadCache,
+                                     std::atomic<std::size_t>, std::size_t>;
+
+  /**
+   * @struct ClassCounters
+   * @brief Live counters of one size class behind Stats().
+   */
+  struct ClassCounters {
+    Counter allocations{0};
+    Counter deallocations{0};
+    Counter refills{0};
+    Counter cachedblocks{0};
+  };
+
+  /**
+   * @brief Accounts for blocks entering a central free list.
+   * @param index The size-class index.
+   * @param nums The number of blocks.
+   */
+  static auto NoteCentralPush(const std::size_t index, const std::size_t nums)
+      -> void {
+    if constexpr (kTrackCachedBytes) {
+      cachedbytes_ += nums * SizeClasses::Size(index);
+    }
+    if constexpr (Traits::kStats) {
+      counters_[index].cachedblocks += nums;
+    }
+  }
+
+  /**
+   * @brief Accounts for blocks leaving a central free list.
+   * @param index The size-class index.
+   * @param nums The number of blocks.
+   */
+  static auto NoteCentralPop(const std::size_t index, const std::size_t nums)
+      -> void {
+    if constexpr (kTrackCachedBytes) {
+      cachedbytes_ -= nums * SizeClasses::Size(index);
+    }
+    if constexpr (Traits::kStats) {
+      counters_[index].cachedblocks -= nums;
+    }
+  }
 
-  static MemoryPoolList
-      freelist_[kFreeListNum];  ///< Array of free lists for different sizes.
+  static CentralList
+      freelist_[kClassNum];  ///< Array of free lists for different sizes.
   static char *freespacestart_; ///< Pointer to the start of the free space.
   static char *freespaceend_;   ///< Pointer to the end of the free space.
   static std::size_t mallocoffset_; ///< Offset for memory allocation tracking.
+  static std::mutex mutex_; ///< Guards chunk carving in thread-cached mode.
+  static ChunkHeader *chunks_;     ///< Chunks in use, sorted by address.
+  static ChunkHeader *idlechunks_; ///< Chunks decommitted by Trim.
+  static Counter cachedbytes_;     ///< Bytes in the central free lists.
+  static Counter nexttrim_; ///< Cached bytes that trigger the next Trim.
+  static ClassCounters counters_[kClassNum]; ///< Per size-class counters.
+  static typename RefillPolicy::State
+      refillstate_[kClassNum]; ///< Per size-class refill state.
+  static thread_local bool
+      carving_; ///< Whether this thread is obtaining a chunk for the pool.
+  static CentralList
+      alignedlists_[kAlignFamilies][kClassNum]; ///< Aligned free lists.
+  static typename RefillPolicy::State
+      alignedrefillstate_[kAlignFamilies]
+                         [kClassNum]; ///< Refill state of aligned lists.
+  static Counter largeallocations_;   ///< Requests forwarded to malloc.
+  static Counter largedeallocations_; ///< Frees forwarded to malloc.
 };
 
+/**
+ * @typedef MemoryPoolAllocator
+ * @brief The default single-threaded pool.
+ */
+using MemoryPoolAllocator = BasicMemoryPoolAllocator<>;
+
+/**
+ * @typedef ThreadCachedPoolAllocator
+ * @brief A pool that may be shared by any number of threads.
+ */
+using ThreadCachedPoolAllocator =
+    BasicMemoryPoolAllocator<ThreadCachedPoolTraits>;
+
+/**
+ * @typedef TaggedPoolAllocator
+ * @brief A pool isolated from every other by its tag, e.g.
+ * `TaggedPoolAllocator<struct ParserTag>`.
+ */
+template <class Tag, class Base = DefaultPoolTraits>
+using TaggedPoolAllocator =
+    BasicMemoryPoolAllocator<TaggedPoolTraits<Tag, Base>>;
+
 // Static member variable initializations
-inline char *MemoryPoolAllocator::freespacestart_ = nullptr;
-inline char *MemoryPoolAllocator::freespaceend_ = nullptr;
-inline std::size_t MemoryPoolAllocator::mallocoffset_ = 0;
-inline MemoryPoolList MemoryPoolAllocator::freelist_[kFreeListNum];
+template <class Traits>
+char *BasicMemoryPoolAllocator<Traits>::freespacestart_ = nullptr;
+template <class Traits>
+char *BasicMemoryPoolAllocator<Traits>::freespaceend_ = nullptr;
+template <class Traits>
+std::size_t BasicMemoryPoolAllocator<Traits>::mallocoffset_ = 0;
+template <class Traits>
+thread_local bool BasicMemoryPoolAllocator<Traits>::carving_ = false;
+template <class Traits>
+typename BasicMemoryPoolAllocator<Traits>::CentralList
+    BasicMemoryPoolAllocator<Traits>::freelist_[kClassNum];
+template <class Traits> std::mutex BasicMemoryPoolAllocator<Traits>::mutex_;
+template <class Traits>
+typename BasicMemoryPoolAllocator<Traits>::ChunkHeader
+    *BasicMemoryPoolAllocator<Traits>::chunks_ = nullptr;
+template <class Traits>
+typename BasicMemoryPoolAllocator<Traits>::ChunkHeader
+    *BasicMemoryPoolAllocator<Traits>::idlechunks_ = nullptr;
+template <class Traits>
+typename BasicMemoryPoolAllocator<Traits>::Counter
+    BasicMemoryPoolAllocator<Traits>::cachedbytes_{0};
+template <class Traits>
+typename BasicMemoryPoolAllocator<Traits>::Counter
+    BasicMemoryPoolAllocator<Traits>::nexttrim_{Traits::kTrimThreshold};
+template <class Traits>
+typename BasicMemoryPoolAllocator<Traits>::ClassCounters
+    BasicMemoryPoolAllocator<Traits>::counters_[kClassNum];
+template <class Traits>
+typename BasicMemoryPoolAllocator<Traits>::RefillPolicy::State
+    BasicMemoryPoolAllocator<Traits>::refillstate_[kClassNum];
+template <class Traits>
+typename BasicMemoryPoolAllocator<Traits>::CentralList
+    BasicMemoryPoolAllocator<Traits>::alignedlists_[kAlignFamilies]
+                                                   [kClassNum];
+template <class Traits>
+typename BasicMemoryPoolAllocator<Traits>::RefillPolicy::State
+    BasicMemoryPoolAllocator<Traits>::alignedrefillstate_[kAlignFamilies]
+                                                         [kClassNum];
+template <class Traits>
+typename BasicMemoryPoolAllocator<Traits>::Counter
+    BasicMemoryPoolAllocator<Traits>::largeallocations_{0};
+template <class Traits>
+typename BasicMemoryPoolAllocator<Traits>::Counter
+    BasicMemoryPoolAllocator<Traits>::largedeallocations_{0};
+
+template <class Traits>
+auto BasicMemoryPoolAllocator<Traits>::AllocateBatch(const std::size_t size,
+                                                     const std::size_t n,
+                                                     void **out)
+    -> std::size_t {
+  std::size_t got = 0;
+  if constexpr (kWrapped) {
+    // Every block is guarded, checked or given a header on its own.
+    for (; got < n; ++got) {
+      out[got] = Allocate(size);
+      if (out[got] == nullptr) {
+        break;
+      }
+    }
+    return got;
+  }
+  if (size > SizeClasses::kMaxBytes) {
+    for (; got < n; ++got) {
+      out[got] = MallocAllocator::Allocate(size);
+      if (out[got] == nullptr) {
+        break;
+      }
+    }
+    if constexpr (Traits::kStats) {
+      largeallocations_ += got;
+    }
+    return got;
+  }
+  const std::size_t index = SizeClasses::Index(size);
+  if constexpr (Traits::kThreadCache) {
+    ThreadCache &cache = LocalCache();
+    while (got < n) {
+      const std::size_t nums = cache.lists[index].PopInto(out + got, n - got);
+      cache.counts[index] -= nums;
+      got += nums;
+      if (got < n) {
+        out[got] = FetchFromCentral(cache, index);
+        if (out[got] == nullptr) {
+          break;
+        }
+        ++got;
+      }
+    }
+  } else {
+    got = freelist_[index].PopInto(out, n);
+    NoteCentralPop(index, got);
+    // Carve whatever is missing directly, bypassing the free list.
+    const std::size_t blocksize = SizeClasses::Size(index);
+    while (got < n) {
+      std::size_t chunknums = n - got;
+      char *block = ChunkAlloc(blocksize, chunknums);
+      if (block == nullptr) {
+        break;
+      }
+      if constexpr (Traits::kStats) {
+        ++counters_[index].refills;
+      }
+      for (std::size_t i = 0; i < chunknums; ++i) {
+        out[got++] = block;
+        block += blocksize;
+      }
+    }
+  }
+  if constexpr (Traits::kStats) {
+    counters_[index].allocations += got;
+  }
+  return got;
+}
+
+template <class Traits>
+auto BasicMemoryPoolAllocator<Traits>::DeallocateBatch(const std::size_t size,
+                                                       const std::size_t n,
+                                                       void *const *ptrs)
+    -> void {
+  if constexpr (kWrapped) {
+    for (std::size_t i = 0; i < n; ++i) {
+      Deallocate(ptrs[i], size);
+    }
+    return;
+  }
+  if (size > SizeClasses::kMaxBytes) {
+    for (std::size_t i = 0; i < n; ++i) {
+      MallocAllocator::Deallocate(ptrs[i], size);
+    }
+    if constexpr (Traits::kStats) {
+      largedeallocations_ += n;
+    }
+    return;
+  }
+  const std::size_t index = SizeClasses::Index(size);
+  if constexpr (Traits::kStats) {
+    counters_[index].deallocations += n;
+  }
+  if constexpr (Traits::kThreadCache) {
+    ThreadCache &cache = LocalCache();
+    for (std::size_t i = 0; i < n; ++i) {
+      cache.lists[index].Push(ptrs[i]);
+    }
+    cache.counts[index] += n;
+    if (cache.counts[index] > Traits::kCacheCapacity) {
+      // Drain the overflow plus one batch with a single splice.
+      ReleaseToCentral(cache, index,
+                       cache.counts[index] - Traits::kCacheCapacity +
+                           Traits::kCacheBatch);
+    }
+  } else {
+    for (std::size_t i = 0; i < n; ++i) {
+      freelist_[index].Push(ptrs[i]);
+    }
+    NoteCentralPush(index, n);
+  }
+  if constexpr (kTrackCachedBytes) {
+    if (cachedbytes_ > nexttrim_) {
+      Trim();
+    }
+  }
+}
+
+template <class Traits>
+auto BasicMemoryPoolAllocator<Traits>::Reallocate(void *obj,
+                                                  const std::size_t oldsize,
+                                                  const std::size_t newsize)
+    -> void * {
+  if (obj == nullptr) {
+    return Allocate(newsize);
+  }
+  const std::size_t oldblock = BlockSize(oldsize);
+  const std::size_t newblock = BlockSize(newsize);
+  // Hardened blocks are never resized in place, so the guard moves with them;
+  // neither are blocks with a size header, which records the exact size.
+  // Large blocks come from malloc, whose block size BlockSize does not know.
+  if (kResizeInPlace && oldsize > SizeClasses::kMaxBytes &&
+      newsize > SizeClasses::kMaxBytes) {
+    return MallocAllocator::Reallocate(obj, oldsize, newsize);
+  }
+  if (kResizeInPlace && oldsize <= SizeClasses::kMaxBytes &&
+      newsize <= SizeClasses::kMaxBytes && newblock == oldblock) {
+    PoolHardening::OnAllocate<false>(obj, newsize, PoolBlockSize(newsize));
+    return obj;
+  }
+  if constexpr (!Traits::kThreadCache && kResizeInPlace) {
+    // The last block carved from the current chunk can move its end.
+    auto *block = static_cast<char *>(obj);
+    if (oldsize <= SizeClasses::kMaxBytes &&
+        newsize <= SizeClasses::kMaxBytes &&
+        block + oldblock == freespacestart_ &&
+        block + newblock <= freespaceend_) {
+      freespacestart_ = block + newblock;
+      PoolHardening::OnAllocate<false>(obj, newsize, newblock);
+      if constexpr (Traits::kStats) {
+        ++counters_[SizeClasses::Index(oldsize)].deallocations;
+        ++counters_[SizeClasses::Index(newsize)].allocations;
+      }
+      return obj;
+    }
+  }
+  void *result = Allocate(newsize);
+  if (result != nullptr) {
+    std::memcpy(result, obj, oldsize < newsize ? oldsize : newsize);
+    Deallocate(obj, oldsize);
+  }
+  return result;
+}
+
+template <class Traits>
+auto BasicMemoryPoolAllocator<Traits>::Allocate(const std::size_t size,
+                                                const std::size_t align)
+    -> void * {
+  if (align <= kAlign) {
+    return Allocate(size);
+  }
+  if constexpr (kWrapped) {
+    return WrappedAllocate(size, align);
+  } else {
+    return RawAllocate(size, align);
+  }
+}
+
+template <class Traits>
+auto BasicMemoryPoolAllocator<Traits>::Deallocate(void *obj,
+                                                  const std::size_t size,
+                                                  const std::size_t align)
+    -> void {
+  if (align <= kAlign) {
+    Deallocate(obj, size);
+  } else if constexpr (kWrapped) {
+    WrappedDeallocate(obj, size, align);
+  } else {
+    RawDeallocate(obj, size, align);
+  }
+}
+
+template <class Traits>
+auto BasicMemoryPoolAllocator<Traits>::WrappedAllocate(const std::size_t size,
+                                                       const std::size_t align)
+    -> void * {
+  const std::size_t header = HeaderSize(size, align);
+  const std::size_t inner = header + size; // The canary follows the header.
+  void *block;
+  std::size_t blocksize;
+  if (align > kAlign) {
+    block = RawAllocate(GuardedSize(inner), align);
+    blocksize = AlignedBlockSize(GuardedSize(inner), align);
+  } else {
+    block = RawAllocate(GuardedSize(inner));
+    blocksize = PoolBlockSize(GuardedSize(inner));
+  }
+  PoolHardening::OnAllocate<kHardened>(block, inner, blocksize);
+  if (block == nullptr) {
+    return nullptr;
+  }
+  char *obj = static_cast<char *>(block) + header;
+  if constexpr (Traits::kSizeHeader) {
+    StoreHeader(obj, size, align);
+  }
+  return obj;
+}
+
+template <class Traits>
+auto BasicMemoryPoolAllocator<Traits>::WrappedDeallocate(void *obj,
+                                                         std::size_t size,
+                                                         std::size_t align)
+    -> void {
+  if constexpr (Traits::kSizeHeader) {
+    const std::uint64_t stored = LoadHeader(obj);
+    const std::size_t storedalign = HeaderToAlign(stored);
+    if (HeaderToSize(stored) != size ||
+        (storedalign > kAlign) != (align > kAlign) ||
+        (align > kAlign && storedalign != align)) {
+      PoolHardening::Report("pool block freed with the wrong size", obj);
+      size = HeaderToSize(stored); // Free it where it really belongs.
+      align = storedalign;
+    }
+  }
+  const std::size_t header = HeaderSize(size, align);
+  const std::size_t inner = header + size;
+  void *block = static_cast<char *>(obj) - header;
+  if (align > kAlign) {
+    if (PoolHardening::OnDeallocate<kHardened>(
+            block, inner, AlignedBlockSize(GuardedSize(inner), align))) {
+      RawDeallocate(block, GuardedSize(inner), align);
+    }
+  } else if (PoolHardening::OnDeallocate<kHardened>(
+                 block, inner, PoolBlockSize(GuardedSize(inner)))) {
+    RawDeallocate(block, GuardedSize(inner));
+  }
+}
+
+template <class Traits>
+auto BasicMemoryPoolAllocator<Traits>::RawAllocate(const std::size_t size,
+                                                   const std::size_t align)
+    -> void * {
+  if (!IsPoolAligned(size, align)) {
+    if constexpr (Traits::kStats) {
+      ++largeallocations_;
+    }
+    return MallocAllocator::Allocate(size, align);
+  }
+  const std::size_t index = SizeClasses::Index((size + align - 1) &
+                                               ~(align - 1));
+  if constexpr (Traits::kStats) {
+    ++counters_[index].allocations;
+  }
+  CentralList &list = alignedlists_[AlignFamily(align)][index];
+  if constexpr (Traits::kThreadCache) {
+    if (void *result = list.Pop()) {
+      return result;
+    }
+  } else if (!list.Empty()) {
+    return list.Pop();
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_, std::defer_lock);
+  if constexpr (Traits::kThreadCache) {
+    lock.lock();
+  }
+  const std::size_t stride = AlignedStride(index, align);
+  std::size_t chunknums = RefillPolicy::Next(
+      alignedrefillstate_[AlignFamily(align)][index], stride);
+  char *block = ChunkAlloc(stride, chunknums, align);
+  for (std::size_t i = 1; i < chunknums; ++i) {
+    list.Push(block + i * stride);
+  }
+  if constexpr (Traits::kStats) {
+    ++counters_[index].refills;
+  }
+  return block;
+}
+
+template <class Traits>
+auto BasicMemoryPoolAllocator<Traits>::RawDeallocate(void *obj,
+                                                     const std::size_t size,
+                                                     const std::size_t align)
+    -> void {
+  if (!IsPoolAligned(size, align)) {
+    if constexpr (Traits::kStats) {
+      ++largedeallocations_;
+    }
+    MallocAllocator::Deallocate(obj, size, align);
+    return;
+  }
+  const std::size_t index = SizeClasses::Index((size + align - 1) &
+                                               ~(align - 1));
+  if constexpr (Traits::kStats) {
+    ++counters_[index].deallocations;
+  }
+  alignedlists_[AlignFamily(align)][index].Push(obj);
+}
+
+template <class Traits>
+auto BasicMemoryPoolAllocator<Traits>::Reallocate(void *obj,
+                                                  const std::size_t oldsize,
+                                                  const std::size_t newsize,
+                                                  const std::size_t align)
+    -> void * {
+  if (align <= kAlign) {
+    return Reallocate(obj, oldsize, newsize);
+  }
+  if (obj == nullptr) {
+    return Allocate(newsize, align);
+  }
+  const bool oldpool = IsPoolAligned(oldsize, align);
+  const bool newpool = IsPoolAligned(newsize, align);
+  if (kResizeInPlace && !oldpool && !newpool) {
+    return MallocAllocator::Reallocate(obj, oldsize, newsize, align);
+  }
+  if (kResizeInPlace && oldpool && newpool &&
+      SizeClasses::Index((oldsize + align - 1) & ~(align - 1)) ==
+          SizeClasses::Index((newsize + align - 1) & ~(align - 1))) {
+    PoolHardening::OnAllocate<false>(obj, newsize,
+                                     AlignedBlockSize(newsize, align));
+    return obj;
+  }
+  void *result = Allocate(newsize, align);
+  if (result != nullptr) {
+    std::memcpy(result, obj, oldsize < newsize ? oldsize : newsize);
+    Deallocate(obj, oldsize, align);
+  }
+  return result;
+}
 
-inline auto MemoryPoolAllocator::ChunkAlloc(const std::size_t size,
-                                            std::size_t &chunknums) -> char * {
+template <class Traits>
+auto BasicMemoryPoolAllocator<Traits>::ChunkAlloc(const std::size_t size,
+                                                  std::size_t &chunknums,
+                                                  const std::size_t align)
+    -> char * {
   char *result;
   std::size_t bytesneed = size * chunknums;
-  const std::size_t bytesleft =
+  std::size_t bytesleft =
       static_cast<std::size_t>(freespaceend_ - freespacestart_);
+  if (align > kAlign) {
+    // Skip to an aligned address; the skipped bytes become small blocks.
+    const std::size_t pad = AlignPad(freespacestart_, align);
+    if (bytesleft >= pad + size) {
+      PushRemnant(freespacestart_, freespacestart_ + pad);
+      freespacestart_ += pad;
+      bytesleft -= pad;
+    } else {
+      bytesleft = 0; // Not even one aligned block fits; take a new chunk.
+    }
+  }
   if (bytesleft >= bytesneed) {
     result = freespacestart_;     // Enough space available
     freespacestart_ += bytesneed; // Update start pointer
@@ -184,44 +1284,391 @@ inline auto MemoryPoolAllocator::ChunkAlloc(const std::size_t size,
   }
 
   // Allocate a larger chunk if not enough space is left.
-  const std::size_t bytesget = bytesneed * 2 + RoundUp(mallocoffset_ >> 4);
-  if (bytesleft >= kAlign) {
-    freelist_[GetFreelistIndex(bytesleft)].Push(
-        freespacestart_); // Push remaining space to freelist.
-  }
-  freespacestart_ = static_cast<char *>(malloc(bytesget)); // Allocate new chunk
+  std::size_t bytesget = bytesneed * 2 + RoundUp(mallocoffset_ >> 4) +
+                         (align > kAlign ? align : 0);
+  // Push remaining space to the freelists, largest fitting class first.
+  PushRemnant(freespacestart_, freespaceend_);
+  freespaceend_ = freespacestart_; // Consumed, even if NewChunk throws.
+  freespacestart_ = NewChunk(bytesget); // Allocate new chunk
   if (freespacestart_ == nullptr) {
     // Try to get space from freelists if allocation fails
-    for (std::size_t i = size; i <= kMaxBytes; i += kAlign) {
-      if (!freelist_[GetFreelistIndex(i)].Empty()) {
-        freespacestart_ =
-            static_cast<char *>(freelist_[GetFreelistIndex(i)].Pop());
-        freespaceend_ = freespacestart_ + i;
-        return ChunkAlloc(size, chunknums); // Retry allocation
+    for (std::size_t i = SizeClasses::Index(size); i < kClassNum; ++i) {
+      if (!freelist_[i].Empty()) {
+        freespacestart_ = static_cast<char *>(freelist_[i].Pop());
+        // A thread cache may have emptied a lock-free list since the check.
+        if (freespacestart_ != nullptr) {
+          if (align > kAlign && AlignPad(freespacestart_, align) + size >
+                                    SizeClasses::Size(i)) {
+            // Too misaligned to hold an aligned block; carving it again would
+            // only push it back here. Leave it and try a larger class.
+            freelist_[i].Push(freespacestart_);
+            continue;
+          }
+          NoteCentralPop(i, 1);
+          freespaceend_ = freespacestart_ + SizeClasses::Size(i);
+          if constexpr (kChecked) {
+            // The block is carved again; drop its poison and free mark.
+            EASYSTL_UNPOISON_MEMORY_REGION(freespacestart_,
+                                           SizeClasses::Size(i));
+            std::memset(freespacestart_, 0, SizeClasses::Size(i));
+          }
+          return ChunkAlloc(size, chunknums, align); // Retry allocation
+        }
       }
     }
     freespaceend_ = nullptr;
-    freespacestart_ = static_cast<char *>(
-        MallocAllocator::Allocate(bytesget)); // Fallback to MallocAllocator
+    chunknums = 0;
+    return nullptr; // Out of memory even after the OOM handler ran.
+  }
+  freespaceend_ = freespacestart_ + bytesget;  // Update the end pointer
+  return ChunkAlloc(size, chunknums, align); // Retry allocation
+}
+
+template <class Traits>
+auto BasicMemoryPoolAllocator<Traits>::PushRemnant(char *begin,
+                                                   const char *end) -> void {
+  for (std::size_t index = kClassNum; index-- > 0;) {
+    while (static_cast<std::size_t>(end - begin) >= SizeClasses::Size(index)) {
+      freelist_[index].Push(begin);
+      begin += SizeClasses::Size(index);
+      NoteCentralPush(index, 1);
+    }
+  }
+}
+
+template <class Traits>
+auto BasicMemoryPoolAllocator<Traits>::NewChunk(std::size_t &bytes) -> char * {
+  ChunkHeader *chunk = nullptr;
+  if constexpr (Traits::kThreadCache) {
+    for (ChunkHeader **idle = &idlechunks_; *idle != nullptr;
+         idle = &(*idle)->next) {
+      if ((*idle)->size - kChunkHeaderSize >= bytes) {
+        chunk = *idle;
+        *idle = chunk->next;
+        break;
+      }
+    }
+  }
+  if (chunk == nullptr) {
+    std::size_t size = kChunkHeaderSize + bytes;
+    // A failing source runs the MemoryPressure callbacks; ShedMemory must not
+    // trim this pool from inside its own carving.
+    struct CarvingScope {
+      CarvingScope() { carving_ = true; }
+      ~CarvingScope() { carving_ = false; }
+    } scope;
+    void *memory = ChunkSource::Allocate(size);
+    if (memory == nullptr) {
+      return nullptr;
+    }
+    chunk = static_cast<ChunkHeader *>(memory);
+    chunk->size = size;
+  }
+  LinkChunk(chunks_, chunk);
+  mallocoffset_ += chunk->size; // Update offset for tracking
+  bytes = chunk->size - kChunkHeaderSize;
+  return reinterpret_cast<char *>(chunk) + kChunkHeaderSize;
+}
+
+template <class Traits>
+auto BasicMemoryPoolAllocator<Traits>::LinkChunk(ChunkHeader *&list,
+                                                 ChunkHeader *chunk) -> void {
+  ChunkHeader **pos = &list;
+  while (*pos != nullptr && *pos < chunk) {
+    pos = &(*pos)->next;
+  }
+  chunk->next = *pos;
+  *pos = chunk;
+}
+
+template <class Traits>
+auto BasicMemoryPoolAllocator<Traits>::FindChunk(ChunkHeader **chunks,
+                                                 std::size_t nums,
+                                                 const void *ptr)
+    -> ChunkHeader * {
+  const auto *addr = static_cast<const char *>(ptr);
+  std::size_t low = 0;
+  while (nums > 0) {
+    const std::size_t half = nums / 2;
+    if (reinterpret_cast<const char *>(chunks[low + half]) <= addr) {
+      low += half + 1;
+      nums -= half + 1;
+    } else {
+      nums = half;
+    }
+  }
+  if (low == 0) {
+    return nullptr;
+  }
+  ChunkHeader *chunk = chunks[low - 1];
+  return addr < reinterpret_cast<const char *>(chunk) + chunk->size ? chunk
+                                                                    : nullptr;
+}
+
+template <class Traits>
+auto BasicMemoryPoolAllocator<Traits>::Trim() -> std::size_t {
+  if constexpr (Traits::kThreadCache) {
+    ThreadCache &cache = LocalCache();
+    for (std::size_t i = 0; i < kClassNum; ++i) {
+      ReleaseToCentral(cache, i, cache.counts[i]);
+    }
+  }
+  std::unique_lock<std::mutex> lock(mutex_, std::defer_lock);
+  if constexpr (Traits::kThreadCache) {
+    lock.lock();
+  }
+  return TrimLocked();
+}
+
+template <class Traits>
+auto BasicMemoryPoolAllocator<Traits>::ShedMemory(void * /*context*/,
+                                                  std::size_t /*bytes*/)
+    -> std::size_t {
+  if (carving_) {
+    return 0;
+  }
+  if constexpr (Traits::kThreadCache) {
+    ThreadCache &cache = LocalCache();
+    for (std::size_t i = 0; i < kClassNum; ++i) {
+      ReleaseToCentral(cache, i, cache.counts[i]);
+    }
+    // The lock holder may itself be waiting for the MemoryPressure registry.
+    std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+    if (!lock.owns_lock()) {
+      return 0;
+    }
+    return TrimLocked();
+  } else {
+    return TrimLocked();
+  }
+}
+
+template <class Traits>
+auto BasicMemoryPoolAllocator<Traits>::TrimLocked() -> std::size_t {
+  std::size_t chunknums = 0;
+  for (ChunkHeader *chunk = chunks_; chunk != nullptr; chunk = chunk->next) {
+    chunk->freebytes = 0;
+    ++chunknums;
+  }
+  if (chunknums == 0) {
+    return 0;
+  }
+  auto **sorted =
+      static_cast<ChunkHeader **>(malloc(chunknums * sizeof(ChunkHeader *)));
+  if (sorted == nullptr) {
+    return 0;
+  }
+  std::size_t pos = 0;
+  for (ChunkHeader *chunk = chunks_; chunk != nullptr; chunk = chunk->next) {
+    sorted[pos++] = chunk;
+  }
+
+  // The uncarved space counts as free for the chunk it belongs to.
+  if (ChunkHeader *chunk = FindChunk(sorted, chunknums, freespacestart_)) {
+    chunk->freebytes +=
+        static_cast<std::size_t>(freespaceend_ - freespacestart_);
+  }
+
+  // Detach every central list and charge its blocks to their chunks.
+  void *heads[kClassNum];
+  std::size_t detached[kClassNum] = {};
+  for (std::size_t i = 0; i < kClassNum; ++i) {
+    heads[i] = freelist_[i].PopAll();
+    for (void *node = heads[i]; node != nullptr;
+         node = LocalList::Next(node)) {
+      ++detached[i];
+      if (ChunkHeader *chunk = FindChunk(sorted, chunknums, node)) {
+        chunk->freebytes += SizeClasses::Size(i);
+      }
+    }
+  }
+
+  // Put back the blocks of every chunk that is still partly in use. Thread
+  // caches push and pop concurrently, so the counters only lose the blocks
+  // that were dropped rather than being overwritten.
+  for (std::size_t i = 0; i < kClassNum; ++i) {
+    if (heads[i] != nullptr) {
+      RefillPolicy::Idle(refillstate_[i]); // The class carved too much.
+    }
+    std::size_t kept = 0;
+    void *node = heads[i];
+    while (node != nullptr) {
+      void *next = LocalList::Next(node);
+      ChunkHeader *chunk = FindChunk(sorted, chunknums, node);
+      if (chunk == nullptr ||
+          chunk->freebytes != chunk->size - kChunkHeaderSize) {
+        freelist_[i].Push(node);
+        ++kept;
+      }
+      node = next;
+    }
+    NoteCentralPop(i, detached[i] - kept);
+  }
+  free(sorted);
+
+  // Release the chunks that are entirely free.
+  std::size_t released = 0;
+  ChunkHeader **link = &chunks_;
+  while (*link != nullptr) {
+    ChunkHeader *chunk = *link;
+    if (chunk->freebytes != chunk->size - kChunkHeaderSize) {
+      link = &chunk->next;
+      continue;
+    }
+    *link = chunk->next;
+    char *begin = reinterpret_cast<char *>(chunk);
+    if (freespacestart_ >= begin && freespacestart_ < begin + chunk->size) {
+      freespacestart_ = freespaceend_ = nullptr;
+    }
+    released += chunk->size;
+    mallocoffset_ -= chunk->size;
+    EASYSTL_UNPOISON_MEMORY_REGION(begin, chunk->size);
+    if constexpr (kHardened) {
+      // Free marks must not survive into whoever reuses the memory next.
+      std::memset(begin + kChunkHeaderSize, 0, chunk->size - kChunkHeaderSize);
+    }
+    if constexpr (Traits::kThreadCache) {
+      DecommitPages(begin + kChunkHeaderSize, chunk->size - kChunkHeaderSize);
+      LinkChunk(idlechunks_, chunk);
+    } else {
+      ChunkSource::Deallocate(chunk, chunk->size);
+    }
+  }
+
+  if constexpr (kTrackCachedBytes) {
+    nexttrim_ = cachedbytes_ + Traits::kTrimThreshold;
+  }
+  return released;
+}
+
+template <class Traits>
+auto BasicMemoryPoolAllocator<Traits>::Release() -> std::size_t
+  requires(!Traits::kThreadCache)
+{
+  // Drop the central blocks while their chunks are still there to walk.
+  for (std::size_t i = 0; i < kClassNum; ++i) {
+    std::size_t dropped = 0;
+    for (void *node = freelist_[i].PopAll(); node != nullptr;
+         node = LocalList::Next(node)) {
+      ++dropped;
+    }
+    NoteCentralPop(i, dropped);
+  }
+  std::size_t released = 0;
+  while (chunks_ != nullptr) {
+    ChunkHeader *chunk = chunks_;
+    chunks_ = chunk->next;
+    released += chunk->size;
+    EASYSTL_UNPOISON_MEMORY_REGION(chunk, chunk->size);
+    if constexpr (kHardened) {
+      // Free marks must not survive into whoever reuses the memory next.
+      std::memset(reinterpret_cast<char *>(chunk) + kChunkHeaderSize, 0,
+                  chunk->size - kChunkHeaderSize);
+    }
+    ChunkSource::Deallocate(chunk, chunk->size);
+  }
+  freespacestart_ = freespaceend_ = nullptr;
+  mallocoffset_ = 0;
+  for (std::size_t i = 0; i < kClassNum; ++i) {
+    refillstate_[i] = {};
+    for (std::size_t family = 0; family < kAlignFamilies; ++family) {
+      alignedlists_[family][i].PopAll();
+      alignedrefillstate_[family][i] = {};
+    }
+  }
+  if constexpr (kTrackCachedBytes) {
+    nexttrim_ = cachedbytes_ + Traits::kTrimThreshold;
+  }
+  return released;
+}
+
+template <class Traits>
+auto BasicMemoryPoolAllocator<Traits>::Stats()
+    -> PoolStats<Traits::SizeClasses::kNum>
+  requires(Traits::kStats)
+{
+  PoolStats<kClassNum> stats;
+  for (std::size_t i = 0; i < kClassNum; ++i) {
+    stats.classes[i].size = SizeClasses::Size(i);
+    stats.classes[i].allocations = counters_[i].allocations;
+    stats.classes[i].deallocations = counters_[i].deallocations;
+    stats.classes[i].refills = counters_[i].refills;
+    stats.classes[i].cachedblocks = counters_[i].cachedblocks;
+  }
+  stats.largeallocations = largeallocations_;
+  stats.largedeallocations = largedeallocations_;
+
+  std::unique_lock<std::mutex> lock(mutex_, std::defer_lock);
+  if constexpr (Traits::kThreadCache) {
+    lock.lock();
+  }
+  for (ChunkHeader *chunk = chunks_; chunk != nullptr; chunk = chunk->next) {
+    ++stats.chunks;
   }
-  mallocoffset_ += bytesget;                  // Update offset for tracking
-  freespaceend_ = freespacestart_ + bytesget; // Update the end pointer
-  return ChunkAlloc(size, chunknums);         // Retry allocation
+  stats.systembytes = mallocoffset_;
+  return stats;
 }
 
-inline auto MemoryPoolAllocator::Refill(const std::size_t size) -> void * {
-  std::size_t chunknums = 20;
+template <class Traits>
+auto BasicMemoryPoolAllocator<Traits>::Refill(const std::size_t size,
+                                              LocalList &list,
+                                              std::size_t &chunknums)
+    -> void * {
   char *chunk = ChunkAlloc(size, chunknums);
-  char *nextchunk = chunk + size;
-  if (chunknums == 1) {
+  if (chunk == nullptr || chunknums <= 1) {
     return chunk;
   }
+  char *nextchunk = chunk + size;
   for (int i = 1; i < static_cast<int>(chunknums); i++) {
-    freelist_[GetFreelistIndex(size)].Push(nextchunk);
+    list.Push(nextchunk);
     nextchunk += size;
   }
   return chunk;
 }
+
+template <class Traits>
+auto BasicMemoryPoolAllocator<Traits>::FetchFromCentral(
+    ThreadCache &cache, const std::size_t index) -> void * {
+  const std::size_t size = SizeClasses::Size(index);
+  void *result = freelist_[index].Pop();
+  if (result != nullptr) {
+    std::size_t moved = 1;
+    for (; moved < Traits::kCacheBatch; ++moved) {
+      void *node = freelist_[index].Pop();
+      if (node == nullptr) {
+        break;
+      }
+      cache.lists[index].Push(node);
+      ++cache.counts[index];
+    }
+    NoteCentralPop(index, moved);
+    return result;
+  }
+  const std::lock_guard<std::mutex> lock(mutex_);
+  std::size_t chunknums = RefillPolicy::Next(refillstate_[index], size);
+  result = Refill(size, cache.lists[index], chunknums);
+  if (result != nullptr) {
+    cache.counts[index] += chunknums - 1;
+  }
+  if constexpr (Traits::kStats) {
+    ++counters_[index].refills;
+  }
+  return result;
+}
+
+template <class Traits>
+auto BasicMemoryPoolAllocator<Traits>::ReleaseToCentral(ThreadCache &cache,
+                                                        const std::size_t index,
+                                                        std::size_t nums)
+    -> void {
+  void *last;
+  void *first = cache.lists[index].PopList(nums, last);
+  if (first != nullptr) {
+    freelist_[index].PushList(first, last); // One CAS for the whole batch.
+    cache.counts[index] -= nums;
+    NoteCentralPush(index, nums);
+  }
+}
 } // namespace easystl
 
 #endif // !EASYSTL_MEMORY_POOL_ALLOCATOR_H_
@@ -0,0 +1,130 @@
+#pragma once
+
+#ifndef EASYSTL_MEMORY_POOL_LIST_H_
+#define EASYSTL_MEMORY_POOL_LIST_H_
+
+#include <atomic>
+#include <cstddef>
+
+#include "pool_hardening.h"
+
+namespace easystl {
+/**
+ * @class BasicMemoryPoolList
+ * @brief A linked list used for managing free nodes in the memory pool.
+ * Each node contains a pointer to the next node, facilitating the allocation
+ * and deallocation of memory.
+ * @tparam Link How the next pointer is stored, PlainLink or ObfuscatedLink.
+ */
+template <class Link = PlainLink> class BasicMemoryPoolList {
+public:
+  /**
+   * @brief Checks if the list is empty.
+   * @return `true` if the list is empty, `false` otherwise.
+   */
+  [[nodiscard]] auto Empty() const -> bool { return node_ == nullptr; }
+  /**
+   * @brief Retrieves the next node in the list.
+   * @param node Pointer to the current node.
+   * @return Reference to the next node pointer.
+   */
+  static auto GetNextNode(void *node) -> void *& {
+    return *static_cast<void **>(node);
+  }
+
+  /**
+   * @brief Reads and decodes the link of a node.
+   * @param node Pointer to the current node.
+   * @return Pointer to the next node.
+   */
+  static auto Next(void *node) -> void * {
+    void *next = Link::Decode(&GetNextNode(node), GetNextNode(node));
+    Link::Check(next);
+    return next;
+  }
+
+  /**
+   * @brief Pushed a node onto the front of the list. The link is written as
+   * a relaxed atomic store (a plain store on common targets) because a
+   * lock-free Pop on a central list may still be reading the link of a block
+   * that another thread has just won.
+   * @param node Pointer to the node to be added.
+   */
+  auto Push(void *node) -> void {
+    std::atomic_ref<void *>(GetNextNode(node))
+        .store(Link::Encode(&GetNextNode(node), node_),
+               std::memory_order_relaxed);
+    node_ = node;
+  }
+
+  /**
+   * @brief Pops a node from the front of the list.
+   * @return Pointer to the node that was removed from the list.
+   */
+  auto Pop() -> void * {
+    void *result = node_;
+    node_ = Next(result);
+    return result;
+  }
+
+  /**
+   * @brief Detaches up to `nums` nodes from the front of the list. The
+   * detached nodes stay linked to each other.
+   * @param nums The maximum number of nodes to detach; updated to the number
+   * actually detached.
+   * @param last Set to the last node of the detached chain.
+   * @return Pointer to the first node of the chain, or `nullptr` if empty.
+   */
+  auto PopList(std::size_t &nums, void *&last) -> void * {
+    void *first = node_;
+    std::size_t count = 0;
+    last = nullptr;
+    while (count < nums && node_ != nullptr) {
+      last = node_;
+      node_ = Next(node_);
+      ++count;
+    }
+    nums = count;
+    return count == 0 ? nullptr : first;
+  }
+
+  /**
+   * @brief Pops up to `nums` nodes from the front of the list into an array.
+   * @param out Receives the nodes; must have room for `nums`.
+   * @param nums The maximum number of nodes to pop.
+   * @return The number of nodes popped.
+   */
+  auto PopInto(void **out, const std::size_t nums) -> std::size_t {
+    std::size_t count = 0;
+    void *node = node_;
+    while (count < nums && node != nullptr) {
+      out[count++] = node;
+      node = Next(node);
+    }
+    node_ = node;
+    return count;
+  }
+
+  /**
+   * @brief Detaches the whole list at once.
+   * @return Pointer to the first node of the detached chain, or `nullptr` if
+   * the list is empty.
+   */
+  auto PopAll() -> void * {
+    void *result = node_;
+    node_ = nullptr;
+    return result;
+  }
+
+private:
+  void *node_ = nullptr; ///< Pointer to the head of the linked list.
+};
+
+/**
+ * @typedef MemoryPoolList
+ * @brief A free list storing plain links.
+ */
+using MemoryPoolList = BasicMemoryPoolList<>;
+} // namespace easystl
+
+#endif // !EASYSTL_MEMORY_POOL_LIST_H_
@@ -0,0 +1,237 @@
+#pragma once
+
+#ifndef EASYSTL_OBJECT_POOL_H_
+#define EASYSTL_OBJECT_POOL_H_
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "allocator_wrapper.h"
+
+namespace easystl {
+/**
+ * @struct DestroyOnRecycle
+ * @brief ObjectPool reuse policy that destroys an object when it is recycled
+ * and constructs a new one on Create.
+ */
+struct DestroyOnRecycle {
+  static constexpr bool kKeepConstructed = false;
+};
+
+/**
+ * @struct KeepConstructed
+ * @brief ObjectPool reuse policy that keeps recycled objects alive, so the
+ * buffers and state they set up survive into the next Create. A recycled
+ * object is handed out again through `T::Reset(args...)` when `T` has such a
+ * member, and as it was left otherwise (then Create takes no arguments). New
+ * objects are constructed from the arguments, or default-constructed and
+ * Reset if `T` has no such constructor. Objects are destroyed only with the
+ * pool.
+ */
+struct KeepConstructed {
+  static constexpr bool kKeepConstructed = true;
+};
+
+/**
+ * @class ObjectPool
+ * @brief Hands out constructed objects of one type in O(1).
+ *
+ * Slots for the objects are carved from slabs of `kSlabBytes` obtained from
+ * `Allocator`, and recycled slots go onto an intrusive free list, so Create
+ * and Recycle never search and objects of the pool never interleave with
+ * other allocations. The pool keeps its slabs until it is destroyed. An
+ * ObjectPool is not synchronized: use one per thread, or guard it.
+ * @tparam T The type of the objects.
+ * @tparam Allocator The allocator the slabs come from (default is
+ * `DefaultAllocator`).
+ * @tparam Reuse DestroyOnRecycle or KeepConstructed.
+ */
+template <class T, class Allocator = DefaultAllocator,
+          class Reuse = DestroyOnRecycle>
+class ObjectPool {
+public:
+  static constexpr bool kKeepConstructed =
+      Reuse::kKeepConstructed; ///< Recycled objects stay alive.
+  static constexpr std::size_t kSlabBytes =
+      4096; ///< Target size of the slabs slots are carved from.
+
+  ObjectPool() = default;
+  /**
+   * @brief Creates a pool whose slabs come from a copy of `allocator`.
+   * @param allocator The allocator to use.
+   */
+  explicit ObjectPool(const Allocator &allocator) : slabs_(allocator) {}
+  ObjectPool(const ObjectPool &) = delete;
+  auto operator=(const ObjectPool &) -> ObjectPool & = delete;
+
+  /**
+   * @brief Destroys the objects kept constructed and frees every slab.
+   * Objects still in use must not be touched afterwards; their destructors
+   * do not run.
+   */
+  ~ObjectPool() {
+    if constexpr (kKeepConstructed) {
+      for (Slot *slot = free_; slot != nullptr; slot = slot->next) {
+        slot->Object()->~T();
+      }
+    }
+    while (slab_ != nullptr) {
+      Slab *next = slab_->next;
+      slabs_.Deallocate(slab_, 1);
+      slab_ = next;
+    }
+  }
+
+  /**
+   * @brief Hands out an object: a recycled one if any, a new one otherwise.
+   * @tparam Args The types of the constructor (or Reset) arguments.
+   * @param args The arguments to construct the object with; with
+   * KeepConstructed, recycled objects get them through `T::Reset`.
+   * @return Pointer to the object.
+   * @throws Whatever the allocator or the constructor throws; the pool is
+   * then unchanged.
+   */
+  template <class... Args> auto Create(Args &&...args) -> T * {
+    if constexpr (kKeepConstructed) {
+      if (free_ != nullptr) {
+        Slot *slot = free_;
+        T *object = slot->Object();
+        if constexpr (requires {
+                        object->Reset(std::forward<Args>(args)...);
+                      }) {
+          object->Reset(std::forward<Args>(args)...);
+        } else {
+          static_assert(sizeof...(Args) == 0,
+                        "kept objects take arguments only through T::Reset");
+        }
+        free_ = slot->next;
+        --available_;
+        ++live_;
+        return object;
+      }
+    }
+    Slot *slot = free_ != nullptr ? free_ : Carve();
+    Slot *next = slot->next;
+    T *object;
+    if constexpr (kKeepConstructed &&
+                  !std::is_constructible_v<T, Args &&...>) {
+      // Kept objects may only know how to Reset to the arguments.
+      object = ::new (static_cast<void *>(slot->storage)) T();
+      try {
+        object->Reset(std::forward<Args>(args)...);
+      } catch (...) {
+        object->~T();
+        throw;
+      }
+    } else {
+      object = ::new (static_cast<void *>(slot->storage))
+          T(std::forward<Args>(args)...);
+    }
+    if (slot == free_) {
+      free_ = next;
+      --available_;
+    } else {
+      ++carved_;
+    }
+    ++live_;
+    return object;
+  }
+
+  /**
+   * @brief Takes back an object obtained from Create of this pool.
+   * @param object The object; `nullptr` is ignored.
+   */
+  auto Recycle(T *object) -> void {
+    if (object == nullptr) {
+      return;
+    }
+    if constexpr (!kKeepConstructed) {
+      object->~T();
+    }
+    Slot *slot = reinterpret_cast<Slot *>(object);
+    slot->next = free_;
+    free_ = slot;
+    ++available_;
+    --live_;
+  }
+
+  /**
+   * @brief Returns the number of objects handed out and not recycled.
+   * @return The number of objects in use.
+   */
+  [[nodiscard]] auto Live() const -> std::size_t { return live_; }
+
+  /**
+   * @brief Returns the number of recycled slots ready for Create.
+   * @return The number of free slots, not counting uncarved slab space.
+   */
+  [[nodiscard]] auto Available() const -> std::size_t { return available_; }
+
+private:
+  struct Slot;
+  ///< Slot layout whose link shares the storage of the destroyed object.
+  struct SharedSlot {
+    union {
+      alignas(T) unsigned char storage[sizeof(T)];
+      Slot *next;
+    };
+  };
+  ///< Slot layout whose link follows the storage of the kept object.
+  struct SeparateSlot {
+    alignas(T) unsigned char storage[sizeof(T)];
+    Slot *next;
+  };
+  /**
+   * @struct Slot
+   * @brief Storage for one object plus its free-list link.
+   */
+  struct Slot
+      : std::conditional_t<kKeepConstructed, SeparateSlot, SharedSlot> {
+    auto Object() -> T * {
+      return std::launder(reinterpret_cast<T *>(this->storage));
+    }
+  };
+
+  static constexpr std::size_t kSlabSlots =
+      kSlabBytes / sizeof(Slot) > 1 ? kSlabBytes / sizeof(Slot)
+                                    : 1; ///< Slots per slab.
+
+  /**
+   * @struct Slab
+   * @brief A block of slots; the slabs form a list for the destructor.
+   */
+  struct Slab {
+    Slot slots[kSlabSlots]; ///< The slots, first so they keep T's alignment.
+    Slab *next;             ///< The slab obtained before this one.
+  };
+
+  /**
+   * @brief Takes the next uncarved slot, obtaining a slab when needed. The
+   * slot is not linked into the free list.
+   * @return The slot.
+   */
+  auto Carve() -> Slot * {
+    if (slab_ == nullptr || carved_ == kSlabSlots) {
+      Slab *slab = slabs_.Allocate(1);
+      slab->next = slab_;
+      slab_ = slab;
+      carved_ = 0;
+    }
+    Slot *slot = &slab_->slots[carved_];
+    slot->next = nullptr;
+    return slot;
+  }
+
+  [[no_unique_address]] AllocatorWrapper<Slab, Allocator>
+      slabs_;                   ///< Allocates the slabs.
+  Slab *slab_ = nullptr;        ///< The slab slots are carved from.
+  std::size_t carved_ = 0;      ///< Slots of `slab_` carved so far.
+  Slot *free_ = nullptr;        ///< Recycled slots.
+  std::size_t available_ = 0;   ///< Number of recycled slots.
+  std::size_t live_ = 0;        ///< Objects in use.
+};
+} // namespace easystl
+
+#endif // !EASYSTL_OBJECT_POOL_H_
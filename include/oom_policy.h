@@ -0,0 +1,162 @@
+#pragma once
+
+#ifndef EASYSTL_OOM_POLICY_H_
+#define EASYSTL_OOM_POLICY_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+
+namespace easystl {
+/**
+ * @enum OomAction
+ * @brief What an allocation does once every retry after running out of memory
+ * has failed.
+ */
+enum class OomAction {
+  kReturnNull, ///< Return `nullptr` to the caller.
+  kThrow,      ///< Throw `std::bad_alloc`.
+  kAbort,      ///< Call `std::abort`.
+};
+
+/**
+ * @struct OomPolicy
+ * @brief How MallocAllocator reacts when the system runs out of memory. Each
+ * retry runs the OOM handler and the MemoryPressure callbacks, waits for the
+ * backoff (doubling it every round) and tries again. Without a handler and
+ * without callbacks nothing can free memory, so the action is taken at once.
+ */
+struct OomPolicy {
+  int retries = 3; ///< Attempts after the first failure.
+  std::chrono::microseconds backoff{0}; ///< Wait before the first retry.
+  OomAction action = OomAction::kReturnNull; ///< Taken when retries run out.
+};
+
+/**
+ * @class MemoryPressure
+ * @brief A process-wide registry of callbacks that give memory back when an
+ * allocation fails: caches shed entries, pools trim their free lists (see
+ * BasicMemoryPoolAllocator::RegisterPressureTrim).
+ *
+ * Callbacks run in registration order, under the registry lock, on the thread
+ * whose allocation failed. An allocation failing inside a callback does not
+ * run the callbacks again: the registry reports no callbacks to that thread
+ * until they all returned, so the allocation takes its OOM action at once.
+ */
+class MemoryPressure {
+public:
+  ///< Releases memory; gets its context and the size of the failed request,
+  ///< returns the number of bytes it released (0 if unknown or none).
+  using Callback = std::size_t (*)(void *context, std::size_t bytes);
+
+  static constexpr std::size_t kMaxCallbacks =
+      16; ///< Capacity of the registry; nothing is allocated under pressure.
+
+  /**
+   * @brief Registers a callback.
+   * @param callback The callback.
+   * @param context Passed to the callback unchanged.
+   * @return An id for Unregister, or 0 if the registry is full.
+   */
+  static auto Register(const Callback callback, void *context) -> std::size_t {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    for (std::size_t i = 0; i < kMaxCallbacks; ++i) {
+      if (entries_[i].callback == nullptr) {
+        entries_[i] = {callback, context, ++nextorder_};
+        count_.fetch_add(1, std::memory_order_relaxed);
+        return i + 1;
+      }
+    }
+    return 0;
+  }
+
+  /**
+   * @brief Removes a callback; it is not running anymore when this returns.
+   * @param id The id returned by Register.
+   */
+  static auto Unregister(const std::size_t id) -> void {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    if (id != 0 && id <= kMaxCallbacks &&
+        entries_[id - 1].callback != nullptr) {
+      entries_[id - 1] = {};
+      count_.fetch_sub(1, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * @brief Checks whether any callback is registered that this thread may run.
+   * Takes no lock, so it is safe to call from inside a callback.
+   * @return `true` if there is at least one callback and this thread is not
+   * running the callbacks already.
+   */
+  static auto Registered() -> bool {
+    return !relieving_ && count_.load(std::memory_order_relaxed) != 0;
+  }
+
+  /**
+   * @brief Runs the callbacks in registration order until they released
+   * `bytes` (when they report it) or all of them ran.
+   * @param bytes The size of the failed request.
+   * @return The number of bytes the callbacks reported as released.
+   */
+  static auto Relieve(const std::size_t bytes) -> std::size_t {
+    if (relieving_) {
+      return 0; // A callback ran out of memory itself.
+    }
+    // Cleared on every way out, including a callback that throws.
+    struct RelievingScope {
+      RelievingScope() { relieving_ = true; }
+      ~RelievingScope() { relieving_ = false; }
+    } scope;
+    std::size_t released = 0;
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+      for (unsigned long long order = 0;;) {
+        const Entry *next = nullptr;
+        for (const Entry &entry : entries_) {
+          if (entry.callback != nullptr && entry.order > order &&
+              (next == nullptr || entry.order < next->order)) {
+            next = &entry;
+          }
+        }
+        if (next == nullptr) {
+          break;
+        }
+        order = next->order;
+        released += next->callback(next->context, bytes);
+        if (bytes != 0 && released >= bytes) {
+          break;
+        }
+      }
+    }
+    return released;
+  }
+
+private:
+  /**
+   * @struct Entry
+   * @brief A registered callback.
+   */
+  struct Entry {
+    Callback callback = nullptr;  ///< The callback, `nullptr` if unused.
+    void *context = nullptr;      ///< Passed to the callback.
+    unsigned long long order = 0; ///< Registration order.
+  };
+
+  static std::mutex mutex_;               ///< Guards the registry.
+  static Entry entries_[kMaxCallbacks];   ///< The registered callbacks.
+  static std::atomic<std::size_t> count_; ///< Number of used entries.
+  static unsigned long long nextorder_;   ///< Order of the last Register.
+  static thread_local bool
+      relieving_; ///< Whether this thread is running the callbacks.
+};
+
+inline std::mutex MemoryPressure::mutex_;
+inline MemoryPressure::Entry MemoryPressure::entries_[kMaxCallbacks];
+inline std::atomic<std::size_t> MemoryPressure::count_ = 0;
+inline unsigned long long MemoryPressure::nextorder_ = 0;
+inline thread_local bool MemoryPressure::relieving_ = false;
+} // namespace easystl
+
+#endif // !EASYSTL_OOM_POLICY_H_
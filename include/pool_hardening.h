@@ -0,0 +1,268 @@
+#pragma once
+
+#ifndef EASYSTL_POOL_HARDENING_H_
+#define EASYSTL_POOL_HARDENING_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Hardened pools are opt-in. Define `EASYSTL_POOL_HARDENED` for the whole
+// program to turn on the checks of every pool whose traits keep the default
+// `kHardened`. Without it the pool code is unchanged.
+#ifdef EASYSTL_POOL_HARDENED
+#define EASYSTL_POOL_HARDENED_DEFAULT true
+#else
+#define EASYSTL_POOL_HARDENED_DEFAULT false
+#endif
+
+// Under AddressSanitizer the pools poison the blocks they hold, so accesses to
+// freed blocks and past the requested size are reported like heap errors.
+#if defined(__SANITIZE_ADDRESS__)
+#define EASYSTL_ASAN 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define EASYSTL_ASAN 1
+#endif
+#endif
+
+#ifdef EASYSTL_ASAN
+#include <sanitizer/asan_interface.h>
+#define EASYSTL_POISON_MEMORY_REGION(addr, size)                               \
+  ASAN_POISON_MEMORY_REGION(addr, size)
+#define EASYSTL_UNPOISON_MEMORY_REGION(addr, size)                             \
+  ASAN_UNPOISON_MEMORY_REGION(addr, size)
+#define EASYSTL_ASAN_DEFAULT true
+#else
+#define EASYSTL_POISON_MEMORY_REGION(addr, size) ((void)(addr), (void)(size))
+#define EASYSTL_UNPOISON_MEMORY_REGION(addr, size)                             \
+  ((void)(addr), (void)(size))
+#define EASYSTL_ASAN_DEFAULT false
+#endif
+
+namespace easystl {
+/**
+ * @class PoolHardening
+ * @brief The checks behind hardened pools and the AddressSanitizer
+ * annotations of all pools.
+ *
+ * A hardened pool asks for kGuardSize more bytes than requested, and for at
+ * least two words, and writes a canary word right after the requested size,
+ * which is verified on free to catch buffer overflows. Freed blocks are filled
+ * with kPoisonByte and marked as free in their second word: a block freed
+ * again still carries the mark (a double free), and a block whose fill changed
+ * before it is handed out again was written after being freed. Free-list
+ * links are stored obfuscated, see ObfuscatedLink. Every detected error goes
+ * to the corruption handler, which by default prints it and aborts.
+ */
+class PoolHardening {
+public:
+  ///< Called with a description of the error and the block involved.
+  using CorruptionHandler = void (*)(const char *what, const void *block);
+
+  static constexpr std::size_t kGuardSize =
+      sizeof(std::uint64_t); ///< Extra bytes for the canary.
+  static constexpr std::uint64_t kCanary =
+      0x5a17c0debadc0ffeULL; ///< Canary word written after the request.
+  static constexpr unsigned char kPoisonByte = 0xdd; ///< Fill of freed blocks.
+
+  /**
+   * @brief Sets the handler called when a check fails. If the handler
+   * returns, the pool skips the faulty free (for a double free) or carries on.
+   * @param func The new handler, or `nullptr` to restore the default.
+   * @return The previous handler.
+   */
+  static auto SetCorruptionHandler(CorruptionHandler func)
+      -> CorruptionHandler {
+    CorruptionHandler old = handler_;
+    handler_ = func == nullptr ? &DefaultHandler : func;
+    return old;
+  }
+
+  /**
+   * @brief Reports a detected error to the corruption handler.
+   * @param what A description of the error.
+   * @param block The block involved.
+   */
+  static auto Report(const char *what, const void *block) -> void {
+    handler_(what, block);
+  }
+
+  /**
+   * @brief Returns the per-process secret that links and free marks are
+   * mixed with, so they cannot be forged without leaking it first.
+   * @return The secret.
+   */
+  static auto Key() -> std::uintptr_t {
+    static const std::uintptr_t key = MakeKey();
+    return key;
+  }
+
+  /**
+   * @brief Prepares a block that is about to be handed out.
+   * @tparam Hardened Whether to run the checks of a hardened pool.
+   * @param block The block, or `nullptr` (then nothing happens).
+   * @param size The requested size; the block holds `size + kGuardSize`
+   * bytes in a hardened pool.
+   * @param blocksize The size of the pool block, or 0 for blocks from malloc.
+   */
+  template <bool Hardened>
+  static auto OnAllocate(void *block, const std::size_t size,
+                         const std::size_t blocksize) -> void {
+    if (block == nullptr) {
+      return;
+    }
+    auto *bytes = static_cast<unsigned char *>(block);
+    if (blocksize != 0) {
+      EASYSTL_UNPOISON_MEMORY_REGION(bytes, blocksize);
+    }
+    if constexpr (Hardened) {
+      if (blocksize != 0 &&
+          LoadWord(bytes + sizeof(void *)) == FreeMark(block)) {
+        for (std::size_t i = 2 * sizeof(void *); i < blocksize; ++i) {
+          if (bytes[i] != kPoisonByte) {
+            Report("pool block written after free", block);
+            break;
+          }
+        }
+        StoreWord(bytes + sizeof(void *), 0);
+      }
+      StoreWord(bytes + size, kCanary);
+    }
+    if (blocksize != 0) {
+      // Keep the link word readable for a concurrent Pop that lost its race.
+      const std::size_t used = size < sizeof(void *) ? sizeof(void *) : size;
+      EASYSTL_POISON_MEMORY_REGION(bytes + used, blocksize - used);
+    }
+  }
+
+  /**
+   * @brief Checks and poisons a block that is being freed.
+   * @tparam Hardened Whether to run the checks of a hardened pool.
+   * @param block The block.
+   * @param size The size the block was requested with.
+   * @param blocksize The size of the pool block, or 0 for blocks from malloc.
+   * @return `false` if the block must not be freed (a double free).
+   */
+  template <bool Hardened>
+  static auto OnDeallocate(void *block, const std::size_t size,
+                           const std::size_t blocksize) -> bool {
+    auto *bytes = static_cast<unsigned char *>(block);
+    if (blocksize != 0) {
+      EASYSTL_UNPOISON_MEMORY_REGION(bytes, blocksize);
+    }
+    if constexpr (Hardened) {
+      if (blocksize != 0 &&
+          LoadWord(bytes + sizeof(void *)) == FreeMark(block)) {
+        Report("pool block freed twice", block);
+        EASYSTL_POISON_MEMORY_REGION(bytes + sizeof(void *),
+                                     blocksize - sizeof(void *));
+        return false;
+      }
+      if (LoadWord(bytes + size) != kCanary) {
+        Report("pool block overflowed its requested size", block);
+      }
+      if (blocksize != 0) {
+        std::memset(bytes, kPoisonByte, blocksize);
+        StoreWord(bytes + sizeof(void *), FreeMark(block));
+      }
+    }
+    if (blocksize != 0) {
+      // The pool keeps its free-list link in the first word.
+      EASYSTL_POISON_MEMORY_REGION(bytes + sizeof(void *),
+                                   blocksize - sizeof(void *));
+    }
+    return true;
+  }
+
+private:
+  static auto DefaultHandler(const char *what, const void *block) -> void {
+    std::fprintf(stderr, "easystl: %s (block %p)\n", what, block);
+    std::abort();
+  }
+
+  static auto MakeKey() -> std::uintptr_t {
+    // Mix a stack address (randomized by ASLR) with the clock (splitmix64).
+    int local = 0;
+    auto key = static_cast<std::uint64_t>(
+                   reinterpret_cast<std::uintptr_t>(&local)) ^
+               static_cast<std::uint64_t>(
+                   std::chrono::steady_clock::now().time_since_epoch().count());
+    key += 0x9e3779b97f4a7c15ULL;
+    key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    key = (key ^ (key >> 27)) * 0x94d049bb133111ebULL;
+    return static_cast<std::uintptr_t>(key ^ (key >> 31));
+  }
+
+  static auto FreeMark(const void *block) -> std::uint64_t {
+    return static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(block) ^
+                                      Key()) ^
+           0xf4eeb10cf4eeb10cULL;
+  }
+
+  static auto LoadWord(const unsigned char *where) -> std::uint64_t {
+    std::uint64_t word;
+    std::memcpy(&word, where, sizeof(word));
+    return word;
+  }
+
+  static auto StoreWord(unsigned char *where, const std::uint64_t word)
+      -> void {
+    std::memcpy(where, &word, sizeof(word));
+  }
+
+  static CorruptionHandler handler_; ///< The current corruption handler.
+};
+
+inline PoolHardening::CorruptionHandler PoolHardening::handler_ =
+    &PoolHardening::DefaultHandler;
+
+/**
+ * @struct PlainLink
+ * @brief Free-list link encoding that stores the next pointer as is.
+ */
+struct PlainLink {
+  static auto Encode(void *const * /*slot*/, void *next) -> void * {
+    return next;
+  }
+  static auto Decode(void *const * /*slot*/, void *stored) -> void * {
+    return stored;
+  }
+  static auto Check(const void * /*node*/) -> void {}
+};
+
+/**
+ * @struct ObfuscatedLink
+ * @brief Free-list link encoding of hardened pools, in the style of glibc's
+ * safe-linking: the next pointer is XORed with the address of the link
+ * (shifted by the page bits) and the per-process key. A stray write into a
+ * freed block then no longer yields a usable pointer, and Check catches most
+ * corrupted links as misaligned before they are followed.
+ */
+struct ObfuscatedLink {
+  static auto Encode(void *const *slot, void *next) -> void * {
+    return reinterpret_cast<void *>(Mask(slot) ^
+                                    reinterpret_cast<std::uintptr_t>(next));
+  }
+  static auto Decode(void *const *slot, void *stored) -> void * {
+    return reinterpret_cast<void *>(Mask(slot) ^
+                                    reinterpret_cast<std::uintptr_t>(stored));
+  }
+  static auto Check(const void *node) -> void {
+    if (reinterpret_cast<std::uintptr_t>(node) % alignof(void *) != 0) {
+      PoolHardening::Report("corrupted pool free-list link", node);
+    }
+  }
+
+private:
+  static auto Mask(void *const *slot) -> std::uintptr_t {
+    return (reinterpret_cast<std::uintptr_t>(slot) >> 12) ^
+           PoolHardening::Key();
+  }
+};
+} // namespace easystl
+
+#endif // !EASYSTL_POOL_HARDENING_H_
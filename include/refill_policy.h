@@ -0,0 +1,92 @@
+#pragma once
+
+#ifndef EASYSTL_REFILL_POLICY_H_
+#define EASYSTL_REFILL_POLICY_H_
+
+#include <cstddef>
+
+namespace easystl {
+/**
+ * @struct FixedRefill
+ * @brief Refill policy that always carves the same number of blocks.
+ *
+ * A refill policy decides how many blocks the pool carves from a chunk when a
+ * size class runs dry. It provides a per-class `State`, `Next` which returns
+ * the number of blocks for the refill that is about to happen, and `Idle`
+ * which the pool calls when blocks of the class were found sitting unused in
+ * the free list (during Trim).
+ * @tparam Nums The number of blocks carved per refill.
+ */
+template <std::size_t Nums = 20> struct FixedRefill {
+  static_assert(Nums != 0, "a refill must carve at least one block");
+
+  ///< @brief No per-class state.
+  struct State {};
+
+  /**
+   * @brief Gets the number of blocks to carve.
+   * @param state The state of the size class.
+   * @param size The block size of the size class.
+   * @return The number of blocks.
+   */
+  static constexpr auto Next(State & /*state*/, std::size_t /*size*/)
+      -> std::size_t {
+    return Nums;
+  }
+
+  /**
+   * @brief Notes that blocks of the class sat idle.
+   * @param state The state of the size class.
+   */
+  static constexpr auto Idle(State & /*state*/) -> void {}
+};
+
+/**
+ * @struct AdaptiveRefill
+ * @brief Refill policy with TCP-style slow start: a class starts with small
+ * refills and doubles the batch on every refill, so hot classes quickly
+ * reach large batches and refill rarely, while cold classes only ever carve
+ * a few blocks. Every refill is also capped at `MaxBytes`, so classes of
+ * large blocks never strand much memory. The batch is halved whenever blocks
+ * of the class are found idle.
+ * @tparam MinNums The batch size of the first refill.
+ * @tparam MaxNums The largest batch size.
+ * @tparam MaxBytes The most bytes carved by a single refill.
+ */
+template <std::size_t MinNums = 4, std::size_t MaxNums = 512,
+          std::size_t MaxBytes = 64 * 1024>
+struct AdaptiveRefill {
+  static_assert(MinNums != 0 && MinNums <= MaxNums,
+                "batch bounds must satisfy 0 < MinNums <= MaxNums");
+
+  ///< @brief Per-class batch size.
+  struct State {
+    std::size_t nums = MinNums; ///< Blocks carved by the next refill.
+  };
+
+  /**
+   * @brief Gets the number of blocks to carve and doubles the batch for the
+   * next refill.
+   * @param state The state of the size class.
+   * @param size The block size of the size class.
+   * @return The number of blocks.
+   */
+  static constexpr auto Next(State &state, const std::size_t size)
+      -> std::size_t {
+    const std::size_t cap = MaxBytes / size > 1 ? MaxBytes / size : 1;
+    const std::size_t result = state.nums < cap ? state.nums : cap;
+    state.nums = 2 * result < MaxNums ? 2 * result : MaxNums;
+    return result;
+  }
+
+  /**
+   * @brief Halves the batch after blocks of the class sat idle.
+   * @param state The state of the size class.
+   */
+  static constexpr auto Idle(State &state) -> void {
+    state.nums = state.nums / 2 > MinNums ? state.nums / 2 : MinNums;
+  }
+};
+} // namespace easystl
+
+#endif // !EASYSTL_REFILL_POLICY_H_
@@ -0,0 +1,148 @@
+#pragma once
+
+#ifndef EASYSTL_SIZE_CLASS_H_
+#define EASYSTL_SIZE_CLASS_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace easystl {
+/**
+ * @struct LinearSizeClasses
+ * @brief Size-class policy with one class every `Align` bytes up to
+ * `MaxBytes`. This is the classic layout of the memory pool.
+ *
+ * A size-class policy provides `kNum` classes of strictly increasing size,
+ * the largest of which is `kMaxBytes`, and two constant-time lookups: `Index`
+ * maps a request of 1 to `kMaxBytes` bytes to the smallest class that fits it
+ * and `Size` returns the block size of a class.
+ * @tparam Align The distance between two classes (in bytes).
+ * @tparam MaxBytes The largest size served by the pool.
+ */
+template <std::size_t Align = 8, std::size_t MaxBytes = 128>
+struct LinearSizeClasses {
+  static_assert(Align != 0 && (Align & (Align - 1)) == 0,
+                "class spacing must be a power of two");
+  static_assert(MaxBytes % Align == 0,
+                "largest class must be a multiple of the spacing");
+
+  static constexpr std::size_t kMaxBytes = MaxBytes; ///< Largest class size.
+  static constexpr std::size_t kNum = MaxBytes / Align; ///< Number of classes.
+
+  /**
+   * @brief Gets the index of the smallest class that fits `bytes`.
+   * @param bytes The requested size, `1 <= bytes <= kMaxBytes`.
+   * @return The class index.
+   */
+  static constexpr auto Index(const std::size_t bytes) -> std::size_t {
+    return (bytes + Align - 1) / Align - 1;
+  }
+
+  /**
+   * @brief Gets the block size of a class.
+   * @param index The class index.
+   * @return The block size in bytes.
+   */
+  static constexpr auto Size(const std::size_t index) -> std::size_t {
+    return (index + 1) * Align;
+  }
+};
+
+/**
+ * @struct GeometricSizeClasses
+ * @brief Size-class policy in the style of tcmalloc and jemalloc: 8-byte steps
+ * up to 128 bytes, then four classes per power of two (160, 192, 224, 256,
+ * 320, ...) up to `MaxBytes`. Internal fragmentation stays below 25% while the
+ * number of free lists grows only logarithmically.
+ *
+ * `Index` is a single load from a constexpr table: requests up to 1 KiB are
+ * looked up in 8-byte slots and larger ones in 128-byte slots, which is exact
+ * because every class above 1 KiB is a multiple of 256 bytes.
+ * @tparam MaxBytes The largest size served by the pool; a power of two of at
+ * least 256.
+ */
+template <std::size_t MaxBytes = 32768> struct GeometricSizeClasses {
+  static_assert(MaxBytes >= 256 && (MaxBytes & (MaxBytes - 1)) == 0,
+                "largest class must be a power of two of at least 256");
+
+  static constexpr std::size_t kMaxBytes = MaxBytes; ///< Largest class size.
+
+private:
+  static constexpr std::size_t kLinearMax = 128; ///< End of the 8-byte steps.
+  static constexpr std::size_t kSmallMax = 1024; ///< End of the 8-byte slots.
+
+  static constexpr auto Log2(std::size_t value) -> std::size_t {
+    std::size_t result = 0;
+    while (value > 1) {
+      value >>= 1;
+      ++result;
+    }
+    return result;
+  }
+
+  static constexpr auto LookupSlot(const std::size_t bytes) -> std::size_t {
+    return bytes <= kSmallMax ? (bytes + 7) >> 3
+                              : (bytes + 127 + (120 << 7)) >> 7;
+  }
+
+public:
+  static constexpr std::size_t kNum =
+      kLinearMax / 8 +
+      4 * (Log2(MaxBytes) - Log2(kLinearMax)); ///< Number of classes.
+
+private:
+  static constexpr auto MakeSizes() -> std::array<std::size_t, kNum> {
+    std::array<std::size_t, kNum> sizes{};
+    std::size_t index = 0;
+    for (std::size_t size = 8; size <= kLinearMax; size += 8) {
+      sizes[index++] = size;
+    }
+    for (std::size_t base = kLinearMax; base < MaxBytes; base *= 2) {
+      for (std::size_t step = 1; step <= 4; ++step) {
+        sizes[index++] = base + step * (base / 4);
+      }
+    }
+    return sizes;
+  }
+
+  static constexpr std::array<std::size_t, kNum> kSizes = MakeSizes();
+
+  static constexpr auto MakeTable()
+      -> std::array<std::uint8_t, LookupSlot(MaxBytes) + 1> {
+    std::array<std::uint8_t, LookupSlot(MaxBytes) + 1> table{};
+    std::size_t index = 0;
+    for (std::size_t bytes = 1; bytes <= MaxBytes; ++bytes) {
+      while (kSizes[index] < bytes) {
+        ++index;
+      }
+      table[LookupSlot(bytes)] = static_cast<std::uint8_t>(index);
+    }
+    return table;
+  }
+
+  static_assert(kNum <= 256, "class index must fit into the lookup table");
+  static constexpr auto kTable = MakeTable();
+
+public:
+  /**
+   * @brief Gets the index of the smallest class that fits `bytes`.
+   * @param bytes The requested size, `1 <= bytes <= kMaxBytes`.
+   * @return The class index.
+   */
+  static constexpr auto Index(const std::size_t bytes) -> std::size_t {
+    return kTable[LookupSlot(bytes)];
+  }
+
+  /**
+   * @brief Gets the block size of a class.
+   * @param index The class index.
+   * @return The block size in bytes.
+   */
+  static constexpr auto Size(const std::size_t index) -> std::size_t {
+    return kSizes[index];
+  }
+};
+} // namespace easystl
+
+#endif // !EASYSTL_SIZE_CLASS_H_
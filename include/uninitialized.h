@@ -5,10 +5,34 @@
 
 #include "constructor.h"
 #include <cstdlib>
+#include <cstring>
+#include <type_traits>
+#include <utility>
 
 // helper funcs to construct value in uninitialized place which is already
 // allocated
 namespace easystl {
+/**
+ * @struct IsTriviallyRelocatable
+ * @brief Tells whether moving an object to a new address and ending the
+ * lifetime of the original is the same as copying its bytes, as for a
+ * `unique_ptr`-style handle. Containers then relocate such objects with
+ * `memcpy`/`memmove` and never run their move constructor or destructor.
+ *
+ * Trivially copyable types are trivially relocatable. Other types opt in by
+ * declaring `static constexpr bool kTriviallyRelocatable = true;` or, for
+ * types that cannot be changed, by specializing this trait. A type that keeps
+ * pointers into itself must not opt in.
+ * @tparam T The type to classify.
+ */
+template <class T>
+struct IsTriviallyRelocatable
+    : std::bool_constant<std::is_trivially_copyable_v<T>> {};
+
+template <class T>
+  requires requires { requires T::kTriviallyRelocatable; }
+struct IsTriviallyRelocatable<T> : std::true_type {};
+
 /**
  * @brief Copies uninitialized objects from one range to another.
  *
@@ -38,6 +62,93 @@ auto uninitialized_copy(InputIter first, InputIter last, ForwardIter result)
   return current;
 }
 
+/**
+ * @brief Moves objects from one range into uninitialized memory.
+ *
+ * This function move-constructs the objects in the range [first, last) into
+ * the uninitialized memory range starting at result, leaving the source
+ * objects in their moved-from state. If an exception is thrown during the
+ * construction, previously constructed objects are destroyed.
+ *
+ * @tparam InputIter The type of the input iterator.
+ * @tparam ForwardIter The type of the output iterator.
+ * @param first The beginning of the source range (inclusive).
+ * @param last The end of the source range (exclusive).
+ * @param result The beginning of the destination range.
+ * @return ForwardIter An iterator to the end of the constructed range.
+ */
+template <class InputIter, class ForwardIter>
+auto uninitialized_move(InputIter first, InputIter last, ForwardIter result)
+    -> ForwardIter {
+  auto current = result;
+  try {
+    for (; first != last; ++first, ++current) {
+      Construct(&*current, std::move(*first));
+    }
+  } catch (...) {
+    Destroy(result, current);
+    std::abort();
+  }
+  return current;
+}
+
+/**
+ * @brief Moves objects into uninitialized memory if that cannot throw, and
+ * copies them otherwise, so the source range stays intact when a copy fails.
+ * Types that cannot be copied are always moved.
+ *
+ * @tparam InputIter The type of the input iterator.
+ * @tparam ForwardIter The type of the output iterator.
+ * @param first The beginning of the source range (inclusive).
+ * @param last The end of the source range (exclusive).
+ * @param result The beginning of the destination range.
+ * @return ForwardIter An iterator to the end of the constructed range.
+ */
+template <class InputIter, class ForwardIter>
+auto uninitialized_move_if_noexcept(InputIter first, InputIter last,
+                                    ForwardIter result) -> ForwardIter {
+  using T = std::remove_reference_t<decltype(*first)>;
+  if constexpr (std::is_nothrow_move_constructible_v<T> ||
+                !std::is_copy_constructible_v<T>) {
+    return easystl::uninitialized_move(first, last, result);
+  } else {
+    return easystl::uninitialized_copy(first, last, result);
+  }
+}
+
+/**
+ * @brief Relocates objects into uninitialized memory: the objects in
+ * [first, last) are moved to the range starting at result and their lifetime
+ * ends, so the source range is left uninitialized.
+ *
+ * Trivially relocatable objects are moved with a single `memmove`, which lets
+ * the ranges overlap in either direction. Other objects are move-constructed
+ * and destroyed one by one, so result must not lie within (first, last).
+ *
+ * @tparam T The type of the objects.
+ * @param first The beginning of the source range (inclusive).
+ * @param last The end of the source range (exclusive).
+ * @param result The beginning of the destination range.
+ * @return T* A pointer to the end of the relocated range.
+ */
+template <class T>
+auto uninitialized_relocate(T *first, T *last, T *result) -> T * {
+  if constexpr (IsTriviallyRelocatable<T>::value) {
+    const auto count = static_cast<std::size_t>(last - first);
+    if (count != 0) {
+      std::memmove(static_cast<void *>(result),
+                   static_cast<const void *>(first), count * sizeof(T));
+    }
+    return result + count;
+  } else {
+    for (; first != last; ++first, ++result) {
+      Construct(result, std::move(*first));
+      Destroy(first);
+    }
+    return result;
+  }
+}
+
 /**
  * @brief Fills uninitialized memory with a specified value.
  *
@@ -3,20 +3,35 @@
 #ifndef EASYSTL_VECTOR_H_
 #define EASYSTL_VECTOR_H_
 
+#include <cstring>
 #include <initializer_list>
 #include <type_traits>
+#include <utility>
 
 #include "algo.h"
 #include "allocator_wrapper.h"
 #include "constructor.h"
+#include "growth_policy.h"
 #include "iterator.h"
 #include "uninitialized.h"
 
 namespace easystl {
-template <class T, class Alloc = Allo> class vector {
+/**
+ * @class vector
+ * @brief A dynamic array. The allocator is stored as an (empty, for stateless
+ * allocators) base, and AllocatorTraits decides whether it follows the
+ * elements on copy assignment, move assignment and swap.
+ * @tparam T The element type.
+ * @tparam Alloc The allocator class.
+ * @tparam Growth The growth policy, see growth_policy.h.
+ */
+template <class T, class Alloc = DefaultAllocator,
+          class Growth = DefaultGrowth>
+class vector : private AllocatorWrapper<T, Alloc> {
 public:
   // type alias
   using value_type = T;
+  using allocator_type = Alloc;
   using pointer = T *;
   using iterator = T *;
   using reference = T &;
@@ -25,77 +40,174 @@ public:
 
   ///< @brief Default constructor.
   vector() noexcept : begin_(nullptr), end_(nullptr), capacity_(nullptr) {}
+  /**
+   * @brief Constructs an empty vector using an allocator object.
+   *
+   * @param alloc The allocator to use.
+   */
+  explicit vector(const Alloc &alloc) noexcept : DataAllocator(alloc) {}
   /**
    * @brief Constructs a vector with a specified length, initialized with a
    * value.
    *
    * @param len The number of elements.
    * @param value The value to initialize the elements with.
+   * @param alloc The allocator to use.
    */
-  vector(const size_type len, const T &value) noexcept { NumsInit(len, value); }
+  vector(const size_type len, const T &value,
+         const Alloc &alloc = Alloc())
+      : DataAllocator(alloc) {
+    NumsInit(len, value);
+  }
   /**
    * @brief Constructs a vector with a specified length, initialized with
    * default values.
    *
    * @param len The number of elements.
+   * @param alloc The allocator to use.
    */
-  explicit vector(const size_type len) noexcept { NumsInit(len, T()); }
+  explicit vector(const size_type len, const Alloc &alloc = Alloc())
+      : DataAllocator(alloc) {
+    NumsInit(len, T());
+  }
   /**
    * @brief Constructs a vector from a range of iterators.
    *
    * @tparam Iterator Type of the input iterator.
    * @param first The beginning of the range.
    * @param last The end of the range.
+   * @param alloc The allocator to use.
    */
   template <class Iterator,
             std::enable_if_t<IsIterator<Iterator>::value, int> = 0>
-  vector(Iterator first, Iterator last) noexcept {
+  vector(Iterator first, Iterator last, const Alloc &alloc = Alloc())
+      : DataAllocator(alloc) {
     RangeInit(first, last);
   }
   /**
    * @brief Constructs a vector from an initializer list.
    *
    * @param ilist The initializer list.
+   * @param alloc The allocator to use.
    */
-  vector(std::initializer_list<value_type> ilist) {
+  vector(std::initializer_list<value_type> ilist,
+         const Alloc &alloc = Alloc())
+      : DataAllocator(alloc) {
     RangeInit(ilist.begin(), ilist.end());
   }
 
   /**
-   * @brief Copy constructor.
+   * @brief Copy constructor. The copy uses the allocator of `other`.
+   *
+   * @param other The vector to copy from.
+   */
+  vector(const vector &other) : DataAllocator(other.GetAllocator()) {
+    RangeInit(other.begin_, other.end_);
+  }
+
+  /**
+   * @brief Copy constructor using a given allocator.
    *
    * @param other The vector to copy from.
+   * @param alloc The allocator to use.
+   */
+  vector(const vector &other, const Alloc &alloc)
+      : DataAllocator(alloc) {
+    RangeInit(other.begin_, other.end_);
+  }
+
+  /**
+   * @brief Move constructor. Takes over the storage and the allocator of
+   * `other`, leaving it empty.
+   *
+   * @param other The vector to move from.
+   */
+  vector(vector &&other) noexcept
+      : DataAllocator(other.GetAllocator()), begin_(other.begin_),
+        end_(other.end_), capacity_(other.capacity_) {
+    other.begin_ = other.end_ = other.capacity_ = nullptr;
+  }
+
+  /**
+   * @brief Move constructor using a given allocator. The storage of `other`
+   * is taken over if the allocators are equal; otherwise its elements are
+   * moved into storage from `alloc`.
+   *
+   * @param other The vector to move from.
+   * @param alloc The allocator to use.
    */
-  vector(const vector &other) noexcept { RangeInit(other.begin_, other.end_); }
+  vector(vector &&other, const Alloc &alloc) noexcept(Traits::kStateless)
+      : DataAllocator(alloc) {
+    if (Traits::Equal(GetAllocator(), other.GetAllocator())) {
+      SwapData(other);
+    } else {
+      MoveElements(other);
+    }
+  }
 
   /**
-   * @brief Copy assignment operator.
+   * @brief Copy assignment operator. The allocator of `rhs` is adopted only
+   * if `AllocatorTraits<Alloc>::kPropagateOnCopyAssign` is set.
    *
    * @param rhs The vector to assign from.
    * @return A reference to the current vector.
    */
-  vector &operator=(const vector &rhs) noexcept {
+  vector &operator=(const vector &rhs) {
     if (this != &rhs) {
+      if constexpr (Traits::kPropagateOnCopyAssign && !Traits::kStateless) {
+        if (!Traits::Equal(GetAllocator(), rhs.GetAllocator())) {
+          DestroyDeallocate(begin_, end_, capacity_ - begin_);
+          begin_ = end_ = capacity_ = nullptr;
+        }
+        GetAllocator() = rhs.GetAllocator();
+      }
       const size_type rhslen = rhs.size();
       if (rhslen > capacity()) {
-        vector tmp(rhs);
-        swap(tmp);
+        vector tmp(rhs, GetAllocator());
+        SwapData(tmp);
       } else if (size() >= rhslen) {
         auto i = Copy(rhs.begin_, rhs.end_, begin_);
         Destroy(i, end_);
         end_ = begin_ + rhslen;
       } else {
         Copy(rhs.begin_, rhs.end_, begin_);
-        uninitialized_copy(rhs.begin_ + size(), rhs.end_, end_);
+        easystl::uninitialized_copy(rhs.begin_ + size(), rhs.end_, end_);
         end_ = begin_ + rhslen;
       }
     }
     return *this;
   }
 
-  vector &operator=(std::initializer_list<value_type> ilist) noexcept {
-    vector<T> tmp(ilist);
-    swap(tmp);
+  /**
+   * @brief Move assignment operator. If the allocator propagates on move
+   * assignment or both allocators are equal, the storage of `rhs` is taken
+   * over; otherwise the elements are moved into storage from the current
+   * allocator.
+   *
+   * @param rhs The vector to assign from.
+   * @return A reference to the current vector.
+   */
+  vector &operator=(vector &&rhs) noexcept(Traits::kPropagateOnMoveAssign ||
+                                           Traits::kStateless) {
+    if (this != &rhs) {
+      if (Traits::kPropagateOnMoveAssign ||
+          Traits::Equal(GetAllocator(), rhs.GetAllocator())) {
+        DestroyDeallocate(begin_, end_, capacity_ - begin_);
+        if constexpr (Traits::kPropagateOnMoveAssign && !Traits::kStateless) {
+          GetAllocator() = rhs.GetAllocator();
+        }
+        begin_ = end_ = capacity_ = nullptr;
+        SwapData(rhs);
+      } else {
+        MoveElements(rhs);
+      }
+    }
+    return *this;
+  }
+
+  vector &operator=(std::initializer_list<value_type> ilist) {
+    vector tmp(ilist, GetAllocator());
+    SwapData(tmp);
     return *this;
   }
 
@@ -120,7 +232,7 @@ public:
    *
    * @param x The element to add.
    */
-  auto push_back(const T &x) noexcept -> void {
+  auto push_back(const T &x) -> void {
     if (end_ != capacity_) {
       Construct(end_, x);
       ++end_;
@@ -130,34 +242,61 @@ public:
   }
 
   /**
-   * @brief Removes the last element from the vector.
+   * @brief Adds an element to the end of the vector by moving it.
    *
-   * @return A reference to the removed element.
+   * @param x The element to move from.
    */
-  auto pop_back() noexcept -> T & {
+  auto push_back(T &&x) -> void { emplace_back(std::move(x)); }
+
+  /**
+   * @brief Constructs an element in place at the end of the vector.
+   *
+   * @tparam Args The types of the constructor arguments.
+   * @param args The arguments forwarded to the constructor of the element.
+   * @return A reference to the new element.
+   */
+  template <class... Args>
+  auto emplace_back(Args &&...args) -> reference {
+    if (end_ != capacity_) {
+      Construct(end_, std::forward<Args>(args)...);
+      ++end_;
+    } else {
+      ReallocInsert(end_, std::forward<Args>(args)...);
+    }
+    return back();
+  }
+
+  ///< @brief Removes the last element from the vector, if any.
+  auto pop_back() noexcept -> void {
     if (empty()) {
-      return nullptr;
+      return;
     }
     --end_;
     Destroy(end_);
-    return *end_;
   }
 
   /**
-   * @brief Erases an element at a specified position.
+   * @brief Erases an element at a specified position. Trivially relocatable
+   * elements after it are shifted down with a single `memmove`.
    *
    * @param pos The position of the element to erase.
    * @return An iterator to the next element.
    */
   auto erase(iterator pos) noexcept -> iterator {
-    Copy(pos + 1, end_, pos);
-    Destroy(end_);
+    if constexpr (kRelocatable) {
+      Destroy(pos);
+      easystl::uninitialized_relocate(pos + 1, end_, pos);
+    } else {
+      Move(pos + 1, end_, pos);
+      Destroy(end_ - 1);
+    }
     --end_;
     return pos;
   }
 
   /**
-   * @brief Erases a range of elements.
+   * @brief Erases a range of elements. Trivially relocatable elements after
+   * it are shifted down with a single `memmove`.
    *
    * @param first The beginning of the range to erase.
    * @param last The end of the range to erase.
@@ -165,8 +304,13 @@ public:
    */
   auto erase(iterator first, iterator last) noexcept -> iterator {
     if (first != last) {
-      auto i = Copy(last, end_, first);
-      Destroy(i, end_);
+      if constexpr (kRelocatable) {
+        Destroy(first, last);
+        easystl::uninitialized_relocate(last, end_, first);
+      } else {
+        auto i = Move(last, end_, first);
+        Destroy(i, end_);
+      }
       end_ = end_ - (last - first);
     }
     return last;
@@ -179,7 +323,7 @@ public:
    * @param newsize The new size.
    * @param x The value to fill new elements with.
    */
-  auto resize(size_type newsize, const T &x) noexcept -> void {
+  auto resize(size_type newsize, const T &x) -> void {
     if (newsize < size()) {
       erase(begin_ + newsize, end_);
     } else {
@@ -193,11 +337,35 @@ public:
    *
    * @param newsize The new size.
    */
-  auto resize(size_type newsize) noexcept -> void { resize(newsize, T()); }
+  auto resize(size_type newsize) -> void { resize(newsize, T()); }
 
   ///<  @brief Clears the vector, removing all elements.
   auto clear() noexcept { erase(begin_, end_); }
 
+  /**
+   * @brief Makes room for at least `n` elements, so that adding elements up
+   * to that size does not reallocate.
+   *
+   * @param n The number of elements to make room for.
+   */
+  auto reserve(const size_type n) -> void {
+    if (n > capacity()) {
+      Relocate(FitCapacity(n));
+    }
+  }
+
+  /**
+   * @brief Reduces the capacity to the size (or to the usable size of the
+   * block holding that many elements, if the growth policy rounds to size
+   * classes), freeing the storage of an empty vector.
+   */
+  auto shrink_to_fit() -> void {
+    const size_type fit = FitCapacity(size());
+    if (fit < capacity()) {
+      Relocate(fit);
+    }
+  }
+
   /**
    * @brief Returns a pointer to the underlying array.
    *
@@ -206,15 +374,38 @@ public:
   auto data() noexcept -> pointer { return begin_; }
 
   /**
-   * @brief Swaps the contents of this vector with another.
+   * @brief Returns a copy of the allocator.
+   *
+   * @return The allocator.
+   */
+  auto get_allocator() const noexcept -> allocator_type {
+    return GetAllocator();
+  }
+
+  /**
+   * @brief Swaps the contents of this vector with another. If the allocator
+   * does not propagate on swap and the allocators differ, each vector keeps
+   * its allocator and receives a copy of the other's elements, which may
+   * throw; swapping is `noexcept` only when no copy can be needed.
    *
    * @param rhs The vector to swap with.
    */
-  auto swap(vector &rhs) noexcept -> void {
+  auto swap(vector &rhs) noexcept(Traits::kStateless ||
+                                  Traits::kPropagateOnSwap) -> void {
     if (this != &rhs) {
-      Swap(begin_, rhs.begin_);
-      Swap(end_, rhs.end_);
-      Swap(capacity_, rhs.capacity_);
+      if constexpr (Traits::kStateless) {
+        SwapData(rhs);
+      } else if constexpr (Traits::kPropagateOnSwap) {
+        Swap(GetAllocator(), rhs.GetAllocator());
+        SwapData(rhs);
+      } else if (Traits::Equal(GetAllocator(), rhs.GetAllocator())) {
+        SwapData(rhs);
+      } else {
+        vector mine(rhs, GetAllocator());
+        vector theirs(*this, rhs.GetAllocator());
+        SwapData(mine);
+        rhs.SwapData(theirs);
+      }
     }
   }
 
@@ -226,26 +417,35 @@ public:
    * @param x The value of the elements to insert.
    * @return An iterator to the position where elements were inserted.
    */
-  auto insert(iterator pos, size_type size, const T &x) noexcept -> iterator {
+  auto insert(iterator pos, size_type size, const T &x) -> iterator {
+    const size_type offset = pos - begin_;
+    if (size == 0) {
+      return pos;
+    }
     if (static_cast<size_type>(capacity_ - end_) >= size) {
+      const T value = x; // `x` may be one of the elements being moved.
       const size_type elemsafter = end_ - pos;
       iterator oldend = end_;
-      if (elemsafter > size) {
-        uninitialized_copy(end_ - size, end_, end_);
+      if constexpr (kRelocatable) {
+        easystl::uninitialized_relocate(pos, oldend, pos + size);
+        easystl::uninitialized_fill_n(pos, size, value);
+        end_ += size;
+      } else if (elemsafter > size) {
+        easystl::uninitialized_move(end_ - size, end_, end_);
         end_ += size;
-        CopyBackward(pos, oldend - size, oldend);
-        Fill(pos, pos + size, x);
+        MoveBackward(pos, oldend - size, oldend);
+        Fill(pos, pos + size, value);
       } else {
-        uninitialized_fill_n(end_, size - elemsafter, x);
+        easystl::uninitialized_fill_n(end_, size - elemsafter, value);
         end_ += size - elemsafter;
-        uninitialized_copy(pos, oldend, end_);
+        easystl::uninitialized_move(pos, oldend, end_);
         end_ += elemsafter;
-        Fill(pos, oldend, x);
+        Fill(pos, oldend, value);
       }
     } else {
       InsertAux(pos, size, x);
     }
-    return pos;
+    return begin_ + offset;
   }
 
   /**
@@ -261,29 +461,33 @@ public:
   template <class Iter1, class Iter2,
             std::enable_if_t<IsIterator<Iter1>::value, int> = 0,
             std::enable_if_t<IsIterator<Iter2>::value, int> = 0>
-  auto insert(Iter1 pos, Iter2 first, Iter2 last) noexcept -> iterator {
+  auto insert(Iter1 pos, Iter2 first, Iter2 last) -> iterator {
     if (first == last)
       return pos;
-    const auto size = last - first;
+    const size_type offset = pos - begin_;
+    const size_type size = last - first;
     if (static_cast<size_type>(capacity_ - end_) >= size) {
       const size_type elemsafter = end_ - pos;
       iterator oldend = end_;
-      if (elemsafter > size) {
-        uninitialized_copy(end_ - size, end_, end_);
+      if constexpr (kRelocatable) {
+        easystl::uninitialized_relocate(pos, oldend, pos + size);
+        easystl::uninitialized_copy(first, last, pos);
+        end_ += size;
+      } else if (elemsafter > size) {
+        easystl::uninitialized_move(end_ - size, end_, end_);
         end_ += size;
-        Copybackward(pos, oldend - size, oldend);
+        MoveBackward(pos, oldend - size, oldend);
         Copy(first, last, pos);
       } else {
-        uninitialized_fill_n(end_, size - elemsafter, T());
-        end_ += size - elemsafter;
-        uninitialized_copy(pos, oldend, end_);
-        end_ += elemsafter;
-        Copy(first, last, pos);
+        Iter2 mid = first + elemsafter;
+        end_ = easystl::uninitialized_copy(mid, last, end_);
+        end_ = easystl::uninitialized_move(pos, oldend, end_);
+        Copy(first, mid, pos);
       }
     } else {
       InsertAux(pos, first, last);
     }
-    return pos;
+    return begin_ + offset;
   }
 
   /**
@@ -293,23 +497,66 @@ public:
    * @param x The element to insert.
    * @return An iterator to the position where the element was inserted.
    */
-  auto insert(iterator pos, const T &x) noexcept -> iterator {
+  auto insert(iterator pos, const T &x) -> iterator {
     return insert(pos, 1, x);
   }
 
+  /**
+   * @brief Inserts a single element at a specified position by moving it.
+   *
+   * @param pos The position to insert at.
+   * @param x The element to move from.
+   * @return An iterator to the inserted element.
+   */
+  auto insert(iterator pos, T &&x) -> iterator {
+    return emplace(pos, std::move(x));
+  }
+
+  /**
+   * @brief Constructs an element in place at a specified position. Within
+   * the capacity, an element inserted before the end is first constructed
+   * aside and then moved into place, as `args` may refer to elements that
+   * get shifted; trivially relocatable elements are shifted with `memmove`.
+   *
+   * @tparam Args The types of the constructor arguments.
+   * @param pos The position to insert at.
+   * @param args The arguments forwarded to the constructor of the element.
+   * @return An iterator to the new element.
+   */
+  template <class... Args>
+  auto emplace(iterator pos, Args &&...args) -> iterator {
+    if (end_ == capacity_) {
+      return ReallocInsert(pos, std::forward<Args>(args)...);
+    }
+    if (pos == end_) {
+      Construct(end_, std::forward<Args>(args)...);
+    } else if constexpr (kRelocatable) {
+      T value(std::forward<Args>(args)...);
+      easystl::uninitialized_relocate(pos, end_, pos + 1);
+      Construct(pos, std::move(value));
+    } else {
+      T value(std::forward<Args>(args)...);
+      Construct(end_, std::move(*(end_ - 1)));
+      MoveBackward(pos, end_ - 1, end_);
+      *pos = std::move(value);
+    }
+    ++end_;
+    return pos;
+  }
+
   /**
    * @brief Assigns new values to the vector, replacing its contents.
    *
    * @param n The number of elements to assign.
    * @param value The value to fill the vector with.
    */
-  auto assign(size_type n, const T &value) noexcept -> void {
+  auto assign(size_type n, const T &value) -> void {
     clear();
     if (n > capacity()) {
-      vector tmp(n, value);
-      swap(tmp);
+      vector tmp(n, value, GetAllocator());
+      SwapData(tmp);
     } else {
-      uninitialized_fill_n(begin_, n, value);
+      easystl::uninitialized_fill_n(begin_, n, value);
       end_ = begin_ + n;
     }
   }
@@ -322,14 +569,14 @@ public:
    * @param last The end of the range.
    */
   template <class Iter, std::enable_if_t<IsIterator<Iter>::value, int> = 0>
-  auto assign(Iter first, Iter last) noexcept -> void {
+  auto assign(Iter first, Iter last) -> void {
     clear();
     const size_type len = last - first;
     if (len > capacity()) {
-      vector tmp(first, last);
-      swap(tmp);
+      vector tmp(first, last, GetAllocator());
+      SwapData(tmp);
     } else {
-      uninitialized_copy(first, last, begin_);
+      easystl::uninitialized_copy(first, last, begin_);
       end_ = begin_ + len;
     }
   }
@@ -339,12 +586,49 @@ public:
    *
    * @param ilist The initializer list.
    */
-  auto assign(std::initializer_list<value_type> ilist) noexcept -> void {
+  auto assign(std::initializer_list<value_type> ilist) -> void {
     assign(ilist.begin(), ilist.end());
   }
 
 private:
   using DataAllocator = AllocatorWrapper<T, Alloc>;
+  using Traits = AllocatorTraits<Alloc>;
+  using DataAllocator::GetAllocator;
+
+  static constexpr bool kRelocatable =
+      IsTriviallyRelocatable<T>::value; ///< Elements move bytewise.
+
+  /**
+   * @brief Exchanges the storage of two vectors, leaving the allocators in
+   * place.
+   *
+   * @param rhs The vector to exchange storage with.
+   */
+  auto SwapData(vector &rhs) noexcept -> void {
+    Swap(begin_, rhs.begin_);
+    Swap(end_, rhs.end_);
+    Swap(capacity_, rhs.capacity_);
+  }
+
+  /**
+   * @brief Replaces the elements with those of `rhs`, moved one by one into
+   * storage from the current allocator; used when the storage of `rhs` cannot
+   * be taken over.
+   *
+   * @param rhs The vector to move the elements from; left empty.
+   */
+  auto MoveElements(vector &rhs) -> void {
+    clear();
+    const size_type len = rhs.size();
+    if (len > capacity()) {
+      iterator newbegin = DataAllocator::Allocate(len);
+      DestroyDeallocate(begin_, end_, capacity_ - begin_);
+      begin_ = end_ = newbegin;
+      capacity_ = begin_ + len;
+    }
+    end_ = easystl::uninitialized_move(rhs.begin_, rhs.end_, begin_);
+    rhs.clear();
+  }
 
   /**
    * @brief Initializes the vector with a specific number of elements and a
@@ -353,11 +637,11 @@ private:
    * @param n The number of elements.
    * @param value The value to initialize the elements with.
    */
-  auto NumsInit(size_type n, const T &value) noexcept {
-    size_type initsize = Max(n, static_cast<size_type>(16));
+  auto NumsInit(size_type n, const T &value) {
+    const size_type initsize = FitCapacity(n);
     iterator current = DataAllocator::Allocate(initsize);
     begin_ = current;
-    end_ = uninitialized_fill_n(current, n, value);
+    end_ = easystl::uninitialized_fill_n(current, n, value);
     capacity_ = begin_ + initsize;
   }
 
@@ -368,11 +652,11 @@ private:
    * @param first The beginning of the range.
    * @param last The end of the range.
    */
-  template <class Iter> auto RangeInit(Iter first, Iter last) noexcept -> void {
-    size_type initsize =
-        Max(static_cast<size_type>(last - first), static_cast<size_type>(16));
+  template <class Iter> auto RangeInit(Iter first, Iter last) -> void {
+    const size_type initsize =
+        FitCapacity(static_cast<size_type>(last - first));
     begin_ = DataAllocator::Allocate(initsize);
-    end_ = uninitialized_copy(first, last, begin_);
+    end_ = easystl::uninitialized_copy(first, last, begin_);
     capacity_ = begin_ + initsize;
   }
 
@@ -391,6 +675,99 @@ private:
     }
   }
 
+  /**
+   * @brief Moves elements of the current storage into new storage. Trivially
+   * relocatable elements are copied bytewise and must not be destroyed
+   * afterwards; others are moved if their move constructor cannot throw, and
+   * copied if it can. Either way ReleaseStorage frees the old storage.
+   *
+   * @param first The beginning of the range to move.
+   * @param last The end of the range to move.
+   * @param result The beginning of the destination range.
+   * @return An iterator to the end of the destination range.
+   */
+  auto Migrate(iterator first, iterator last, iterator result) noexcept
+      -> iterator {
+    if constexpr (kRelocatable) {
+      const auto count = static_cast<size_type>(last - first);
+      if (count != 0) {
+        std::memcpy(static_cast<void *>(result),
+                    static_cast<const void *>(first), count * sizeof(T));
+      }
+      return result + count;
+    } else {
+      return easystl::uninitialized_move_if_noexcept(first, last, result);
+    }
+  }
+
+  /**
+   * @brief Frees the current storage once Migrate has moved its elements out,
+   * destroying what they left behind unless they were relocated.
+   */
+  auto ReleaseStorage() noexcept -> void {
+    if constexpr (kRelocatable) {
+      if (begin_) {
+        DataAllocator::Deallocate(begin_, capacity_ - begin_);
+      }
+    } else {
+      DestroyDeallocate(begin_, end_, capacity_ - begin_);
+    }
+  }
+
+  /**
+   * @brief Gets the capacity to reallocate into: what the growth policy asks
+   * for, extended to the usable size of the allocator's block if the policy
+   * rounds to size classes.
+   *
+   * @param required The number of elements the new storage must hold.
+   * @return The new capacity, at least `required`.
+   */
+  auto NewCapacity(const size_type required) -> size_type {
+    return FitCapacity(Growth::Grow(size(), required));
+  }
+
+  /**
+   * @brief Gets the capacity of storage for `n` elements: `n` itself, or the
+   * usable size of the allocator's block if the growth policy rounds to size
+   * classes.
+   *
+   * @param n The number of elements the storage must hold.
+   * @return The capacity, at least `n`.
+   */
+  auto FitCapacity(const size_type n) -> size_type {
+    if constexpr (Growth::kRoundToSizeClass) {
+      const size_type fit = DataAllocator::GoodSize(n);
+      return fit < n ? n : fit;
+    } else {
+      return n;
+    }
+  }
+
+  /**
+   * @brief Moves the elements into new storage of a given capacity, which
+   * must hold them all. Trivially relocatable elements are resized in place by
+   * allocators that can; otherwise they are migrated, see Migrate.
+   *
+   * @param newcapacity The capacity of the new storage.
+   */
+  auto Relocate(const size_type newcapacity) -> void {
+    const size_type oldsize = size();
+    if constexpr (kRelocatable && DataAllocator::kReallocate) {
+      if (begin_ != nullptr && newcapacity != 0) {
+        begin_ = DataAllocator::Reallocate(begin_, capacity(), newcapacity);
+        end_ = begin_ + oldsize;
+        capacity_ = begin_ + newcapacity;
+        return;
+      }
+    }
+    iterator newbegin = DataAllocator::Allocate(newcapacity);
+    iterator newend = Migrate(begin_, end_, newbegin);
+    ReleaseStorage();
+    begin_ = newbegin;
+    end_ = newend;
+    capacity_ = begin_ + newcapacity;
+  }
+
   /**
    * @brief Auxiliary function for inserting multiple elements at a specified
    * position.
@@ -399,18 +776,61 @@ private:
    * @param nums The number of elements to insert.
    * @param x The value of the elements to insert.
    */
-  auto InsertAux(iterator pos, size_type nums, const T &x) noexcept -> void {
-    const size_type newsize = Max(size() * 2, 16);
+  auto InsertAux(iterator pos, size_type nums, const T &x) -> void {
+    const size_type newsize = NewCapacity(size() + nums);
+    if constexpr (kRelocatable && DataAllocator::kReallocate) {
+      // Appending: let the allocator grow the buffer, in place if it can.
+      if (pos == end_ && begin_ != nullptr) {
+        const T value = x; // `x` may live in the buffer being moved.
+        const size_type oldsize = size();
+        begin_ = DataAllocator::Reallocate(begin_, capacity(), newsize);
+        end_ = easystl::uninitialized_fill_n(begin_ + oldsize, nums, value);
+        capacity_ = begin_ + newsize;
+        return;
+      }
+    }
+    // The new elements are built first: `x` may live in the old buffer.
     iterator newbegin = DataAllocator::Allocate(newsize);
-    iterator newend = uninitialized_copy(begin_, pos, newbegin);
-    newend = uninitialized_fill_n(newend, nums, x);
-    newend = uninitialized_copy(pos, end_, newend);
-    DestroyDeallocate(begin_, end_, capacity_ - begin_);
+    iterator newpos = newbegin + (pos - begin_);
+    easystl::uninitialized_fill_n(newpos, nums, x);
+    Migrate(begin_, pos, newbegin);
+    iterator newend = Migrate(pos, end_, newpos + nums);
+    ReleaseStorage();
     begin_ = newbegin;
     end_ = newend;
     capacity_ = begin_ + newsize;
   }
 
+  /**
+   * @brief Auxiliary function for constructing one element from `args` at a
+   * specified position when the storage is full. The element is constructed
+   * in the new storage first, as `args` may refer to existing elements; those
+   * are then migrated, see Migrate.
+   *
+   * @tparam Args The types of the constructor arguments.
+   * @param pos The position to insert at.
+   * @param args The arguments forwarded to the constructor of the element.
+   * @return An iterator to the inserted element.
+   */
+  template <class... Args>
+  auto ReallocInsert(iterator pos, Args &&...args) -> iterator {
+    const size_type offset = pos - begin_;
+    if constexpr (std::is_trivially_copyable_v<T>) {
+      InsertAux(pos, 1, T(std::forward<Args>(args)...));
+    } else {
+      const size_type newsize = NewCapacity(size() + 1);
+      iterator newbegin = DataAllocator::Allocate(newsize);
+      Construct(newbegin + offset, std::forward<Args>(args)...);
+      Migrate(begin_, pos, newbegin);
+      iterator newend = Migrate(pos, end_, newbegin + offset + 1);
+      ReleaseStorage();
+      begin_ = newbegin;
+      end_ = newend;
+      capacity_ = begin_ + newsize;
+    }
+    return begin_ + offset;
+  }
+
   /**
    * @brief Auxiliary function for inserting a range of elements from iterators.
    *
@@ -423,13 +843,14 @@ private:
   template <class Iter1, class Iter2,
             std::enable_if_t<IsIterator<Iter1>::value, int> = 0,
             std::enable_if_t<IsIterator<Iter2>::value, int> = 0>
-  auto InsertAux(Iter1 pos, Iter2 first, Iter2 last) noexcept -> void {
-    const size_type newsize = Max(size() * 2, 16);
+  auto InsertAux(Iter1 pos, Iter2 first, Iter2 last) -> void {
+    const size_type newsize =
+        NewCapacity(size() + static_cast<size_type>(last - first));
     iterator newbegin = DataAllocator::Allocate(newsize);
-    iterator newend = uninitialized_copy(begin_, pos, newbegin);
-    newend = uninitialized_copy(first, last, newend);
-    newend = uninitialized_copy(pos, end_, newend);
-    DestroyDeallocate(begin_, end_, capacity_ - begin_);
+    iterator newend = Migrate(begin_, pos, newbegin);
+    newend = easystl::uninitialized_copy(first, last, newend);
+    newend = Migrate(pos, end_, newend);
+    ReleaseStorage();
     begin_ = newbegin;
     end_ = newend;
     capacity_ = begin_ + newsize;
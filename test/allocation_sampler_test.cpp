@@ -0,0 +1,149 @@
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+
+#include "allocation_sampler.h"
+#include "allocator_wrapper.h"
+#include "malloc_allocator.h"
+
+using namespace easystl;
+
+namespace {
+struct SampledMallocAllocator : MallocAllocator {
+    static constexpr bool kSampled = true;
+};
+struct UnsampledMallocAllocator : MallocAllocator {
+    static constexpr bool kSampled = false;
+};
+
+/**
+ * Sets the sample rate while alive.
+ */
+struct RateScope {
+    explicit RateScope(const std::size_t rate)
+        : old(AllocationSampler::SetSampleRate(rate)) {}
+    ~RateScope() { AllocationSampler::SetSampleRate(old); }
+
+    std::size_t old;
+};
+
+/**
+ * Runs a callable on a fresh thread, whose first sampling interval is drawn
+ * at the current rate.
+ */
+template <class Func> auto OnFreshThread(Func &&func) -> void {
+    std::thread worker(func);
+    worker.join();
+}
+
+auto ReadAll(std::FILE *file) -> std::string {
+    std::string text;
+    std::rewind(file);
+    char buffer[4096];
+    std::size_t n;
+    while ((n = std::fread(buffer, 1, sizeof(buffer), file)) != 0) {
+        text.append(buffer, n);
+    }
+    return text;
+}
+} // namespace
+
+TEST_CASE("AllocationSampler: Test live samples follow the wrapper") {
+    using Wrapper = AllocatorWrapper<long, SampledMallocAllocator>;
+    using Plain = AllocatorWrapper<long, UnsampledMallocAllocator>;
+    static_assert(Wrapper::kSampled);
+    static_assert(!Plain::kSampled);
+    RateScope scope(1); // Sample every allocation.
+    const std::size_t before = AllocationSampler::LiveSamples();
+    std::vector<std::size_t> live;
+    std::vector<long *> blocks;
+    OnFreshThread([&] {
+        for (int i = 0; i < 10; ++i) {
+            blocks.push_back(Wrapper::Allocate(8));
+        }
+        live.push_back(AllocationSampler::LiveSamples());
+        for (int i = 0; i < 5; ++i) {
+            Wrapper::Deallocate(blocks[static_cast<std::size_t>(i)], 8);
+        }
+        live.push_back(AllocationSampler::LiveSamples());
+        // A reallocated block stays sampled once, under its new address.
+        blocks[5] = Wrapper::Reallocate(blocks[5], 8, 4096);
+        live.push_back(AllocationSampler::LiveSamples());
+        // Unsampled wrappers leave the table alone.
+        long *plain = Plain::Allocate(8);
+        live.push_back(AllocationSampler::LiveSamples());
+        Plain::Deallocate(plain, 8);
+    });
+    REQUIRE(live == std::vector<std::size_t>{before + 10, before + 5,
+                                             before + 5, before + 5});
+
+    Wrapper::Deallocate(blocks[5], 4096);
+    for (int i = 6; i < 10; ++i) {
+        Wrapper::Deallocate(blocks[static_cast<std::size_t>(i)], 8);
+    }
+    REQUIRE(AllocationSampler::LiveSamples() == before);
+}
+
+TEST_CASE("AllocationSampler: Test sampling rate") {
+    using Wrapper = AllocatorWrapper<char, SampledMallocAllocator>;
+    constexpr std::size_t kRate = 1024;
+    constexpr int kAllocations = 200000;
+    constexpr std::size_t kSize = 64;
+    RateScope scope(kRate);
+    const std::size_t before = AllocationSampler::LiveSamples();
+    std::vector<char *> blocks;
+    blocks.reserve(kAllocations);
+    OnFreshThread([&blocks] {
+        for (int i = 0; i < kAllocations; ++i) {
+            blocks.push_back(Wrapper::Allocate(kSize));
+        }
+    });
+    const std::size_t samples = AllocationSampler::LiveSamples() - before;
+    for (char *block : blocks) {
+        Wrapper::Deallocate(block, kSize);
+    }
+    // One sample per kRate bytes on average: 12500 expected.
+    constexpr std::size_t expected = kAllocations * kSize / kRate;
+    REQUIRE(samples > expected * 9 / 10);
+    REQUIRE(samples < expected * 11 / 10);
+}
+
+TEST_CASE("AllocationSampler: Test sampling can be turned off") {
+    using Wrapper = AllocatorWrapper<char, SampledMallocAllocator>;
+    RateScope scope(0);
+    const std::size_t before = AllocationSampler::LiveSamples();
+    char *block = nullptr;
+    OnFreshThread([&block] { block = Wrapper::Allocate(1 << 16); });
+    REQUIRE(AllocationSampler::LiveSamples() == before);
+    Wrapper::Deallocate(block, 1 << 16);
+}
+
+TEST_CASE("AllocationSampler: Test profile dumps") {
+    using Wrapper = AllocatorWrapper<char, SampledMallocAllocator>;
+    RateScope scope(1);
+    char *block = nullptr;
+    OnFreshThread([&block] { block = Wrapper::Allocate(100); });
+
+    std::FILE *profile = std::tmpfile();
+    REQUIRE(profile != nullptr);
+    AllocationSampler::WriteHeapProfile(profile);
+    const std::string text = ReadAll(profile);
+    std::fclose(profile);
+    REQUIRE(text.rfind("heap profile: ", 0) == 0);
+    REQUIRE(text.find("@ heap_v2/1\n") != std::string::npos);
+    REQUIRE(text.find("1: 100 [ 1: 100] @ 0x") != std::string::npos);
+    REQUIRE(text.find("MAPPED_LIBRARIES:") != std::string::npos);
+
+    std::FILE *folded = std::tmpfile();
+    REQUIRE(folded != nullptr);
+    AllocationSampler::WriteFolded(folded);
+    const std::string lines = ReadAll(folded);
+    std::fclose(folded);
+    // At rate 1 the 100-byte block is sampled for sure and counts in full.
+    REQUIRE(lines.find(" 100\n") != std::string::npos);
+
+    Wrapper::Deallocate(block, 100);
+}
@@ -0,0 +1,229 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <catch2/catch_test_macros.hpp>
+
+#include "allocation_sampler.h"
+#include "allocator_policy.h"
+#include "allocator_wrapper.h"
+#include "malloc_allocator.h"
+#include "memory_pool_allocator.h"
+#include "vector.h"
+
+using namespace easystl;
+
+namespace {
+struct BufferTag {};
+struct StatsTag {};
+struct SegregatorTag {};
+struct SmallTag {};
+struct LargeTag {};
+struct VectorTag {};
+
+using SmallBuffer = FixedBufferAllocator<256, BufferTag>;
+using BufferOrMalloc = FallbackAllocator<SmallBuffer, MallocAllocator>;
+using CountedMalloc = StatsAllocator<MallocAllocator, StatsTag>;
+using CountedSegregator =
+    StatsAllocator<Segregator<128, MemoryPoolAllocator, MallocAllocator>,
+                   SegregatorTag>;
+using ComposedAllocator = TracingAllocator<StatsAllocator<
+    Segregator<256, FallbackAllocator<FixedBufferAllocator<4096, VectorTag>,
+                                      MemoryPoolAllocator>,
+               MallocAllocator>,
+    VectorTag>>;
+
+struct MemberAllocator {
+    auto Allocate(std::size_t size) -> void * {
+        return MallocAllocator::Allocate(size);
+    }
+    auto Deallocate(void *ptr, std::size_t size) -> void {
+        MallocAllocator::Deallocate(ptr, size);
+    }
+    int id = 0;
+};
+
+// Serves every request from malloc and takes no alignment.
+struct PlainAllocator {
+    static auto Allocate(std::size_t size) -> void * {
+        return MallocAllocator::Allocate(size);
+    }
+    static auto Deallocate(void *ptr, std::size_t size) -> void {
+        MallocAllocator::Deallocate(ptr, size);
+    }
+};
+
+struct RecordingTracer {
+    static inline int allocated = 0;
+    static inline int deallocated = 0;
+    static auto OnAllocate(void * /*ptr*/, std::size_t /*size*/) -> void {
+        ++allocated;
+    }
+    static auto OnDeallocate(void * /*ptr*/, std::size_t /*size*/) -> void {
+        ++deallocated;
+    }
+};
+} // namespace
+
+TEST_CASE("AllocatorPolicy: Test concepts classify allocators") {
+    STATIC_REQUIRE(StaticAllocator<MallocAllocator>);
+    STATIC_REQUIRE(StaticAllocator<MemoryPoolAllocator>);
+    STATIC_REQUIRE(ReallocatingAllocator<MallocAllocator>);
+    STATIC_REQUIRE(AlignedAllocator<MemoryPoolAllocator>);
+    STATIC_REQUIRE(OwningAllocator<SmallBuffer>);
+    STATIC_REQUIRE(!OwningAllocator<MallocAllocator>);
+    STATIC_REQUIRE(ReportingAllocator<CountedMalloc>);
+    STATIC_REQUIRE(AllocatorConcept<MemberAllocator>);
+    STATIC_REQUIRE(!StaticAllocator<MemberAllocator>);
+    STATIC_REQUIRE(!AllocatorConcept<int>);
+
+    // Adapters expose what their parents support, and nothing more.
+    STATIC_REQUIRE(StaticAllocator<ComposedAllocator>);
+    STATIC_REQUIRE(ReallocatingAllocator<ComposedAllocator>);
+    STATIC_REQUIRE(SizingAllocator<ComposedAllocator>);
+    STATIC_REQUIRE(!SizingAllocator<MallocAllocator>);
+    STATIC_REQUIRE(AlignedAllocator<CountedSegregator>);
+    STATIC_REQUIRE(AlignedAllocator<BufferOrMalloc>);
+    STATIC_REQUIRE(!AlignedAllocator<StatsAllocator<PlainAllocator>>);
+    STATIC_REQUIRE(!AlignedAllocator<
+                   FallbackAllocator<SmallBuffer, PlainAllocator>>);
+}
+
+TEST_CASE("AllocatorPolicy: Test fallback takes over when the buffer is full") {
+    void *first = BufferOrMalloc::Allocate(200);
+    REQUIRE(SmallBuffer::Owns(first, 200));
+    void *second = BufferOrMalloc::Allocate(200);
+    REQUIRE(second != nullptr);
+    REQUIRE(!SmallBuffer::Owns(second, 200));
+
+    // Growing the buffered block moves it to the fallback with its contents.
+    std::memset(first, 'a', 200);
+    void *moved = BufferOrMalloc::Reallocate(first, 200, 1000);
+    REQUIRE(!SmallBuffer::Owns(moved, 1000));
+    REQUIRE(static_cast<char *>(moved)[199] == 'a');
+    REQUIRE(SmallBuffer::Used() == 0);
+
+    BufferOrMalloc::Deallocate(second, 200);
+    BufferOrMalloc::Deallocate(moved, 1000);
+    void *again = BufferOrMalloc::Allocate(64);
+    REQUIRE(SmallBuffer::Owns(again, 64));
+    BufferOrMalloc::Deallocate(again, 64);
+    REQUIRE(SmallBuffer::Used() == 0);
+}
+
+TEST_CASE("AllocatorPolicy: Test segregator routes by size") {
+    using Small = StatsAllocator<MemoryPoolAllocator, SmallTag>;
+    using Large = StatsAllocator<MallocAllocator, LargeTag>;
+    using Routed = Segregator<128, Small, Large>;
+    const AllocationStats smallbefore = Small::Stats();
+    const AllocationStats largebefore = Large::Stats();
+
+    void *small = Routed::Allocate(128);
+    void *large = Routed::Allocate(129);
+    REQUIRE(Small::Stats().allocations - smallbefore.allocations == 1);
+    REQUIRE(Large::Stats().allocations - largebefore.allocations == 1);
+
+    // Crossing the threshold moves the block to the other allocator.
+    std::memset(small, 'b', 128);
+    void *grown = Routed::Reallocate(small, 128, 512);
+    REQUIRE(static_cast<char *>(grown)[127] == 'b');
+    REQUIRE(Small::Stats().livebytes == smallbefore.livebytes);
+    REQUIRE(Large::Stats().allocations - largebefore.allocations == 2);
+
+    void *aligned = CountedSegregator::Allocate(32, 64);
+    REQUIRE(reinterpret_cast<std::uintptr_t>(aligned) % 64 == 0);
+    CountedSegregator::Deallocate(aligned, 32, 64);
+
+    Routed::Deallocate(grown, 512);
+    Routed::Deallocate(large, 129);
+    REQUIRE(Large::Stats().livebytes == largebefore.livebytes);
+}
+
+TEST_CASE("AllocatorPolicy: Test stats count calls, live and peak bytes") {
+    const AllocationStats before = CountedMalloc::Stats();
+    void *first = CountedMalloc::Allocate(100);
+    void *second = CountedMalloc::Allocate(300);
+    CountedMalloc::Deallocate(first, 100);
+    void *third = CountedMalloc::Reallocate(second, 300, 50);
+    const AllocationStats after = CountedMalloc::Stats();
+
+    REQUIRE(after.allocations - before.allocations == 2);
+    REQUIRE(after.deallocations - before.deallocations == 1);
+    REQUIRE(after.reallocations - before.reallocations == 1);
+    REQUIRE(after.allocatedbytes - before.allocatedbytes == 400);
+    REQUIRE(after.livebytes - before.livebytes == 50);
+    REQUIRE(after.peakbytes >= before.livebytes + 400);
+    REQUIRE(after.ToJson().find("\"peak_bytes\"") != std::string::npos);
+    CountedMalloc::Deallocate(third, 50);
+    REQUIRE(CountedMalloc::Stats().livebytes == before.livebytes);
+}
+
+TEST_CASE("AllocatorPolicy: Test tracing reports every block") {
+    using Traced = TracingAllocator<MallocAllocator, RecordingTracer>;
+    RecordingTracer::allocated = RecordingTracer::deallocated = 0;
+    void *ptr = Traced::Allocate(16);
+    ptr = Traced::Reallocate(ptr, 16, 64);
+    Traced::Deallocate(ptr, 64);
+    REQUIRE(RecordingTracer::allocated == 2);
+    REQUIRE(RecordingTracer::deallocated == 2);
+
+    // The default tracer feeds the allocation sampler. A fresh thread starts
+    // its countdown at the new rate.
+    const std::size_t rate = AllocationSampler::SetSampleRate(1);
+    const std::size_t before = AllocationSampler::LiveSamples();
+    std::size_t live = 0;
+    std::thread worker([&live] {
+        using Sampled = TracingAllocator<MallocAllocator>;
+        void *sampled = Sampled::Allocate(1024);
+        live = AllocationSampler::LiveSamples();
+        Sampled::Deallocate(sampled, 1024);
+    });
+    worker.join();
+    AllocationSampler::SetSampleRate(rate);
+    REQUIRE(live == before + 1);
+    REQUIRE(AllocationSampler::LiveSamples() == before);
+}
+
+TEST_CASE("AllocatorPolicy: Test composed allocators cost no storage") {
+    STATIC_REQUIRE(sizeof(vector<int, ComposedAllocator>) ==
+                   sizeof(vector<int>));
+    STATIC_REQUIRE(
+        std::is_empty_v<AllocatorWrapper<int, ComposedAllocator>>);
+
+    vector<long long, ComposedAllocator> values;
+    for (int i = 0; i < 1000; ++i) {
+        values.push_back(i);
+    }
+    REQUIRE(values.size() == 1000);
+    REQUIRE(values[999] == 999);
+    using Counters = StatsAllocator<
+        Segregator<256, FallbackAllocator<FixedBufferAllocator<4096, VectorTag>,
+                                          MemoryPoolAllocator>,
+                   MallocAllocator>,
+        VectorTag>;
+    REQUIRE(Counters::Stats().allocations > 0);
+    REQUIRE(Counters::Stats().livebytes > 0);
+}
+
+TEST_CASE("AllocatorPolicy: Test fallback passes the alignment on") {
+    struct AlignedTag {};
+    struct alignas(64) Padded {
+        char bytes[48];
+    };
+    using Buffer = FixedBufferAllocator<256, AlignedTag>;
+    using Aligned = FallbackAllocator<Buffer, MallocAllocator>;
+    void *first = Aligned::Allocate(8);
+    void *aligned = Aligned::Allocate(48, 64);
+    REQUIRE(Buffer::Owns(aligned, 48));
+    REQUIRE(reinterpret_cast<std::uintptr_t>(aligned) % 64 == 0);
+    Aligned::Deallocate(aligned, 48, 64);
+    Aligned::Deallocate(first, 8);
+
+    vector<Padded, Aligned> values;
+    for (int i = 0; i < 20; ++i) {
+        values.push_back(Padded{});
+        REQUIRE(reinterpret_cast<std::uintptr_t>(values.begin()) % 64 == 0);
+    }
+}
@@ -1,6 +1,18 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
 #include <catch2/catch_test_macros.hpp>
 
+#include "concurrent_pool_list.h"
 #include "malloc_allocator.h"
 #include "memory_pool_allocator.h"
 #include "allocator_wrapper.h"
@@ -112,9 +124,6 @@ TEST_CASE("MemoryPoolAllocator: Test alignment") {
 // allocator_wrapper test cases
 
 TEST_CASE("AllocatorWrapper: Memory allocation  using MemoryPoolAllocator") {
-#ifndef USEMALLOC
-    REQUIRE(true);
-#else
     using AllocType = AllocatorWrapper<int, MemoryPoolAllocator>;
 
     SECTION("Allocate single object") {
@@ -127,20 +136,16 @@ TEST_CASE("AllocatorWrapper: Memory allocation  using MemoryPoolAllocator") {
         constexpr std::size_t n = 10;
         int *ptr = AllocType::Allocate(n);
         REQUIRE(ptr != nullptr);
-        AllocType::Deallocate(ptr);
+        AllocType::Deallocate(ptr, n);
     }
 
     SECTION("Allocate zero object") {
         int *ptr = AllocType::Allocate(0);
         REQUIRE(ptr == nullptr);
     }
-#endif
 }
 
 TEST_CASE("AllocatorWrapper: Memory allocation using MallocAllocator") {
-#ifndef USEMALLOC
-    REQUIRE(TRUE)
-#else
     using AllocType = AllocatorWrapper<int, MallocAllocator>;
 
     SECTION("Allocate single object") {
@@ -153,12 +158,1053 @@ TEST_CASE("AllocatorWrapper: Memory allocation using MallocAllocator") {
         constexpr std::size_t n = 10;
         int *ptr = AllocType::Allocate(n);
         REQUIRE(ptr != nullptr);
-        AllocType::Deallocate(ptr);
+        AllocType::Deallocate(ptr, n);
     }
 
     SECTION("Allocate zero object") {
         int *ptr = AllocType::Allocate(0);
         REQUIRE(ptr == nullptr);
     }
+}
+
+// concurrent_pool_list test cases
+
+TEST_CASE("ConcurrentMemoryPoolList: Test push and pop") {
+    ConcurrentMemoryPoolList list;
+    void *nodes[3][1];
+
+    REQUIRE(list.Empty());
+    REQUIRE(list.Pop() == nullptr);
+
+    for (auto &node: nodes) {
+        list.Push(node);
+    }
+    REQUIRE_FALSE(list.Empty());
+    REQUIRE(list.Pop() == nodes[2]);
+    REQUIRE(list.Pop() == nodes[1]);
+    REQUIRE(list.Pop() == nodes[0]);
+    REQUIRE(list.Empty());
+}
+
+TEST_CASE("ConcurrentMemoryPoolList: Test push list and pop all") {
+    ConcurrentMemoryPoolList list;
+    void *nodes[3][1];
+    MemoryPoolList::GetNextNode(nodes[0]) = nodes[1];
+
+    list.Push(nodes[2]);
+    list.PushList(nodes[0], nodes[1]);
+    REQUIRE(list.Pop() == nodes[0]);
+
+    void *first = list.PopAll();
+    REQUIRE(list.Empty());
+    REQUIRE(first == nodes[1]);
+    REQUIRE(MemoryPoolList::GetNextNode(first) == nodes[2]);
+    REQUIRE(MemoryPoolList::GetNextNode(nodes[2]) == nullptr);
+}
+
+TEST_CASE("ConcurrentMemoryPoolList: Test concurrent push and pop") {
+    constexpr int thread_nums = 8;
+    constexpr int node_nums = 256;
+
+    ConcurrentMemoryPoolList list;
+    std::vector<std::array<void *, 2>> nodes(thread_nums * node_nums);
+    for (auto &node: nodes) {
+        list.Push(node.data());
+    }
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_nums; ++t) {
+        threads.emplace_back([&list] {
+            void *owned[node_nums];
+            for (int r = 0; r < 200; ++r) {
+                int count = 0;
+                while (count < node_nums) {
+                    if (void *node = list.Pop()) {
+                        owned[count++] = node;
+                    }
+                }
+                for (int i = 0; i < count; ++i) {
+                    list.Push(owned[i]);
+                }
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+
+    std::size_t count = 0;
+    while (list.Pop() != nullptr) {
+        ++count;
+    }
+    REQUIRE(count == nodes.size());
+}
+
+// thread-cached memory_pool_allocator test cases
+
+TEST_CASE("ThreadCachedPoolAllocator: Test concurrent allocate and deallocate") {
+    constexpr int thread_nums = 8;
+    constexpr int rounds = 2000;
+    constexpr std::size_t size = 24;
+
+    std::atomic<bool> corrupted{false};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_nums; ++t) {
+        threads.emplace_back([t, &corrupted] {
+            void *ptrs[64];
+            for (int r = 0; r < rounds; ++r) {
+                for (auto &ptr: ptrs) {
+                    ptr = ThreadCachedPoolAllocator::Allocate(size);
+                    *static_cast<int *>(ptr) = t;
+                }
+                for (auto &ptr: ptrs) {
+                    if (*static_cast<int *>(ptr) != t) {
+                        corrupted = true;
+                    }
+                    ThreadCachedPoolAllocator::Deallocate(ptr, size);
+                }
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+
+    REQUIRE_FALSE(corrupted);
+}
+
+TEST_CASE("ThreadCachedPoolAllocator: Test cross-thread deallocate") {
+    constexpr std::size_t size = 40;
+    constexpr int nums = 1000;
+
+    std::vector<void *> ptrs(nums);
+    std::thread producer([&ptrs] {
+        for (auto &ptr: ptrs) {
+            ptr = ThreadCachedPoolAllocator::Allocate(size);
+        }
+    });
+    producer.join();
+
+    std::thread consumer([&ptrs] {
+        for (auto *ptr: ptrs) {
+            ThreadCachedPoolAllocator::Deallocate(ptr, size);
+        }
+    });
+    consumer.join();
+
+    void *ptr = ThreadCachedPoolAllocator::Allocate(size);
+    REQUIRE(ptr != nullptr);
+    ThreadCachedPoolAllocator::Deallocate(ptr, size);
+}
+
+TEST_CASE("ThreadCachedPoolAllocator: Test thread exit returns cached blocks") {
+    constexpr std::size_t size = 56;
+
+    void *released = nullptr;
+    std::thread worker([&released] {
+        released = ThreadCachedPoolAllocator::Allocate(size);
+        ThreadCachedPoolAllocator::Deallocate(released, size);
+    });
+    worker.join();
+
+    // The worker's cache was drained on exit, so its blocks are handed out
+    // again by the next batch this thread fetches.
+    bool reused = false;
+    std::vector<void *> ptrs;
+    for (std::size_t i = 0; i < ThreadCachedPoolTraits::kCacheBatch; ++i) {
+        ptrs.push_back(ThreadCachedPoolAllocator::Allocate(size));
+        reused = reused || ptrs.back() == released;
+    }
+    for (auto *ptr: ptrs) {
+        ThreadCachedPoolAllocator::Deallocate(ptr, size);
+    }
+
+    REQUIRE(reused);
+}
+
+TEST_CASE("MemoryPoolAllocator: Test geometric size classes") {
+    using Pool = BasicMemoryPoolAllocator<LargeClassPoolTraits>;
+
+    for (const std::size_t size: {129, 1000, 4096, 20000, 32768}) {
+        void *ptr1 = Pool::Allocate(size);
+        void *ptr2 = Pool::Allocate(size);
+        REQUIRE(ptr1 != nullptr);
+        REQUIRE(ptr2 != nullptr);
+        REQUIRE(reinterpret_cast<std::uintptr_t>(ptr1) % kAlign == 0);
+        std::memset(ptr1, 0xab, size);
+        std::memset(ptr2, 0xcd, size);
+        REQUIRE(static_cast<unsigned char *>(ptr1)[size - 1] == 0xab);
+
+        Pool::Deallocate(ptr1, size);
+        void *ptr3 = Pool::Allocate(size);
+        REQUIRE(ptr3 == ptr1);
+        Pool::Deallocate(ptr3, size);
+        Pool::Deallocate(ptr2, size);
+    }
+}
+
+// memory_pool_allocator trim test cases
+
+namespace {
+struct TrimTestTraits : DefaultPoolTraits {};
+struct AutoTrimTestTraits : DefaultPoolTraits {
+    static constexpr std::size_t kTrimThreshold = 4096;
+};
+struct ThreadCachedTrimTestTraits : ThreadCachedPoolTraits {};
+} // namespace
+
+TEST_CASE("MemoryPoolAllocator: Test trim releases free chunks") {
+    using Pool = BasicMemoryPoolAllocator<TrimTestTraits>;
+    constexpr std::size_t size = 64;
+    constexpr int nums = 4096;
+
+    std::vector<void *> ptrs(nums);
+    for (auto &ptr: ptrs) {
+        ptr = Pool::Allocate(size);
+    }
+    const std::size_t footprint = Pool::Footprint();
+    REQUIRE(footprint >= nums * size);
+    REQUIRE(Pool::Trim() == 0);
+
+    for (auto *ptr: ptrs) {
+        Pool::Deallocate(ptr, size);
+    }
+    REQUIRE(Pool::Trim() == footprint);
+    REQUIRE(Pool::Footprint() == 0);
+    REQUIRE(Pool::Trim() == 0);
+
+    void *ptr = Pool::Allocate(size);
+    REQUIRE(ptr != nullptr);
+    Pool::Deallocate(ptr, size);
+}
+
+TEST_CASE("MemoryPoolAllocator: Test trim keeps chunks in use") {
+    using Pool = BasicMemoryPoolAllocator<TrimTestTraits>;
+    constexpr std::size_t size = 32;
+    constexpr int nums = 4096;
+
+    std::vector<void *> ptrs(nums);
+    for (auto &ptr: ptrs) {
+        ptr = Pool::Allocate(size);
+        *static_cast<int *>(ptr) = 42;
+    }
+    for (std::size_t i = 1; i < ptrs.size(); ++i) {
+        Pool::Deallocate(ptrs[i], size);
+    }
+    const std::size_t footprint = Pool::Footprint();
+    REQUIRE(Pool::Trim() < footprint);
+    REQUIRE(Pool::Footprint() > 0);
+    REQUIRE(*static_cast<int *>(ptrs[0]) == 42);
+    Pool::Deallocate(ptrs[0], size);
+    Pool::Trim();
+    REQUIRE(Pool::Footprint() == 0);
+}
+
+TEST_CASE("MemoryPoolAllocator: Test automatic trim threshold") {
+    using Pool = BasicMemoryPoolAllocator<AutoTrimTestTraits>;
+    constexpr std::size_t size = 128;
+    constexpr int nums = 4096;
+
+    std::vector<void *> ptrs(nums);
+    for (auto &ptr: ptrs) {
+        ptr = Pool::Allocate(size);
+    }
+    const std::size_t footprint = Pool::Footprint();
+    for (auto *ptr: ptrs) {
+        Pool::Deallocate(ptr, size);
+    }
+    REQUIRE(Pool::Footprint() < footprint);
+}
+
+TEST_CASE("ThreadCachedPoolAllocator: Test trim after worker threads exit") {
+    using Pool = BasicMemoryPoolAllocator<ThreadCachedTrimTestTraits>;
+    constexpr std::size_t size = 48;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([] {
+            std::vector<void *> ptrs(2048);
+            for (auto &ptr: ptrs) {
+                ptr = Pool::Allocate(size);
+            }
+            for (auto *ptr: ptrs) {
+                Pool::Deallocate(ptr, size);
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+
+    REQUIRE(Pool::Footprint() > 0);
+    REQUIRE(Pool::Trim() > 0);
+    REQUIRE(Pool::Footprint() == 0);
+
+    void *ptr = Pool::Allocate(size);
+    REQUIRE(ptr != nullptr);
+    REQUIRE(Pool::Footprint() > 0);
+    Pool::Deallocate(ptr, size);
+}
+
+// allocator statistics test cases
+
+namespace {
+struct StatsTestTraits : DefaultPoolTraits {
+    static constexpr bool kStats = true;
+};
+struct ThreadCachedStatsTestTraits : ThreadCachedPoolTraits {
+    static constexpr bool kStats = true;
+};
+} // namespace
+
+TEST_CASE("MemoryPoolAllocator: Test statistics") {
+    using Pool = BasicMemoryPoolAllocator<StatsTestTraits>;
+    constexpr std::size_t size = 24;
+    constexpr std::size_t index = 2;
+
+    void *ptrs[5];
+    for (auto &ptr: ptrs) {
+        ptr = Pool::Allocate(size);
+    }
+    Pool::Deallocate(ptrs[0], size);
+    void *large = Pool::Allocate(kMaxBytes + 1);
+    Pool::Deallocate(large, kMaxBytes + 1);
+
+    auto stats = Pool::Stats();
+    REQUIRE(stats.classes[index].size == 24);
+    REQUIRE(stats.classes[index].allocations == 5);
+    REQUIRE(stats.classes[index].deallocations == 1);
+    REQUIRE(stats.classes[index].refills == 1);
+    REQUIRE(stats.classes[index].cachedblocks == 20 - 5 + 1);
+    REQUIRE(stats.classes[index].CachedBytes() == 16 * 24);
+    REQUIRE(stats.classes[0].allocations == 0);
+    REQUIRE(stats.chunks == 1);
+    REQUIRE(stats.systembytes == Pool::Footprint());
+    REQUIRE(stats.largeallocations == 1);
+    REQUIRE(stats.largedeallocations == 1);
+
+    for (std::size_t i = 1; i < 5; ++i) {
+        Pool::Deallocate(ptrs[i], size);
+    }
+    Pool::Trim();
+    stats = Pool::Stats();
+    REQUIRE(stats.chunks == 0);
+    REQUIRE(stats.classes[index].cachedblocks == 0);
+}
+
+TEST_CASE("MemoryPoolAllocator: Test statistics dump") {
+    using Pool = BasicMemoryPoolAllocator<StatsTestTraits>;
+
+    void *ptr = Pool::Allocate(8);
+    const auto stats = Pool::Stats();
+    Pool::Deallocate(ptr, 8);
+
+    const std::string text = stats.ToText();
+    REQUIRE(text.find("refills") != std::string::npos);
+    REQUIRE(text.find("chunks: 1") != std::string::npos);
+
+    const std::string json = stats.ToJson();
+    REQUIRE(json.front() == '{');
+    REQUIRE(json.back() == '}');
+    REQUIRE(json.find("\"chunks\":1") != std::string::npos);
+    REQUIRE(json.find("{\"size\":8,\"allocations\":") != std::string::npos);
+}
+
+TEST_CASE("ThreadCachedPoolAllocator: Test statistics") {
+    using Pool = BasicMemoryPoolAllocator<ThreadCachedStatsTestTraits>;
+    constexpr std::size_t size = 16;
+    constexpr int nums = 1000;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([] {
+            std::vector<void *> ptrs(nums);
+            for (auto &ptr: ptrs) {
+                ptr = Pool::Allocate(size);
+            }
+            for (auto *ptr: ptrs) {
+                Pool::Deallocate(ptr, size);
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+
+    const auto stats = Pool::Stats();
+    REQUIRE(stats.classes[1].allocations == 4 * nums);
+    REQUIRE(stats.classes[1].deallocations == 4 * nums);
+    REQUIRE(stats.classes[1].refills > 0);
+    REQUIRE(stats.classes[1].cachedblocks >= nums);
+}
+
+namespace {
+struct AlignedStatsTestTraits : DefaultPoolTraits {
+    static constexpr bool kStats = true;
+};
+struct ThreadCachedAlignedStatsTestTraits : ThreadCachedPoolTraits {
+    static constexpr bool kStats = true;
+};
+
+template <class Pool> auto CheckAlignedStatistics() -> void {
+    void *ptrs[3];
+    for (auto &ptr: ptrs) {
+        ptr = Pool::Allocate(24, 32);
+    }
+    Pool::Deallocate(ptrs[0], 24, 32);
+    void *line = Pool::Allocate(8, 64);
+    Pool::Deallocate(line, 8, 64);
+
+    // Aligned blocks count in the size class they are carved from.
+    const auto stats = Pool::Stats();
+    std::size_t allocations = 0;
+    std::size_t deallocations = 0;
+    std::size_t refills = 0;
+    for (const auto &counts: stats.classes) {
+        allocations += counts.allocations;
+        deallocations += counts.deallocations;
+        refills += counts.refills;
+    }
+    REQUIRE(allocations == 4);
+    REQUIRE(deallocations == 2);
+    REQUIRE(refills >= 2);
+    REQUIRE(stats.largeallocations == 0);
+
+    Pool::Deallocate(ptrs[1], 24, 32);
+    Pool::Deallocate(ptrs[2], 24, 32);
+}
+} // namespace
+
+TEST_CASE("MemoryPoolAllocator: Test statistics of aligned blocks") {
+    CheckAlignedStatistics<BasicMemoryPoolAllocator<AlignedStatsTestTraits>>();
+    CheckAlignedStatistics<
+        BasicMemoryPoolAllocator<ThreadCachedAlignedStatsTestTraits>>();
+}
+
+namespace {
+struct ThreadCachedTrimStatsTestTraits : ThreadCachedPoolTraits {
+    static constexpr bool kStats = true;
+    static constexpr std::size_t kTrimThreshold = 4096;
+};
+} // namespace
+
+TEST_CASE("ThreadCachedPoolAllocator: Test trim keeps concurrent counts") {
+    using Pool = BasicMemoryPoolAllocator<ThreadCachedTrimStatsTestTraits>;
+    constexpr std::size_t size = 32;
+    constexpr int nums = 2000;
+
+    // Threads move blocks between their caches and the central lists while
+    // Trim runs, so Trim must adjust the counters rather than reset them.
+    std::atomic<bool> done{false};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([] {
+            std::vector<void *> ptrs(nums);
+            for (int round = 0; round < 10; ++round) {
+                for (auto &ptr: ptrs) {
+                    ptr = Pool::Allocate(size);
+                }
+                for (auto *ptr: ptrs) {
+                    Pool::Deallocate(ptr, size);
+                }
+            }
+        });
+    }
+    std::thread trimmer([&done] {
+        while (!done.load()) {
+            Pool::Trim();
+        }
+    });
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    done = true;
+    trimmer.join();
+
+    // The exited threads flushed their caches, so every block is free and
+    // the counters must have come back to exactly zero.
+    Pool::Trim();
+    REQUIRE(Pool::Footprint() == 0);
+    const auto stats = Pool::Stats();
+    for (const auto &counters: stats.classes) {
+        REQUIRE(counters.cachedblocks == 0);
+    }
+}
+
+#ifdef EASYSTL_ENABLE_ALLOCATOR_STATS
+TEST_CASE("MallocAllocator: Test statistics") {
+    const MallocStats before = MallocAllocator::Stats();
+    void *ptr = MallocAllocator::Allocate(100);
+    ptr = MallocAllocator::Reallocate(ptr, 100, 200);
+    MallocAllocator::Deallocate(ptr, 200);
+    const MallocStats after = MallocAllocator::Stats();
+
+    REQUIRE(after.allocations - before.allocations == 1);
+    REQUIRE(after.reallocations - before.reallocations == 1);
+    REQUIRE(after.deallocations - before.deallocations == 1);
+    REQUIRE(after.allocatedbytes - before.allocatedbytes == 100);
+    REQUIRE(after.freedbytes - before.freedbytes == 200);
+    REQUIRE(after.ToJson().find("\"allocations\":") != std::string::npos);
+}
 #endif
+
+// batch allocation test cases
+
+namespace {
+struct BatchTestTraits : DefaultPoolTraits {
+    static constexpr bool kStats = true;
+};
+struct ThreadCachedBatchTestTraits : ThreadCachedPoolTraits {};
+} // namespace
+
+TEST_CASE("MemoryPoolAllocator: Test batch allocate and deallocate") {
+    using Pool = BasicMemoryPoolAllocator<BatchTestTraits>;
+    constexpr std::size_t size = 24;
+    constexpr std::size_t nums = 1000;
+
+    std::vector<void *> ptrs(nums);
+    REQUIRE(Pool::AllocateBatch(size, nums, ptrs.data()) == nums);
+    int misaligned = 0;
+    for (std::size_t i = 0; i < nums; ++i) {
+        if (reinterpret_cast<std::uintptr_t>(ptrs[i]) % kAlign != 0) {
+            ++misaligned;
+        }
+        std::memset(ptrs[i], static_cast<int>(i), size);
+    }
+    REQUIRE(misaligned == 0);
+    std::vector<void *> sorted(ptrs);
+    std::sort(sorted.begin(), sorted.end());
+    int overlaps = 0;
+    for (std::size_t i = 1; i < nums; ++i) {
+        if (static_cast<char *>(sorted[i - 1]) + size > sorted[i]) {
+            ++overlaps;
+        }
+    }
+    REQUIRE(overlaps == 0);
+
+    const auto before = Pool::Stats();
+    Pool::DeallocateBatch(size, nums, ptrs.data());
+    const auto after = Pool::Stats();
+    const std::size_t index = BatchTestTraits::SizeClasses::Index(size);
+    REQUIRE(after.classes[index].deallocations -
+                before.classes[index].deallocations == nums);
+    REQUIRE(after.classes[index].cachedblocks -
+                before.classes[index].cachedblocks == nums);
+
+    // The freed blocks are handed out again before any new chunk is carved.
+    const std::size_t footprint = Pool::Footprint();
+    std::vector<void *> again(nums);
+    REQUIRE(Pool::AllocateBatch(size, nums, again.data()) == nums);
+    REQUIRE(Pool::Footprint() == footprint);
+    std::sort(again.begin(), again.end());
+    REQUIRE(again == sorted);
+    Pool::DeallocateBatch(size, nums, again.data());
+}
+
+TEST_CASE("MemoryPoolAllocator: Test batch allocate large blocks") {
+    using Pool = BasicMemoryPoolAllocator<BatchTestTraits>;
+    constexpr std::size_t size = 4096;
+    void *ptrs[8];
+    REQUIRE(Pool::AllocateBatch(size, 8, ptrs) == 8);
+    for (void *ptr: ptrs) {
+        std::memset(ptr, 0xab, size);
+    }
+    Pool::DeallocateBatch(size, 8, ptrs);
+}
+
+TEST_CASE("ThreadCachedPoolAllocator: Test batch allocate and deallocate") {
+    using Pool = BasicMemoryPoolAllocator<ThreadCachedBatchTestTraits>;
+    constexpr std::size_t size = 40;
+    constexpr std::size_t nums = 4 * ThreadCachedPoolTraits::kCacheCapacity;
+
+    std::vector<std::thread> threads;
+    std::atomic<int> failures{0};
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&failures, t] {
+            std::vector<void *> ptrs(nums);
+            for (int round = 0; round < 50; ++round) {
+                if (Pool::AllocateBatch(size, nums, ptrs.data()) != nums) {
+                    ++failures;
+                    return;
+                }
+                for (void *ptr: ptrs) {
+                    *static_cast<int *>(ptr) = t;
+                }
+                for (void *ptr: ptrs) {
+                    if (*static_cast<int *>(ptr) != t) {
+                        ++failures;
+                    }
+                }
+                Pool::DeallocateBatch(size, nums, ptrs.data());
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    REQUIRE(failures == 0);
+}
+
+// reallocation test cases
+
+namespace {
+struct ReallocTestTraits : DefaultPoolTraits {};
+} // namespace
+
+TEST_CASE("MemoryPoolAllocator: Test reallocate keeps contents") {
+    using Pool = BasicMemoryPoolAllocator<ReallocTestTraits>;
+    constexpr std::size_t sizes[] = {8, 24, 128, 200, 4096, 100, 16};
+
+    auto *ptr = static_cast<unsigned char *>(Pool::Allocate(sizes[0]));
+    for (std::size_t i = 0; i < sizes[0]; ++i) {
+        ptr[i] = static_cast<unsigned char>(i);
+    }
+    for (std::size_t step = 1; step < std::size(sizes); ++step) {
+        const std::size_t oldsize = sizes[step - 1];
+        const std::size_t newsize = sizes[step];
+        ptr = static_cast<unsigned char *>(
+            Pool::Reallocate(ptr, oldsize, newsize));
+        REQUIRE(ptr != nullptr);
+        int mismatches = 0;
+        for (std::size_t i = 0; i < std::min(oldsize, newsize); ++i) {
+            if (ptr[i] != static_cast<unsigned char>(i)) {
+                ++mismatches;
+            }
+        }
+        REQUIRE(mismatches == 0);
+        for (std::size_t i = oldsize; i < newsize; ++i) {
+            ptr[i] = static_cast<unsigned char>(i);
+        }
+    }
+    Pool::Deallocate(ptr, sizes[std::size(sizes) - 1]);
+}
+
+TEST_CASE("MemoryPoolAllocator: Test reallocate of large blocks") {
+    using Pool = BasicMemoryPoolAllocator<ReallocTestTraits>;
+    // Crossing kMaxBytes moves the block to malloc; growing it by less than
+    // one size-class step must still resize it, as malloc knows nothing of
+    // the pool's rounding.
+    constexpr std::size_t sizes[] = {100, kMaxBytes + 1, kMaxBytes + 8, 64};
+
+    auto *ptr = static_cast<unsigned char *>(Pool::Allocate(sizes[0]));
+    std::memset(ptr, 'a', sizes[0]);
+    for (std::size_t step = 1; step < std::size(sizes); ++step) {
+        const std::size_t oldsize = sizes[step - 1];
+        const std::size_t newsize = sizes[step];
+        ptr = static_cast<unsigned char *>(
+            Pool::Reallocate(ptr, oldsize, newsize));
+        REQUIRE(ptr != nullptr);
+        REQUIRE(ptr[std::min(oldsize, newsize) - 1] == 'a');
+        std::memset(ptr, 'a', newsize);
+    }
+    Pool::Deallocate(ptr, sizes[std::size(sizes) - 1]);
+}
+
+TEST_CASE("MemoryPoolAllocator: Test reallocate in place at the chunk tail") {
+    using Pool = BasicMemoryPoolAllocator<ReallocTestTraits>;
+    Pool::Trim();
+    REQUIRE(Pool::Footprint() == 0);
+
+    // A refill pushes the carved blocks in address order, so the block popped
+    // next is the last one carved and borders the uncarved space.
+    void *first = Pool::Allocate(8);
+    void *last = Pool::Allocate(8);
+    REQUIRE(last > first);
+    REQUIRE(Pool::Reallocate(last, 8, 64) == last);
+    REQUIRE(Pool::Reallocate(last, 64, 16) == last);
+    Pool::Deallocate(last, 16);
+    Pool::Deallocate(first, 8);
+}
+
+namespace {
+struct AlignedTestTraits : DefaultPoolTraits {};
+struct ThreadCachedAlignedTestTraits : ThreadCachedPoolTraits {};
+
+auto IsAligned(const void *ptr, std::size_t align) -> bool {
+    return reinterpret_cast<std::uintptr_t>(ptr) % align == 0;
+}
+} // namespace
+
+TEST_CASE("MemoryPoolAllocator: Test aligned allocate and deallocate") {
+    using Pool = BasicMemoryPoolAllocator<AlignedTestTraits>;
+    for (std::size_t align : {16, 32, 64}) {
+        std::vector<void *> blocks;
+        int misaligned = 0;
+        for (std::size_t size = 1; size <= 128; size += 7) {
+            void *ptr = Pool::Allocate(size, align);
+            REQUIRE(ptr != nullptr);
+            if (!IsAligned(ptr, align)) {
+                ++misaligned;
+            }
+            std::memset(ptr, 0xab, size);
+            blocks.push_back(ptr);
+            // Interleave plain blocks so the carve position drifts.
+            Pool::Deallocate(Pool::Allocate(size), size);
+        }
+        REQUIRE(misaligned == 0);
+        std::size_t size = 1;
+        for (void *ptr : blocks) {
+            Pool::Deallocate(ptr, size, align);
+            size += 7;
+        }
+        // A freed block is reused for the same size and alignment.
+        void *ptr = Pool::Allocate(100, align);
+        Pool::Deallocate(ptr, 100, align);
+        REQUIRE(Pool::Allocate(100, align) == ptr);
+        Pool::Deallocate(ptr, 100, align);
+    }
+}
+
+TEST_CASE("MemoryPoolAllocator: Test aligned requests served by malloc") {
+    using Pool = BasicMemoryPoolAllocator<AlignedTestTraits>;
+    void *large = Pool::Allocate(1000, 64);
+    REQUIRE(IsAligned(large, 64));
+    Pool::Deallocate(large, 1000, 64);
+
+    void *page = Pool::Allocate(24, 4096);
+    REQUIRE(IsAligned(page, 4096));
+    Pool::Deallocate(page, 24, 4096);
+
+    void *plain = Pool::Allocate(24, 8);
+    REQUIRE(IsAligned(plain, 8));
+    Pool::Deallocate(plain, 24, 8);
+}
+
+namespace {
+/**
+ * A chunk source that serves a single chunk and is out of memory after it.
+ */
+struct OneChunkSource {
+    static inline bool served = false;
+
+    static auto Allocate(std::size_t &bytes) -> void * {
+        if (served) {
+            return nullptr;
+        }
+        served = true;
+        return MallocChunkSource::Allocate(bytes);
+    }
+    static auto Deallocate(void *chunk, std::size_t bytes) -> void {
+        MallocChunkSource::Deallocate(chunk, bytes);
+    }
+};
+struct OneChunkTestTraits : DefaultPoolTraits {
+    using ChunkSource = OneChunkSource;
+};
+} // namespace
+
+TEST_CASE("MemoryPoolAllocator: Test aligned request with an exhausted "
+          "chunk source") {
+    using Pool = BasicMemoryPoolAllocator<OneChunkTestTraits>;
+    std::vector<void *> blocks;
+    for (void *ptr = Pool::Allocate(64); ptr != nullptr;
+         ptr = Pool::Allocate(64)) {
+        blocks.push_back(ptr);
+    }
+    REQUIRE(!blocks.empty());
+    const auto misaligned =
+        std::find_if(blocks.begin(), blocks.end(),
+                     [](const void *ptr) { return !IsAligned(ptr, 64); });
+    REQUIRE(misaligned != blocks.end());
+    Pool::Deallocate(*misaligned, 64);
+    blocks.erase(misaligned);
+
+    // The freed block cannot hold an aligned one; the pool must give up
+    // instead of carving it over and over.
+    void *aligned = Pool::Allocate(64, 64);
+    REQUIRE((aligned == nullptr || IsAligned(aligned, 64)));
+    if (aligned != nullptr) {
+        Pool::Deallocate(aligned, 64, 64);
+    }
+    for (void *ptr : blocks) {
+        Pool::Deallocate(ptr, 64);
+    }
+}
+
+TEST_CASE("MemoryPoolAllocator: Test aligned reallocate keeps contents") {
+    using Pool = BasicMemoryPoolAllocator<AlignedTestTraits>;
+    constexpr std::size_t sizes[] = {16, 40, 128, 500, 64, 8};
+
+    auto *ptr = static_cast<unsigned char *>(Pool::Allocate(sizes[0], 64));
+    for (std::size_t i = 0; i < sizes[0]; ++i) {
+        ptr[i] = static_cast<unsigned char>(i);
+    }
+    for (std::size_t step = 1; step < std::size(sizes); ++step) {
+        const std::size_t oldsize = sizes[step - 1];
+        const std::size_t newsize = sizes[step];
+        ptr = static_cast<unsigned char *>(
+            Pool::Reallocate(ptr, oldsize, newsize, 64));
+        REQUIRE(ptr != nullptr);
+        REQUIRE(IsAligned(ptr, 64));
+        int mismatches = 0;
+        for (std::size_t i = 0; i < std::min(oldsize, newsize); ++i) {
+            if (ptr[i] != static_cast<unsigned char>(i)) {
+                ++mismatches;
+            }
+        }
+        REQUIRE(mismatches == 0);
+        for (std::size_t i = oldsize; i < newsize; ++i) {
+            ptr[i] = static_cast<unsigned char>(i);
+        }
+    }
+    Pool::Deallocate(ptr, sizes[std::size(sizes) - 1], 64);
+}
+
+TEST_CASE("ThreadCachedPoolAllocator: Test concurrent aligned allocate") {
+    using Pool = BasicMemoryPoolAllocator<ThreadCachedAlignedTestTraits>;
+    constexpr int kThreads = 4;
+    constexpr int kIterations = 2000;
+    std::atomic<int> misaligned{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&misaligned] {
+            std::vector<void *> blocks;
+            for (int i = 0; i < kIterations; ++i) {
+                const std::size_t size = 8 + i % 100;
+                void *ptr = Pool::Allocate(size, 32);
+                if (!IsAligned(ptr, 32)) {
+                    ++misaligned;
+                }
+                *static_cast<int *>(ptr) = i;
+                blocks.push_back(ptr);
+                Pool::Deallocate(Pool::Allocate(24), 24);
+            }
+            for (int i = 0; i < kIterations; ++i) {
+                Pool::Deallocate(blocks[i], 8 + i % 100, 32);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    REQUIRE(misaligned == 0);
+}
+
+TEST_CASE("MallocAllocator: Test aligned allocate") {
+    for (std::size_t align : {8, 16, 64, 256, 4096}) {
+        void *ptr = MallocAllocator::Allocate(100, align);
+        REQUIRE(ptr != nullptr);
+        REQUIRE(IsAligned(ptr, align));
+        std::memset(ptr, 0x5a, 100);
+        ptr = MallocAllocator::Reallocate(ptr, 100, 300, align);
+        REQUIRE(IsAligned(ptr, align));
+        REQUIRE(static_cast<unsigned char *>(ptr)[99] == 0x5a);
+        MallocAllocator::Deallocate(ptr, 300, align);
+    }
+}
+
+TEST_CASE("MemoryPoolAllocator: Test cache-aligned blocks own their lines") {
+    using Pool = BasicMemoryPoolAllocator<AlignedTestTraits>;
+    constexpr std::size_t kLine = Pool::kCacheLineSize;
+    std::vector<char *> lines;
+    std::vector<void *> others;
+    for (int i = 0; i < 64; ++i) {
+        lines.push_back(static_cast<char *>(Pool::AllocateCacheAligned(8)));
+        others.push_back(Pool::Allocate(8));
+        others.push_back(Pool::Allocate(40));
+    }
+    std::sort(lines.begin(), lines.end());
+    int shared = 0;
+    for (std::size_t i = 0; i < lines.size(); ++i) {
+        if (!IsAligned(lines[i], kLine) ||
+            (i > 0 && lines[i] - lines[i - 1] < static_cast<long>(kLine))) {
+            ++shared;
+        }
+        for (void *other : others) {
+            if (other >= lines[i] && other < lines[i] + kLine) {
+                ++shared;
+            }
+        }
+    }
+    REQUIRE(shared == 0);
+    for (char *line : lines) {
+        Pool::DeallocateCacheAligned(line, 8);
+    }
+    for (std::size_t i = 0; i < others.size(); ++i) {
+        Pool::Deallocate(others[i], i % 2 == 0 ? 8 : 40);
+    }
+}
+
+// size header test cases
+
+namespace {
+struct SizeHeaderTestTraits : DefaultPoolTraits {
+    static constexpr bool kSizeHeader = true;
+};
+struct ThreadCachedSizeHeaderTestTraits : ThreadCachedPoolTraits {
+    static constexpr bool kSizeHeader = true;
+};
+
+const char *lastreport = nullptr;
+
+auto RecordLastReport(const char *what, const void * /*block*/) -> void {
+    lastreport = what;
+}
+} // namespace
+
+TEST_CASE("MemoryPoolAllocator: Test size-less deallocate") {
+    using Pool = BasicMemoryPoolAllocator<SizeHeaderTestTraits>;
+    for (std::size_t size : {1, 8, 24, 100, 120, 128, 129, 1000, 100000}) {
+        void *ptr = Pool::Allocate(size);
+        REQUIRE(Pool::SizeOf(ptr) == size);
+        REQUIRE(IsAligned(ptr, size > 120 ? alignof(std::max_align_t) : 8));
+        std::memset(ptr, 0x5a, size);
+        Pool::Deallocate(ptr);
+        // The block went back to the free list of its size class.
+        if (size <= 120) {
+            void *again = Pool::Allocate(size);
+            REQUIRE(again == ptr);
+            Pool::Deallocate(again);
+        }
+    }
+    for (std::size_t align : {16, 64, 4096}) {
+        void *ptr = Pool::Allocate(40, align);
+        REQUIRE(IsAligned(ptr, align));
+        REQUIRE(Pool::SizeOf(ptr) == 40);
+        std::memset(ptr, 0x5a, 40);
+        Pool::Deallocate(ptr);
+    }
+}
+
+TEST_CASE("MemoryPoolAllocator: Test size header follows reallocate") {
+    using Pool = BasicMemoryPoolAllocator<SizeHeaderTestTraits>;
+    auto *ptr = static_cast<unsigned char *>(Pool::Allocate(16));
+    for (std::size_t i = 0; i < 16; ++i) {
+        ptr[i] = static_cast<unsigned char>(i);
+    }
+    ptr = static_cast<unsigned char *>(Pool::Reallocate(ptr, 16, 20));
+    REQUIRE(Pool::SizeOf(ptr) == 20);
+    ptr = static_cast<unsigned char *>(Pool::Reallocate(ptr, 20, 500));
+    REQUIRE(Pool::SizeOf(ptr) == 500);
+    int mismatches = 0;
+    for (std::size_t i = 0; i < 16; ++i) {
+        if (ptr[i] != i) {
+            ++mismatches;
+        }
+    }
+    REQUIRE(mismatches == 0);
+    Pool::Deallocate(ptr);
+}
+
+TEST_CASE("MemoryPoolAllocator: Test sized deallocate is validated") {
+    using Pool = BasicMemoryPoolAllocator<SizeHeaderTestTraits>;
+    const auto old = PoolHardening::SetCorruptionHandler(&RecordLastReport);
+    lastreport = nullptr;
+    void *ptr = Pool::Allocate(24);
+    Pool::Deallocate(ptr, 24);
+    REQUIRE(lastreport == nullptr);
+
+    ptr = Pool::Allocate(24);
+    Pool::Deallocate(ptr, 100);
+    REQUIRE(lastreport != nullptr);
+    // The header's size won, so the block is reused for its real class.
+    REQUIRE(Pool::Allocate(24) == ptr);
+    Pool::Deallocate(ptr, 24);
+    PoolHardening::SetCorruptionHandler(old);
+}
+
+TEST_CASE("ThreadCachedPoolAllocator: Test size-less deallocate across threads") {
+    using Pool = BasicMemoryPoolAllocator<ThreadCachedSizeHeaderTestTraits>;
+    constexpr int kBlocks = 4000;
+    std::vector<void *> blocks(kBlocks);
+    std::thread producer([&blocks] {
+        for (int i = 0; i < kBlocks; ++i) {
+            const std::size_t size = 1 + static_cast<std::size_t>(i) % 200;
+            blocks[static_cast<std::size_t>(i)] = Pool::Allocate(size);
+            std::memset(blocks[static_cast<std::size_t>(i)], 0x11, size);
+        }
+    });
+    producer.join();
+    int wrongsizes = 0;
+    std::thread consumer([&blocks, &wrongsizes] {
+        for (int i = 0; i < kBlocks; ++i) {
+            void *ptr = blocks[static_cast<std::size_t>(i)];
+            if (Pool::SizeOf(ptr) != 1 + static_cast<std::size_t>(i) % 200) {
+                ++wrongsizes;
+            }
+            Pool::Deallocate(ptr);
+        }
+    });
+    consumer.join();
+    REQUIRE(wrongsizes == 0);
+}
+
+namespace {
+struct ParserTestTag {};
+struct CacheTestTag {};
+struct ReleaseTestTag {};
+} // namespace
+
+TEST_CASE("TaggedPoolAllocator: Test tags isolate pools") {
+    using ParserPool = TaggedPoolAllocator<ParserTestTag>;
+    using CachePool = TaggedPoolAllocator<CacheTestTag>;
+    static_assert(!std::is_same_v<ParserPool, CachePool>);
+
+    void *parserblock = ParserPool::Allocate(48);
+    ParserPool::Deallocate(parserblock, 48);
+    const std::size_t parserfootprint = ParserPool::Footprint();
+    REQUIRE(parserfootprint > 0);
+    REQUIRE(CachePool::Footprint() == 0);
+
+    // A block freed to one pool is never handed out by the other.
+    void *cacheblock = CachePool::Allocate(48);
+    REQUIRE(cacheblock != parserblock);
+    REQUIRE(ParserPool::Footprint() == parserfootprint);
+    CachePool::Deallocate(cacheblock, 48);
+    REQUIRE(ParserPool::Allocate(48) == parserblock);
+    ParserPool::Deallocate(parserblock, 48);
+}
+
+TEST_CASE("TaggedPoolAllocator: Test release drops the whole pool") {
+    using Pool = TaggedPoolAllocator<ReleaseTestTag>;
+    for (int i = 0; i < 5000; ++i) {
+        std::memset(Pool::Allocate(8 + static_cast<std::size_t>(i) % 120), 0,
+                    8);
+    }
+    void *aligned = Pool::Allocate(32, 32);
+    REQUIRE(aligned != nullptr);
+    const std::size_t footprint = Pool::Footprint();
+    REQUIRE(Pool::Release() == footprint);
+    REQUIRE(Pool::Footprint() == 0);
+    REQUIRE(Pool::Release() == 0);
+
+    // The released pool starts over.
+    void *ptr = Pool::Allocate(64);
+    REQUIRE(ptr != nullptr);
+    Pool::Deallocate(ptr, 64);
+    REQUIRE(Pool::Footprint() > 0);
+}
+
+TEST_CASE("TaggedPoolAllocator: Test tagged pool behind a wrapper") {
+    using Wrapper =
+        AllocatorWrapper<long, TaggedPoolAllocator<ParserTestTag>>;
+    long *values = Wrapper::Allocate(8);
+    for (int i = 0; i < 8; ++i) {
+        values[i] = i;
+    }
+    REQUIRE(values[7] == 7);
+    Wrapper::Deallocate(values, 8);
+}
+
+TEST_CASE("MemoryPoolAllocator: Test good size matches the size class") {
+    using LargeClassPool = BasicMemoryPoolAllocator<LargeClassPoolTraits>;
+    REQUIRE(MemoryPoolAllocator::GoodSize(0) == 0);
+    // Hardened pools and pools annotated for ASan wrap their blocks, so they
+    // report the requested size itself.
+    if constexpr (!DefaultPoolTraits::kHardened && !EASYSTL_ASAN_DEFAULT) {
+        REQUIRE(MemoryPoolAllocator::GoodSize(13) == 16);
+        REQUIRE(MemoryPoolAllocator::GoodSize(1001) == 1008);
+        REQUIRE(LargeClassPool::GoodSize(130) == 160);
+        REQUIRE(LargeClassPool::GoodSize(1100) == 1280);
+    }
+    // The wrapper turns bytes into whole elements.
+    REQUIRE(AllocatorWrapper<int, LargeClassPool>::GoodSize(33) >= 33);
+    REQUIRE(AllocatorWrapper<int, MallocAllocator>::GoodSize(33) == 33);
+
+    // Sizes that cannot be rounded up saturate instead of wrapping to 0, and
+    // counts too large for any object are refused.
+    using IntWrapper = AllocatorWrapper<int, MemoryPoolAllocator>;
+    constexpr std::size_t kMaxSize = static_cast<std::size_t>(-1);
+    REQUIRE(MemoryPoolAllocator::GoodSize(kMaxSize - 3) >= kMaxSize - 3);
+    REQUIRE_THROWS_AS(IntWrapper::GoodSize(kMaxSize / 4), std::bad_alloc);
 }
@@ -0,0 +1,116 @@
+#include <cstdint>
+#include <catch2/catch_test_macros.hpp>
+
+#include "arena_allocator.h"
+#include "vector.h"
+
+using namespace easystl;
+
+TEST_CASE("MonotonicArena: Test bump allocation") {
+    MonotonicArena arena;
+    REQUIRE(arena.Capacity() == 0);
+
+    void *ptr1 = arena.Allocate(10);
+    void *ptr2 = arena.Allocate(20);
+    REQUIRE(ptr1 != nullptr);
+    REQUIRE(ptr2 != nullptr);
+    REQUIRE(static_cast<char *>(ptr2) - static_cast<char *>(ptr1) ==
+            MonotonicArena::kAlign);
+    REQUIRE(reinterpret_cast<std::uintptr_t>(ptr2) % MonotonicArena::kAlign == 0);
+    REQUIRE(arena.Used() == 3 * MonotonicArena::kAlign);
+}
+
+TEST_CASE("MonotonicArena: Test deallocate rolls back the last block") {
+    MonotonicArena arena;
+    void *ptr1 = arena.Allocate(32);
+    void *ptr2 = arena.Allocate(32);
+
+    arena.Deallocate(ptr1, 32);
+    REQUIRE(arena.Used() == 64);
+    arena.Deallocate(ptr2, 32);
+    REQUIRE(arena.Used() == 32);
+    REQUIRE(arena.Allocate(32) == ptr2);
+}
+
+TEST_CASE("MonotonicArena: Test reallocate grows the last block in place") {
+    MonotonicArena arena;
+    auto *ptr = static_cast<int *>(arena.Allocate(4 * sizeof(int)));
+    for (int i = 0; i < 4; ++i) {
+        ptr[i] = i;
+    }
+    REQUIRE(arena.Reallocate(ptr, 4 * sizeof(int), 64 * sizeof(int)) == ptr);
+
+    arena.Allocate(8);
+    auto *moved = static_cast<int *>(
+        arena.Reallocate(ptr, 64 * sizeof(int), 128 * sizeof(int)));
+    REQUIRE(moved != ptr);
+    for (int i = 0; i < 4; ++i) {
+        REQUIRE(moved[i] == i);
+    }
+}
+
+TEST_CASE("MonotonicArena: Test chunk chaining and release") {
+    MonotonicArena arena;
+    for (int i = 0; i < 100; ++i) {
+        REQUIRE(arena.Allocate(1000) != nullptr);
+    }
+    const std::size_t capacity = arena.Capacity();
+    REQUIRE(capacity > MonotonicArena::kInitialSize);
+    REQUIRE(arena.Used() >= 100 * 1000);
+
+    void *big = arena.Allocate(1 << 20);
+    REQUIRE(big != nullptr);
+
+    arena.Release();
+    REQUIRE(arena.Used() == 0);
+    REQUIRE(arena.Capacity() < capacity + (1 << 20));
+    REQUIRE(arena.Allocate(1 << 19) == big);
+}
+
+TEST_CASE("ArenaAllocator: Test vector with arena storage") {
+    struct RequestTag {};
+    using Arena = ArenaAllocator<RequestTag>;
+
+    for (int request = 0; request < 3; ++request) {
+        {
+            vector<int, Arena> v;
+            for (int i = 0; i < 1000; ++i) {
+                v.push_back(i);
+            }
+            REQUIRE(v.size() == 1000);
+            REQUIRE(v[999] == 999);
+            REQUIRE(Arena::Arena().Used() >= 1000 * sizeof(int));
+        }
+        Arena::Release();
+        REQUIRE(Arena::Arena().Used() == 0);
+    }
+}
+
+TEST_CASE("MonotonicArena: Test aligned allocation") {
+    MonotonicArena arena;
+    arena.Allocate(8);
+    void *aligned = arena.Allocate(100, 256);
+    REQUIRE(reinterpret_cast<std::uintptr_t>(aligned) % 256 == 0);
+    // A request that only fits a fresh chunk once padded still gets one.
+    void *big = arena.Allocate(MonotonicArena::kInitialSize, 4096);
+    REQUIRE(reinterpret_cast<std::uintptr_t>(big) % 4096 == 0);
+    arena.Deallocate(big, MonotonicArena::kInitialSize, 4096);
+    REQUIRE(arena.Allocate(16, 4096) == big);
+}
+
+namespace {
+struct alignas(64) Padded {
+    int value;
+};
+} // namespace
+
+TEST_CASE("ArenaRef: Test vector of over-aligned elements") {
+    MonotonicArena arena;
+    arena.Allocate(16);
+    vector<Padded, ArenaRef> v{ArenaRef(arena)};
+    for (int i = 0; i < 100; ++i) {
+        v.push_back(Padded{i});
+        REQUIRE(reinterpret_cast<std::uintptr_t>(v.begin()) % 64 == 0);
+    }
+    REQUIRE(v[99].value == 99);
+}
@@ -0,0 +1,66 @@
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+
+#include "chunk_source.h"
+#include "memory_pool_allocator.h"
+
+using namespace easystl;
+
+TEST_CASE("MallocChunkSource: Test allocate and deallocate") {
+    std::size_t bytes = 1000;
+    void *chunk = MallocChunkSource::Allocate(bytes);
+    REQUIRE(chunk != nullptr);
+    REQUIRE(bytes == 1000);
+    std::memset(chunk, 0xab, bytes);
+    MallocChunkSource::Deallocate(chunk, bytes);
+}
+
+TEST_CASE("MmapChunkSource: Test page rounding") {
+    using Source = MmapChunkSource<false, true>;
+    std::size_t bytes = 1000;
+    auto *chunk = static_cast<char *>(Source::Allocate(bytes));
+    REQUIRE(chunk != nullptr);
+    REQUIRE(bytes >= 1000);
+    REQUIRE(bytes % 4096 == 0);
+    REQUIRE(chunk[0] == 0);
+    std::memset(chunk, 0xab, bytes);
+    Source::Deallocate(chunk, bytes);
+}
+
+TEST_CASE("MmapChunkSource: Test huge page alignment") {
+    using Source = MmapChunkSource<true, true>;
+    std::size_t bytes = Source::kHugePageSize + 1;
+    auto *chunk = static_cast<char *>(Source::Allocate(bytes));
+    REQUIRE(chunk != nullptr);
+    REQUIRE(bytes == 2 * Source::kHugePageSize);
+    REQUIRE(reinterpret_cast<std::uintptr_t>(chunk) % Source::kHugePageSize ==
+            0);
+    chunk[bytes - 1] = 1;
+    Source::Deallocate(chunk, bytes);
+}
+
+namespace {
+struct MmapPoolTestTraits : DefaultPoolTraits {
+    using ChunkSource = MmapChunkSource<true>;
+};
+} // namespace
+
+TEST_CASE("MemoryPoolAllocator: Test mmap chunk source") {
+    using Pool = BasicMemoryPoolAllocator<MmapPoolTestTraits>;
+    constexpr std::size_t size = 64;
+
+    std::vector<void *> ptrs(100000);
+    for (auto &ptr: ptrs) {
+        ptr = Pool::Allocate(size);
+        std::memset(ptr, 0xcd, size);
+    }
+    REQUIRE(Pool::Footprint() % MmapChunkSource<true>::kHugePageSize == 0);
+    REQUIRE(Pool::Footprint() >= ptrs.size() * size);
+    for (auto *ptr: ptrs) {
+        Pool::Deallocate(ptr, size);
+    }
+    Pool::Trim();
+    REQUIRE(Pool::Footprint() == 0);
+}
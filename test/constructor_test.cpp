@@ -13,6 +13,9 @@ struct TestObject {
     explicit TestObject(const int v) : value(v) {
     }
 
+    TestObject(const int a, const int b) : value(a * b) {
+    }
+
     ~TestObject() = default;
 };
 
@@ -33,6 +36,14 @@ TEST_CASE("Construct and Destroy") {
         operator delete(obj);
     }
 
+    SECTION("Variadic Construct") {
+        auto *obj = static_cast<TestObject *>(operator new(sizeof(TestObject)));
+        Construct(obj, 6, 7);
+        REQUIRE(obj->value == 42);
+        Destroy(obj);
+        operator delete(obj);
+    }
+
     SECTION("Array Construct and Destroy") {
         constexpr int size = 5;
         auto *arr = static_cast<TestObject *>(operator new[](size * sizeof(TestObject)));
@@ -0,0 +1,28 @@
+#include <cstddef>
+#include <limits>
+#include <catch2/catch_test_macros.hpp>
+
+#include "growth_policy.h"
+
+using namespace easystl;
+
+TEST_CASE("GrowthPolicy: Test geometric factors") {
+    STATIC_REQUIRE(DoublingGrowth::Grow(100, 101) == 200);
+    STATIC_REQUIRE(HalfGrowth::Grow(100, 101) == 150);
+    STATIC_REQUIRE(GeometricGrowth<5, 4>::Grow(100, 101) == 125);
+}
+
+TEST_CASE("GrowthPolicy: Test required size and minimum capacity") {
+    // Inserting more than the vector holds grows to fit all of it.
+    STATIC_REQUIRE(DoublingGrowth::Grow(100, 1000) == 1000);
+    STATIC_REQUIRE(HalfGrowth::Grow(2, 3) == 16);
+    STATIC_REQUIRE(GeometricGrowth<2, 1, 0>::Grow(0, 1) == 1);
+    STATIC_REQUIRE(GeometricGrowth<2, 1, 0>::Grow(1, 2) == 2);
+    STATIC_REQUIRE(CompactGrowth::Grow(0, 1) == 1);
+}
+
+TEST_CASE("GrowthPolicy: Test growth saturates instead of overflowing") {
+    constexpr std::size_t kMax = std::numeric_limits<std::size_t>::max();
+    STATIC_REQUIRE(DoublingGrowth::Grow(kMax / 2 + 1, kMax / 2 + 2) == kMax);
+    STATIC_REQUIRE(HalfGrowth::Grow(kMax - 1, kMax) == kMax);
+}
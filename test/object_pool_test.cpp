@@ -0,0 +1,178 @@
+#include <cstdint>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+
+#include "memory_pool_allocator.h"
+#include "object_pool.h"
+
+using namespace easystl;
+
+namespace {
+/**
+ * Counts constructions and destructions.
+ */
+struct Tracked {
+    static inline int constructed = 0;
+    static inline int destroyed = 0;
+
+    Tracked() : Tracked(0, "") {}
+    Tracked(const int newid, std::string newname)
+        : id(newid), name(std::move(newname)) {
+        ++constructed;
+    }
+    ~Tracked() { ++destroyed; }
+
+    int id;
+    std::string name;
+};
+
+/**
+ * Expensive to build; reused through Reset by KeepConstructed pools.
+ */
+struct Message {
+    static inline int constructed = 0;
+
+    Message() {
+        ++constructed;
+        payload.reserve(1024);
+    }
+    auto Reset(const int newid) -> void {
+        id = newid;
+        payload.clear();
+    }
+
+    int id = 0;
+    std::vector<char> payload;
+};
+
+struct Throwing {
+    explicit Throwing(const bool fail) {
+        if (fail) {
+            throw std::runtime_error("constructor failed");
+        }
+    }
+};
+
+struct alignas(64) Padded {
+    char bytes[8];
+};
+} // namespace
+
+TEST_CASE("ObjectPool: Test create constructs and recycle destroys") {
+    Tracked::constructed = Tracked::destroyed = 0;
+    {
+        ObjectPool<Tracked> pool;
+        Tracked *first = pool.Create(1, "first");
+        Tracked *second = pool.Create();
+        REQUIRE(first->id == 1);
+        REQUIRE(first->name == "first");
+        REQUIRE(second->id == 0);
+        REQUIRE(pool.Live() == 2);
+        REQUIRE(Tracked::constructed == 2);
+
+        pool.Recycle(first);
+        REQUIRE(Tracked::destroyed == 1);
+        REQUIRE(pool.Live() == 1);
+        REQUIRE(pool.Available() == 1);
+
+        // The recycled slot is reused first.
+        Tracked *third = pool.Create(3, "third");
+        REQUIRE(third == first);
+        REQUIRE(third->name == "third");
+        REQUIRE(pool.Available() == 0);
+        pool.Recycle(second);
+        pool.Recycle(third);
+        pool.Recycle(nullptr);
+        REQUIRE(pool.Live() == 0);
+    }
+    REQUIRE(Tracked::constructed == Tracked::destroyed);
+}
+
+TEST_CASE("ObjectPool: Test many objects span slabs") {
+    ObjectPool<Tracked, MemoryPoolAllocator> pool;
+    std::vector<Tracked *> objects;
+    std::set<Tracked *> distinct;
+    for (int i = 0; i < 10000; ++i) {
+        objects.push_back(pool.Create(i, "object"));
+        distinct.insert(objects.back());
+    }
+    REQUIRE(distinct.size() == objects.size());
+    int wrongids = 0;
+    for (int i = 0; i < 10000; ++i) {
+        if (objects[static_cast<std::size_t>(i)]->id != i) {
+            ++wrongids;
+        }
+    }
+    REQUIRE(wrongids == 0);
+    for (Tracked *object : objects) {
+        pool.Recycle(object);
+    }
+    REQUIRE(pool.Available() == 10000);
+}
+
+TEST_CASE("ObjectPool: Test kept objects skip construction") {
+    Message::constructed = 0;
+    ObjectPool<Message, MemoryPoolAllocator, KeepConstructed> pool;
+    Message *message = pool.Create(1);
+    message->payload.assign(100, 'x');
+    const char *buffer = message->payload.data();
+    pool.Recycle(message);
+
+    Message *again = pool.Create(2);
+    REQUIRE(again == message);
+    REQUIRE(again->id == 2);
+    REQUIRE(again->payload.empty());
+    // The buffer reserved by the constructor was kept.
+    REQUIRE(again->payload.data() == buffer);
+    REQUIRE(Message::constructed == 1);
+    pool.Recycle(again);
+}
+
+TEST_CASE("ObjectPool: Test kept objects are destroyed with the pool") {
+    Tracked::constructed = Tracked::destroyed = 0;
+    {
+        ObjectPool<Tracked, MemoryPoolAllocator, KeepConstructed> pool;
+        Tracked *first = pool.Create();
+        first->name = "kept";
+        pool.Recycle(first);
+        REQUIRE(Tracked::destroyed == 0);
+        // Without Reset a kept object comes back as it was left.
+        Tracked *again = pool.Create();
+        REQUIRE(again->name == "kept");
+        pool.Recycle(again);
+    }
+    REQUIRE(Tracked::constructed == 1);
+    REQUIRE(Tracked::destroyed == 1);
+}
+
+TEST_CASE("ObjectPool: Test throwing constructor leaves the pool unchanged") {
+    ObjectPool<Throwing> pool;
+    REQUIRE_THROWS_AS(pool.Create(true), std::runtime_error);
+    REQUIRE(pool.Live() == 0);
+    Throwing *object = pool.Create(false);
+    pool.Recycle(object);
+    REQUIRE_THROWS_AS(pool.Create(true), std::runtime_error);
+    REQUIRE(pool.Available() == 1);
+    REQUIRE(pool.Create(false) == object);
+    pool.Recycle(object);
+}
+
+TEST_CASE("ObjectPool: Test over-aligned objects") {
+    ObjectPool<Padded, MemoryPoolAllocator> pool;
+    std::vector<Padded *> objects;
+    int misaligned = 0;
+    for (int i = 0; i < 200; ++i) {
+        objects.push_back(pool.Create());
+        if (reinterpret_cast<std::uintptr_t>(objects.back()) % 64 != 0) {
+            ++misaligned;
+        }
+    }
+    REQUIRE(misaligned == 0);
+    for (Padded *object : objects) {
+        pool.Recycle(object);
+    }
+}
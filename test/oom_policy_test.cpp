@@ -0,0 +1,307 @@
+#include <chrono>
+#include <cstddef>
+#include <new>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+
+#include "allocator_wrapper.h"
+#include "arena_allocator.h"
+#include "malloc_allocator.h"
+#include "memory_pool_allocator.h"
+#include "oom_policy.h"
+#include "vector.h"
+
+using namespace easystl;
+
+namespace {
+constexpr std::size_t kHugeSize = static_cast<std::size_t>(-1) / 2;
+
+struct PressureTestTraits : DefaultPoolTraits {};
+struct ThreadCachedPressureTestTraits : ThreadCachedPoolTraits {};
+
+/**
+ * A chunk source that is always out of memory, going through MallocAllocator
+ * so the failure runs the pressure callbacks from inside the pool.
+ */
+struct ExhaustedChunkSource {
+    static auto Allocate(std::size_t /*size*/) -> void * {
+        return MallocAllocator::Allocate(kHugeSize);
+    }
+    static auto Deallocate(void *chunk, std::size_t size) -> void {
+        MallocAllocator::Deallocate(chunk, size);
+    }
+};
+struct ExhaustedTestTraits : DefaultPoolTraits {
+    using ChunkSource = ExhaustedChunkSource;
+};
+
+/**
+ * An allocator that never has memory.
+ */
+struct NullAllocator {
+    static auto Allocate(std::size_t /*size*/) -> void * { return nullptr; }
+    static auto Deallocate(void * /*obj*/, std::size_t /*size*/) -> void {}
+};
+
+/**
+ * Serves requests from MallocAllocator, asking it for a huge block instead
+ * once `exhausted` is set, so the OOM policy decides what happens.
+ */
+struct ExhaustibleAllocator {
+    static inline bool exhausted = false;
+
+    static auto Allocate(std::size_t size) -> void * {
+        return MallocAllocator::Allocate(exhausted ? kHugeSize : size);
+    }
+    static auto Deallocate(void *obj, std::size_t size) -> void {
+        MallocAllocator::Deallocate(obj, size);
+    }
+};
+
+/**
+ * Counts its calls and reports `released` bytes each time.
+ */
+struct Shedder {
+    static auto Shed(void *context, std::size_t /*bytes*/) -> std::size_t {
+        auto *self = static_cast<Shedder *>(context);
+        self->order.push_back(self->id);
+        ++self->calls;
+        return self->released;
+    }
+
+    int id = 0;
+    std::size_t released = 0;
+    std::vector<int> &order;
+    int calls = 0;
+};
+
+/**
+ * Sets an OOM policy while alive.
+ */
+struct PolicyScope {
+    explicit PolicyScope(const OomPolicy &policy)
+        : old(MallocAllocator::SetOomPolicy(policy)) {}
+    ~PolicyScope() { MallocAllocator::SetOomPolicy(old); }
+
+    OomPolicy old;
+};
+} // namespace
+
+TEST_CASE("MemoryPressure: Test callbacks run in registration order") {
+    std::vector<int> order;
+    Shedder first{1, 10, order};
+    Shedder second{2, 10, order};
+    const std::size_t firstid = MemoryPressure::Register(&Shedder::Shed, &first);
+    const std::size_t secondid =
+        MemoryPressure::Register(&Shedder::Shed, &second);
+    REQUIRE(firstid != 0);
+    REQUIRE(secondid != 0);
+    REQUIRE(MemoryPressure::Registered());
+
+    REQUIRE(MemoryPressure::Relieve(100) == 20);
+    REQUIRE(order == std::vector<int>{1, 2});
+
+    // The first callback releases enough, so the second one is spared.
+    order.clear();
+    REQUIRE(MemoryPressure::Relieve(5) == 10);
+    REQUIRE(order == std::vector<int>{1});
+
+    MemoryPressure::Unregister(firstid);
+    order.clear();
+    REQUIRE(MemoryPressure::Relieve(5) == 10);
+    REQUIRE(order == std::vector<int>{2});
+
+    MemoryPressure::Unregister(secondid);
+    REQUIRE_FALSE(MemoryPressure::Registered());
+    REQUIRE(MemoryPressure::Relieve(5) == 0);
+}
+
+TEST_CASE("MallocAllocator: Test OOM policy retries with pressure callbacks") {
+    std::vector<int> order;
+    Shedder shedder{1, 0, order};
+    const std::size_t id = MemoryPressure::Register(&Shedder::Shed, &shedder);
+
+    SECTION("Return null after the retries") {
+        PolicyScope scope({5, std::chrono::microseconds{0},
+                           OomAction::kReturnNull});
+        REQUIRE(MallocAllocator::Allocate(kHugeSize) == nullptr);
+        REQUIRE(shedder.calls == 5);
+    }
+    SECTION("Throw after the retries") {
+        PolicyScope scope({2, std::chrono::microseconds{0},
+                           OomAction::kThrow});
+        REQUIRE_THROWS_AS(MallocAllocator::Allocate(kHugeSize),
+                          std::bad_alloc);
+        REQUIRE(shedder.calls == 2);
+    }
+    SECTION("Back off between retries") {
+        PolicyScope scope({3, std::chrono::microseconds{1000},
+                           OomAction::kReturnNull});
+        const auto start = std::chrono::steady_clock::now();
+        REQUIRE(MallocAllocator::Allocate(kHugeSize) == nullptr);
+        // 1 ms, then 2 ms, then 4 ms.
+        REQUIRE(std::chrono::steady_clock::now() - start >=
+                std::chrono::milliseconds{7});
+        REQUIRE(shedder.calls == 3);
+    }
+
+    MemoryPressure::Unregister(id);
+}
+
+TEST_CASE("MemoryPressure: Test allocation failing inside a callback") {
+    struct Allocating {
+        static auto Shed(void *context, std::size_t /*bytes*/) -> std::size_t {
+            auto *calls = static_cast<int *>(context);
+            ++*calls;
+            // Fails as well; must neither rerun the callbacks nor deadlock.
+            REQUIRE(MallocAllocator::Allocate(kHugeSize) == nullptr);
+            return 0;
+        }
+    };
+    int calls = 0;
+    const std::size_t id = MemoryPressure::Register(&Allocating::Shed, &calls);
+    PolicyScope scope({2, std::chrono::microseconds{0},
+                       OomAction::kReturnNull});
+    REQUIRE(MallocAllocator::Allocate(kHugeSize) == nullptr);
+    REQUIRE(calls == 2);
+    MemoryPressure::Unregister(id);
+}
+
+TEST_CASE("MemoryPressure: Test callbacks run again after one threw") {
+    struct Throwing {
+        static auto Shed(void *context, std::size_t /*bytes*/) -> std::size_t {
+            auto *calls = static_cast<int *>(context);
+            if (++*calls == 1) {
+                throw std::bad_alloc();
+            }
+            return 1;
+        }
+    };
+    int calls = 0;
+    const std::size_t id = MemoryPressure::Register(&Throwing::Shed, &calls);
+    REQUIRE_THROWS_AS(MemoryPressure::Relieve(1), std::bad_alloc);
+    REQUIRE(MemoryPressure::Registered());
+    REQUIRE(MemoryPressure::Relieve(1) == 1);
+    REQUIRE(calls == 2);
+    MemoryPressure::Unregister(id);
+}
+
+TEST_CASE("MallocAllocator: Test OOM policy without anything to free") {
+    PolicyScope scope({3, std::chrono::microseconds{0}, OomAction::kThrow});
+    REQUIRE_THROWS_AS(MallocAllocator::Allocate(kHugeSize, 64),
+                      std::bad_alloc);
+}
+
+TEST_CASE("MallocAllocator: Test aligned size that cannot be rounded up") {
+    PolicyScope scope({1, std::chrono::microseconds{0},
+                       OomAction::kReturnNull});
+    REQUIRE(MallocAllocator::Allocate(static_cast<std::size_t>(-1), 64) ==
+            nullptr);
+}
+
+TEST_CASE("MemoryPoolAllocator: Test memory pressure trims the pool") {
+    using Pool = BasicMemoryPoolAllocator<PressureTestTraits>;
+    std::vector<void *> blocks;
+    for (int i = 0; i < 1000; ++i) {
+        blocks.push_back(Pool::Allocate(64));
+    }
+    for (void *ptr : blocks) {
+        Pool::Deallocate(ptr, 64);
+    }
+    const std::size_t before = Pool::Footprint();
+    REQUIRE(before > 0);
+
+    const std::size_t id = Pool::RegisterPressureTrim();
+    REQUIRE(id != 0);
+    REQUIRE(MallocAllocator::Allocate(kHugeSize) == nullptr);
+    REQUIRE(Pool::Footprint() < before);
+    MemoryPressure::Unregister(id);
+}
+
+TEST_CASE("ThreadCachedPoolAllocator: Test memory pressure trims the pool") {
+    using Pool = BasicMemoryPoolAllocator<ThreadCachedPressureTestTraits>;
+    std::vector<void *> blocks;
+    for (int i = 0; i < 1000; ++i) {
+        blocks.push_back(Pool::Allocate(64));
+    }
+    for (void *ptr : blocks) {
+        Pool::Deallocate(ptr, 64);
+    }
+    const std::size_t id = Pool::RegisterPressureTrim();
+    // The blocks sit in this thread's cache; shedding drains it first.
+    REQUIRE(MemoryPressure::Relieve(kHugeSize) > 0);
+    MemoryPressure::Unregister(id);
+}
+
+TEST_CASE("MemoryPoolAllocator: Test memory pressure during carving") {
+    using Pool = BasicMemoryPoolAllocator<ExhaustedTestTraits>;
+    const std::size_t id = Pool::RegisterPressureTrim();
+    // The pool's own chunk request fails; its trim callback must stay out.
+    REQUIRE(Pool::Allocate(32) == nullptr);
+    REQUIRE(Pool::Footprint() == 0);
+    MemoryPressure::Unregister(id);
+}
+
+TEST_CASE("AllocatorWrapper: Test failed allocation throws") {
+    using Wrapper = AllocatorWrapper<int, NullAllocator>;
+    REQUIRE(Wrapper::Allocate(0) == nullptr);
+    REQUIRE_THROWS_AS(Wrapper::Allocate(4), std::bad_alloc);
+}
+
+TEST_CASE("AllocatorWrapper: Test count whose size overflows throws") {
+    using Wrapper = AllocatorWrapper<int, MallocAllocator>;
+    // Never reaches malloc, so no OOM policy is involved.
+    REQUIRE_THROWS_AS(Wrapper::Allocate(static_cast<std::size_t>(-1)),
+                      std::bad_alloc);
+    int *ptr = Wrapper::Allocate(4);
+    REQUIRE_THROWS_AS(
+        Wrapper::Reallocate(ptr, 4, static_cast<std::size_t>(-1)),
+        std::bad_alloc);
+    ptr[3] = 3;
+    Wrapper::Deallocate(ptr, 4);
+}
+
+TEST_CASE("Vector: Test growth under a throwing OOM policy") {
+    PolicyScope scope({1, std::chrono::microseconds{0}, OomAction::kThrow});
+    vector<int, ExhaustibleAllocator> values;
+    for (int i = 0; i < 16; ++i) {
+        values.push_back(i);
+    }
+    REQUIRE(values.size() == values.capacity());
+
+    // The failed growth propagates and leaves the elements untouched.
+    ExhaustibleAllocator::exhausted = true;
+    REQUIRE_THROWS_AS(values.push_back(16), std::bad_alloc);
+    REQUIRE_THROWS_AS(values.reserve(1000), std::bad_alloc);
+    ExhaustibleAllocator::exhausted = false;
+    REQUIRE(values.size() == 16);
+    REQUIRE(values[15] == 15);
+    values.push_back(16);
+    REQUIRE(values[16] == 16);
+}
+
+TEST_CASE("Vector: Test copy assignment under a throwing OOM policy") {
+    PolicyScope scope({1, std::chrono::microseconds{0}, OomAction::kThrow});
+    vector<int, ExhaustibleAllocator> source(100, 7);
+    vector<int, ExhaustibleAllocator> values(4, 1);
+
+    // The copy needs more storage; the failure propagates instead of
+    // terminating and leaves the target untouched.
+    ExhaustibleAllocator::exhausted = true;
+    REQUIRE_THROWS_AS(values = source, std::bad_alloc);
+    ExhaustibleAllocator::exhausted = false;
+    REQUIRE(values.size() == 4);
+    REQUIRE(values[3] == 1);
+    values = source;
+    REQUIRE(values.size() == 100);
+    REQUIRE(values[99] == 7);
+}
+
+TEST_CASE("MonotonicArena: Test chunk allocation under a throwing OOM policy") {
+    PolicyScope scope({1, std::chrono::microseconds{0}, OomAction::kThrow});
+    MonotonicArena arena;
+    // Half the huge size, so the chunk header still fits in an object.
+    REQUIRE_THROWS_AS(arena.Allocate(kHugeSize / 2), std::bad_alloc);
+    REQUIRE(arena.Capacity() == 0);
+    REQUIRE(arena.Allocate(64) != nullptr);
+}
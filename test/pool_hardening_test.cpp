@@ -0,0 +1,196 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+
+#include "memory_pool_allocator.h"
+#include "pool_hardening.h"
+
+using namespace easystl;
+
+namespace {
+struct HardenedTestTraits : DefaultPoolTraits {
+    static constexpr bool kHardened = true;
+};
+struct CorruptLinkTestTraits : HardenedTestTraits {};
+struct ThreadCachedHardenedTestTraits : ThreadCachedPoolTraits {
+    static constexpr bool kHardened = true;
+};
+
+std::vector<std::string> reports;
+
+auto RecordReport(const char *what, const void * /*block*/) -> void {
+    reports.emplace_back(what);
+}
+
+/**
+ * Records the reports of hardened pools instead of aborting while alive.
+ */
+struct ReportRecorder {
+    ReportRecorder() : old(PoolHardening::SetCorruptionHandler(&RecordReport)) {
+        reports.clear();
+    }
+    ~ReportRecorder() { PoolHardening::SetCorruptionHandler(old); }
+
+    PoolHardening::CorruptionHandler old;
+};
+} // namespace
+
+TEST_CASE("PoolHardening: Test link encodings round trip") {
+    void *slot = nullptr;
+    int target = 0;
+    REQUIRE(PlainLink::Encode(&slot, &target) == &target);
+    void *stored = ObfuscatedLink::Encode(&slot, &target);
+    REQUIRE(stored != &target);
+    REQUIRE(ObfuscatedLink::Decode(&slot, stored) == &target);
+    REQUIRE(ObfuscatedLink::Decode(&slot, ObfuscatedLink::Encode(
+                                              &slot, nullptr)) == nullptr);
+}
+
+TEST_CASE("PoolHardening: Test correct use reports nothing") {
+    using Pool = BasicMemoryPoolAllocator<HardenedTestTraits>;
+    ReportRecorder recorder;
+    std::vector<std::pair<void *, std::size_t>> blocks;
+    for (int round = 0; round < 3; ++round) {
+        for (std::size_t size = 1; size <= 300; size += 13) {
+            void *ptr = Pool::Allocate(size);
+            std::memset(ptr, 0x11, size);
+            blocks.emplace_back(ptr, size);
+        }
+        for (auto [ptr, size] : blocks) {
+            Pool::Deallocate(ptr, size);
+        }
+        blocks.clear();
+    }
+    void *ptr = Pool::Allocate(40);
+    std::memset(ptr, 0x22, 40);
+    ptr = Pool::Reallocate(ptr, 40, 100);
+    REQUIRE(static_cast<unsigned char *>(ptr)[39] == 0x22);
+    Pool::Deallocate(ptr, 100);
+    void *aligned = Pool::Allocate(48, 64);
+    REQUIRE(reinterpret_cast<std::uintptr_t>(aligned) % 64 == 0);
+    std::memset(aligned, 0x33, 48);
+    Pool::Deallocate(aligned, 48, 64);
+    REQUIRE(reports.empty());
+}
+
+TEST_CASE("PoolHardening: Test zero-size blocks keep their free mark") {
+    using Pool = BasicMemoryPoolAllocator<HardenedTestTraits>;
+    ReportRecorder recorder;
+    // The free mark sits in the second word, so even a zero-size block must
+    // span two words rather than mark the canary of a neighbour still in use.
+    // Freeing in address order exposes that, as a refill carves neighbours.
+    std::vector<void *> blocks;
+    for (int i = 0; i < 64; ++i) {
+        blocks.push_back(Pool::Allocate(0));
+    }
+    void *other = Pool::Allocate(1);
+    std::sort(blocks.begin(), blocks.end(), std::less<void *>());
+    for (void *block : blocks) {
+        Pool::Deallocate(block, 0);
+    }
+    Pool::Deallocate(other, 1);
+    void *again = Pool::Allocate(0);
+    Pool::Deallocate(again, 0);
+    REQUIRE(reports.empty());
+    Pool::Deallocate(again, 0);
+    REQUIRE(reports.size() == 1);
+    REQUIRE(reports[0].find("freed twice") != std::string::npos);
+}
+
+TEST_CASE("PoolHardening: Test double free is detected and skipped") {
+    using Pool = BasicMemoryPoolAllocator<HardenedTestTraits>;
+    ReportRecorder recorder;
+    void *ptr = Pool::Allocate(32);
+    Pool::Deallocate(ptr, 32);
+    Pool::Deallocate(ptr, 32);
+    REQUIRE(reports.size() == 1);
+    REQUIRE(reports[0].find("freed twice") != std::string::npos);
+    // The second free was dropped, so the block is handed out only once.
+    void *first = Pool::Allocate(32);
+    void *second = Pool::Allocate(32);
+    REQUIRE(first != second);
+    Pool::Deallocate(first, 32);
+    Pool::Deallocate(second, 32);
+    REQUIRE(reports.size() == 1);
+}
+
+// Under ASan the pool poisons these bytes, so ASan reports the stray writes
+// of the next two tests before the pool's own checks can.
+#ifndef EASYSTL_ASAN
+TEST_CASE("PoolHardening: Test overflow is detected") {
+    using Pool = BasicMemoryPoolAllocator<HardenedTestTraits>;
+    ReportRecorder recorder;
+    auto *ptr = static_cast<char *>(Pool::Allocate(24));
+    ptr[24] = 0;
+    Pool::Deallocate(ptr, 24);
+    REQUIRE(reports.size() == 1);
+    REQUIRE(reports[0].find("overflow") != std::string::npos);
+}
+
+TEST_CASE("PoolHardening: Test write after free is detected") {
+    using Pool = BasicMemoryPoolAllocator<HardenedTestTraits>;
+    ReportRecorder recorder;
+    auto *ptr = static_cast<char *>(Pool::Allocate(64));
+    Pool::Deallocate(ptr, 64);
+    ptr[40] = 1;
+    REQUIRE(Pool::Allocate(64) == ptr);
+    REQUIRE(reports.size() == 1);
+    REQUIRE(reports[0].find("after free") != std::string::npos);
+    Pool::Deallocate(ptr, 64);
+}
+#endif
+
+TEST_CASE("PoolHardening: Test corrupted free-list link is detected") {
+    using Pool = BasicMemoryPoolAllocator<CorruptLinkTestTraits>;
+    ReportRecorder recorder;
+    void *ptr = Pool::Allocate(16);
+    Pool::Deallocate(ptr, 16);
+    // A stray write stores a misaligned pointer in the link word.
+    void **slot = static_cast<void **>(ptr);
+    *slot = ObfuscatedLink::Encode(slot, reinterpret_cast<void *>(0x1003));
+    REQUIRE(Pool::Allocate(16) == ptr);
+    REQUIRE(reports.size() == 1);
+    REQUIRE(reports[0].find("link") != std::string::npos);
+    // The pool of these traits is left corrupted on purpose; do not reuse it.
+}
+
+TEST_CASE("PoolHardening: Test thread-cached hardened pool") {
+    using Pool = BasicMemoryPoolAllocator<ThreadCachedHardenedTestTraits>;
+    ReportRecorder recorder;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([] {
+            std::vector<void *> blocks;
+            for (int i = 0; i < 1000; ++i) {
+                const std::size_t size = 8 + static_cast<std::size_t>(i % 64);
+                void *ptr = Pool::Allocate(size);
+                std::memset(ptr, 0x44, size);
+                blocks.push_back(ptr);
+            }
+            for (int i = 0; i < 1000; ++i) {
+                Pool::Deallocate(blocks[static_cast<std::size_t>(i)],
+                                 8 + static_cast<std::size_t>(i % 64));
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    REQUIRE(reports.empty());
+}
+
+#ifdef EASYSTL_ASAN
+TEST_CASE("PoolHardening: Test freed blocks are poisoned for ASan") {
+    using Pool = BasicMemoryPoolAllocator<HardenedTestTraits>;
+    auto *ptr = static_cast<char *>(Pool::Allocate(20));
+    REQUIRE(__asan_address_is_poisoned(ptr + 19) == 0);
+    REQUIRE(__asan_address_is_poisoned(ptr + 20) != 0);
+    Pool::Deallocate(ptr, 20);
+    REQUIRE(__asan_address_is_poisoned(ptr + sizeof(void *)) != 0);
+}
+#endif
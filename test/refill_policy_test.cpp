@@ -0,0 +1,74 @@
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+
+#include "memory_pool_allocator.h"
+#include "refill_policy.h"
+
+using namespace easystl;
+
+TEST_CASE("FixedRefill: Test constant batch") {
+    using Policy = FixedRefill<20>;
+    Policy::State state;
+    REQUIRE(Policy::Next(state, 8) == 20);
+    Policy::Idle(state);
+    REQUIRE(Policy::Next(state, 128) == 20);
+}
+
+TEST_CASE("AdaptiveRefill: Test slow start and idle shrinking") {
+    using Policy = AdaptiveRefill<4, 64, 4096>;
+    Policy::State state;
+    REQUIRE(Policy::Next(state, 8) == 4);
+    REQUIRE(Policy::Next(state, 8) == 8);
+    REQUIRE(Policy::Next(state, 8) == 16);
+    REQUIRE(Policy::Next(state, 8) == 32);
+    REQUIRE(Policy::Next(state, 8) == 64);
+    REQUIRE(Policy::Next(state, 8) == 64);
+
+    Policy::Idle(state);
+    REQUIRE(Policy::Next(state, 8) == 32);
+    for (int i = 0; i < 10; ++i) {
+        Policy::Idle(state);
+    }
+    REQUIRE(Policy::Next(state, 8) == 4);
+}
+
+TEST_CASE("AdaptiveRefill: Test byte cap") {
+    using Policy = AdaptiveRefill<4, 512, 4096>;
+    Policy::State state;
+    for (int i = 0; i < 10; ++i) {
+        REQUIRE(Policy::Next(state, 1024) <= 4);
+    }
+    REQUIRE(Policy::Next(state, 8192) == 1);
+}
+
+namespace {
+struct FixedRefillTestTraits : DefaultPoolTraits {
+    static constexpr bool kStats = true;
+};
+struct AdaptiveRefillTestTraits : DefaultPoolTraits {
+    static constexpr bool kStats = true;
+    using RefillPolicy = AdaptiveRefill<>;
+};
+} // namespace
+
+template <class Pool> auto CountRefills(const std::size_t size) -> std::size_t {
+    std::vector<void *> ptrs(10000);
+    for (auto &ptr: ptrs) {
+        ptr = Pool::Allocate(size);
+    }
+    for (auto *ptr: ptrs) {
+        Pool::Deallocate(ptr, size);
+    }
+    return Pool::Stats().classes[DefaultPoolTraits::SizeClasses::Index(size)]
+        .refills;
+}
+
+TEST_CASE("MemoryPoolAllocator: Test adaptive refill") {
+    using FixedPool = BasicMemoryPoolAllocator<FixedRefillTestTraits>;
+    using AdaptivePool = BasicMemoryPoolAllocator<AdaptiveRefillTestTraits>;
+
+    const std::size_t fixed = CountRefills<FixedPool>(16);
+    const std::size_t adaptive = CountRefills<AdaptivePool>(16);
+    REQUIRE(fixed >= 10000 / 20);
+    REQUIRE(adaptive < fixed / 10);
+}
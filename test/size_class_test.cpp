@@ -0,0 +1,48 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "size_class.h"
+
+using namespace easystl;
+
+TEST_CASE("LinearSizeClasses: Test index and size") {
+    using Classes = LinearSizeClasses<8, 128>;
+
+    STATIC_REQUIRE(Classes::kNum == 16);
+    STATIC_REQUIRE(Classes::kMaxBytes == 128);
+    REQUIRE(Classes::Index(1) == 0);
+    REQUIRE(Classes::Index(8) == 0);
+    REQUIRE(Classes::Index(9) == 1);
+    REQUIRE(Classes::Index(128) == 15);
+    REQUIRE(Classes::Size(0) == 8);
+    REQUIRE(Classes::Size(15) == 128);
+}
+
+TEST_CASE("GeometricSizeClasses: Test class layout") {
+    using Classes = GeometricSizeClasses<32768>;
+
+    STATIC_REQUIRE(Classes::kNum == 48);
+    REQUIRE(Classes::Size(0) == 8);
+    REQUIRE(Classes::Size(15) == 128);
+    REQUIRE(Classes::Size(16) == 160);
+    REQUIRE(Classes::Size(19) == 256);
+    REQUIRE(Classes::Size(Classes::kNum - 1) == 32768);
+    for (std::size_t i = 1; i < Classes::kNum; ++i) {
+        REQUIRE(Classes::Size(i) > Classes::Size(i - 1));
+        REQUIRE(Classes::Size(i) % 8 == 0);
+    }
+}
+
+TEST_CASE("GeometricSizeClasses: Test lookup picks the smallest fitting class") {
+    using Classes = GeometricSizeClasses<32768>;
+
+    STATIC_REQUIRE(Classes::Index(129) == 16);
+    std::size_t mismatches = 0;
+    for (std::size_t bytes = 1; bytes <= Classes::kMaxBytes; ++bytes) {
+        const std::size_t index = Classes::Index(bytes);
+        if (Classes::Size(index) < bytes ||
+            (index > 0 && Classes::Size(index - 1) >= bytes)) {
+            ++mismatches;
+        }
+    }
+    REQUIRE(mismatches == 0);
+}
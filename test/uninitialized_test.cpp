@@ -1,3 +1,6 @@
+#include <memory>
+#include <string>
+#include <type_traits>
 #include <catch2/catch_test_macros.hpp>
 
 #include "uninitialized.h"
@@ -16,6 +19,26 @@ struct TestObject {
     ~TestObject() = default;
 };
 
+// Owns a heap int; declared trivially relocatable.
+struct RelocatableBox {
+    static constexpr bool kTriviallyRelocatable = true;
+
+    explicit RelocatableBox(const int v) : value(new int(v)) {
+    }
+
+    RelocatableBox(RelocatableBox &&other) noexcept : value(other.value) {
+        other.value = nullptr;
+    }
+
+    ~RelocatableBox() { delete value; }
+
+    int *value;
+};
+
+namespace easystl {
+template <> struct IsTriviallyRelocatable<std::unique_ptr<int>> : std::true_type {};
+} // namespace easystl
+
 TEST_CASE("Uninitialized Functions") {
     SECTION("Uninitialized Copy") {
         constexpr int size = 5;
@@ -62,6 +85,53 @@ TEST_CASE("Uninitialized Functions") {
         operator delete[](dest);
     }
 
+    SECTION("Uninitialized Move") {
+        constexpr int size = 3;
+        std::string source[size] = {std::string(50, 'a'), std::string(50, 'b'), std::string(50, 'c')};
+
+        auto *dest = static_cast<std::string *>(operator new[](size * sizeof(std::string)));
+
+        auto end = easystl::uninitialized_move(source, source + size, dest);
+
+        REQUIRE(end == dest + size);
+        for (int i = 0; i < size; ++i) {
+            REQUIRE(dest[i] == std::string(50, static_cast<char>('a' + i)));
+            REQUIRE(source[i].empty());
+        }
+
+        Destroy(dest, dest + size);
+        operator delete[](dest);
+    }
+
+    SECTION("Uninitialized Relocate") {
+        constexpr int size = 4;
+        auto *boxes = static_cast<RelocatableBox *>(operator new[]((size + 1) * sizeof(RelocatableBox)));
+        for (int i = 0; i < size; ++i) {
+            Construct(boxes + i, i);
+        }
+
+        // Shifting up by one overlaps; the boxes are moved without being destroyed.
+        auto end = uninitialized_relocate(boxes, boxes + size, boxes + 1);
+
+        REQUIRE(end == boxes + size + 1);
+        for (int i = 0; i < size; ++i) {
+            REQUIRE(*boxes[i + 1].value == i);
+        }
+
+        std::string source[2] = {std::string(50, 'a'), std::string(50, 'b')};
+        auto *dest = static_cast<std::string *>(operator new[](2 * sizeof(std::string)));
+        uninitialized_relocate(source, source + 2, dest);
+        REQUIRE(dest[1] == std::string(50, 'b'));
+        // The sources were destroyed; give them back a lifetime for their destructors.
+        Construct(source);
+        Construct(source + 1);
+
+        Destroy(dest, dest + 2);
+        operator delete[](dest);
+        Destroy(boxes + 1, boxes + size + 1);
+        operator delete[](boxes);
+    }
+
     // SECTION("Exception Handling in Uninitialized Copy") {
     //     struct FaultyObject {
     //         FaultyObject() { throw std::runtime_error("Construction failed"); }
@@ -79,3 +149,12 @@ TEST_CASE("Uninitialized Functions") {
     //     operator delete[](dest);
     // }
 }
+
+TEST_CASE("Trivially relocatable types") {
+    STATIC_REQUIRE(IsTriviallyRelocatable<int>::value);
+    STATIC_REQUIRE(IsTriviallyRelocatable<TestObject>::value);
+    STATIC_REQUIRE(IsTriviallyRelocatable<RelocatableBox>::value);
+    STATIC_REQUIRE(IsTriviallyRelocatable<std::unique_ptr<int>>::value);
+    STATIC_REQUIRE(!IsTriviallyRelocatable<std::string>::value);
+    STATIC_REQUIRE(!IsTriviallyRelocatable<std::unique_ptr<long>>::value);
+}
@@ -1,5 +1,12 @@
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string>
+#include <utility>
 #include <catch2/catch_test_macros.hpp>
 
+#include "arena_allocator.h"
+#include "memory_pool_allocator.h"
 #include "vector.h"
 
 using namespace easystl;
@@ -87,3 +94,562 @@ TEST_CASE("Vector clear") {
   REQUIRE(v.size() == 0);
   REQUIRE(v.empty());
 }
+
+TEST_CASE("Vector stateless allocator takes no space") {
+  REQUIRE(sizeof(vector<int>) == 3 * sizeof(int *));
+  REQUIRE(sizeof(vector<int, MallocAllocator>) == 3 * sizeof(int *));
+}
+
+TEST_CASE("Vector with a stateful allocator") {
+  MonotonicArena arena1;
+  MonotonicArena arena2;
+  using ArenaVector = vector<int, ArenaRef>;
+
+  ArenaVector v1(3, 1, ArenaRef(arena1));
+  REQUIRE(v1.get_allocator() == ArenaRef(arena1));
+  REQUIRE(arena1.Used() >= 3 * sizeof(int));
+  REQUIRE(arena2.Used() == 0);
+
+  // Copy construction copies the allocator.
+  ArenaVector v2(v1);
+  REQUIRE(v2.get_allocator() == ArenaRef(arena1));
+
+  // Copy assignment keeps the allocator of the target.
+  ArenaVector v3(ArenaRef{arena2});
+  v3 = v1;
+  REQUIRE(v3.get_allocator() == ArenaRef(arena2));
+  REQUIRE(v3.size() == 3);
+  REQUIRE(v3[2] == 1);
+
+  // Move construction and move assignment take the allocator along.
+  ArenaVector v4(static_cast<ArenaVector &&>(v3));
+  REQUIRE(v4.get_allocator() == ArenaRef(arena2));
+  REQUIRE(v4.size() == 3);
+  REQUIRE(v3.empty());
+  v2 = static_cast<ArenaVector &&>(v4);
+  REQUIRE(v2.get_allocator() == ArenaRef(arena2));
+  REQUIRE(v2.size() == 3);
+
+  // Swap exchanges the allocators together with the storage.
+  ArenaVector v5(5, 2, ArenaRef(arena1));
+  v5.swap(v2);
+  REQUIRE(v5.get_allocator() == ArenaRef(arena2));
+  REQUIRE(v5.size() == 3);
+  REQUIRE(v2.get_allocator() == ArenaRef(arena1));
+  REQUIRE(v2.size() == 5);
+}
+
+namespace {
+// An arena reference that stays with its container.
+struct PinnedArenaRef : ArenaRef {
+  static constexpr bool kPropagateOnMoveAssign = false;
+  static constexpr bool kPropagateOnSwap = false;
+  using ArenaRef::ArenaRef;
+};
+} // namespace
+
+TEST_CASE("Vector with a non-propagating allocator") {
+  MonotonicArena arena1;
+  MonotonicArena arena2;
+  using PinnedVector = vector<int, PinnedArenaRef>;
+
+  PinnedVector v1(3, 1, PinnedArenaRef(arena1));
+  PinnedVector v2(5, 2, PinnedArenaRef(arena2));
+  // Unequal pinned allocators make swap copy, so it may throw.
+  STATIC_REQUIRE_FALSE(noexcept(v1.swap(v2)));
+  STATIC_REQUIRE(noexcept(vector<int>().swap(std::declval<vector<int> &>())));
+  STATIC_REQUIRE(noexcept(
+      vector<int, ArenaRef>().swap(std::declval<vector<int, ArenaRef> &>())));
+  v1.swap(v2);
+  REQUIRE(v1.get_allocator() == PinnedArenaRef(arena1));
+  REQUIRE(v1.size() == 5);
+  REQUIRE(v1[4] == 2);
+  REQUIRE(v2.get_allocator() == PinnedArenaRef(arena2));
+  REQUIRE(v2.size() == 3);
+  REQUIRE(v2[2] == 1);
+
+  v1 = static_cast<PinnedVector &&>(v2);
+  REQUIRE(v1.get_allocator() == PinnedArenaRef(arena1));
+  REQUIRE(v1.size() == 3);
+  REQUIRE(v1[0] == 1);
+}
+
+TEST_CASE("Vector growth of trivially copyable elements") {
+  vector<int> v;
+  for (int i = 0; i < 10000; ++i) {
+    v.push_back(i);
+  }
+  REQUIRE(v.size() == 10000);
+  int mismatches = 0;
+  for (int i = 0; i < 10000; ++i) {
+    if (v[static_cast<std::size_t>(i)] != i) {
+      ++mismatches;
+    }
+  }
+  REQUIRE(mismatches == 0);
+
+  // Pushing an element of the vector itself while it grows.
+  vector<int> w(16, 7);
+  REQUIRE(w.size() == w.capacity());
+  w.push_back(w[0]);
+  REQUIRE(w.size() == 17);
+  REQUIRE(w[16] == 7);
+}
+
+namespace {
+struct alignas(64) CacheLine {
+  int value;
+};
+} // namespace
+
+TEST_CASE("Vector of over-aligned elements") {
+  vector<CacheLine> v;
+  int misaligned = 0;
+  for (int i = 0; i < 1000; ++i) {
+    v.push_back(CacheLine{i});
+    if (reinterpret_cast<std::uintptr_t>(&v[0]) % 64 != 0) {
+      ++misaligned;
+    }
+  }
+  REQUIRE(misaligned == 0);
+  int mismatches = 0;
+  for (int i = 0; i < 1000; ++i) {
+    if (v[static_cast<std::size_t>(i)].value != i) {
+      ++mismatches;
+    }
+  }
+  REQUIRE(mismatches == 0);
+}
+
+namespace {
+// Counts how its instances were made; `kNoexcept` selects whether moving may
+// throw, which decides whether growth moves or copies.
+template <bool kNoexcept> struct Counted {
+  static inline int copies = 0;
+  static inline int moves = 0;
+
+  explicit Counted(const int newvalue = 0) : value(newvalue) {}
+  Counted(const Counted &other) : value(other.value) { ++copies; }
+  Counted(Counted &&other) noexcept(kNoexcept) : value(other.value) {
+    other.value = -1;
+    ++moves;
+  }
+  auto operator=(const Counted &other) -> Counted & {
+    value = other.value;
+    ++copies;
+    return *this;
+  }
+  auto operator=(Counted &&other) noexcept(kNoexcept) -> Counted & {
+    value = other.value;
+    other.value = -1;
+    ++moves;
+    return *this;
+  }
+
+  int value;
+};
+using NothrowMovable = Counted<true>;
+using ThrowingMovable = Counted<false>;
+} // namespace
+
+TEST_CASE("Vector push_back of rvalues moves") {
+  vector<std::string> v;
+  std::string text(100, 'x');
+  v.push_back(std::move(text));
+  REQUIRE(v[0] == std::string(100, 'x'));
+  REQUIRE(text.empty());
+
+  NothrowMovable::copies = NothrowMovable::moves = 0;
+  vector<NothrowMovable> w;
+  for (int i = 0; i < 100; ++i) {
+    w.push_back(NothrowMovable(i));
+  }
+  REQUIRE(NothrowMovable::copies == 0);
+  REQUIRE(w[99].value == 99);
+}
+
+TEST_CASE("Vector growth moves only when moving cannot throw") {
+  NothrowMovable::copies = NothrowMovable::moves = 0;
+  vector<NothrowMovable> moved(16, NothrowMovable(1));
+  NothrowMovable::copies = 0;
+  moved.push_back(NothrowMovable(2));
+  REQUIRE(NothrowMovable::copies == 0);
+  REQUIRE(NothrowMovable::moves == 17);
+
+  ThrowingMovable::copies = ThrowingMovable::moves = 0;
+  vector<ThrowingMovable> copied(16, ThrowingMovable(1));
+  ThrowingMovable::copies = 0;
+  copied.push_back(ThrowingMovable(2));
+  REQUIRE(ThrowingMovable::copies == 16);
+  REQUIRE(ThrowingMovable::moves == 1);
+  REQUIRE(copied[0].value == 1);
+  REQUIRE(copied[16].value == 2);
+}
+
+TEST_CASE("Vector insert of rvalues moves") {
+  vector<std::string> v;
+  for (int i = 0; i < 20; ++i) {
+    v.push_back(std::to_string(i));
+  }
+  // Through reallocation and within capacity.
+  auto it = v.insert(v.begin() + 5, std::string("five"));
+  REQUIRE(*it == "five");
+  it = v.insert(v.begin(), std::string("front"));
+  REQUIRE(it == v.begin());
+  it = v.insert(v.end(), std::string("back"));
+  REQUIRE(v.size() == 23);
+  REQUIRE(v[0] == "front");
+  REQUIRE(v[1] == "0");
+  REQUIRE(v[6] == "five");
+  REQUIRE(v[7] == "5");
+  REQUIRE(v[21] == "19");
+  REQUIRE(*it == "back");
+
+  // Inserting copies of an element of the vector itself.
+  v.insert(v.begin(), 2, v[1]);
+  REQUIRE(v[0] == "0");
+  REQUIRE(v[1] == "0");
+  REQUIRE(v[2] == "front");
+
+  v.erase(v.begin(), v.begin() + 3);
+  REQUIRE(v[0] == "0");
+  REQUIRE(v.size() == 22);
+}
+
+TEST_CASE("Vector move between unequal allocators moves the elements") {
+  MonotonicArena arena1;
+  MonotonicArena arena2;
+  using PinnedVector = vector<NothrowMovable, PinnedArenaRef>;
+
+  PinnedVector v1(PinnedArenaRef{arena1});
+  for (int i = 0; i < 4; ++i) {
+    v1.push_back(NothrowMovable(i));
+  }
+  NothrowMovable::copies = 0;
+  PinnedVector v2(std::move(v1), PinnedArenaRef(arena2));
+  REQUIRE(v2.get_allocator() == PinnedArenaRef(arena2));
+  REQUIRE(v2.size() == 4);
+  REQUIRE(v2[3].value == 3);
+  REQUIRE(v1.empty());
+
+  PinnedVector v3(PinnedArenaRef{arena1});
+  v3 = std::move(v2);
+  REQUIRE(v3.get_allocator() == PinnedArenaRef(arena1));
+  REQUIRE(v3.size() == 4);
+  REQUIRE(v3[0].value == 0);
+  REQUIRE(NothrowMovable::copies == 0);
+}
+
+namespace {
+// A record that is expensive to copy and counts every copy and move.
+struct Record {
+  static inline int copies = 0;
+  static inline int moves = 0;
+
+  Record(const int newid, std::string newname, const double newscore)
+      : id(newid), name(std::move(newname)), score(newscore) {}
+  Record(const Record &other)
+      : id(other.id), name(other.name), score(other.score) {
+    ++copies;
+  }
+  Record(Record &&other) noexcept
+      : id(other.id), name(std::move(other.name)), score(other.score) {
+    ++moves;
+  }
+  auto operator=(const Record &other) -> Record & {
+    id = other.id;
+    name = other.name;
+    score = other.score;
+    ++copies;
+    return *this;
+  }
+  auto operator=(Record &&other) noexcept -> Record & {
+    id = other.id;
+    name = std::move(other.name);
+    score = other.score;
+    ++moves;
+    return *this;
+  }
+
+  int id;
+  std::string name;
+  double score;
+};
+} // namespace
+
+TEST_CASE("Vector emplace_back constructs in place") {
+  Record::copies = Record::moves = 0;
+  vector<Record> v;
+  Record &first = v.emplace_back(1, "first", 0.5);
+  REQUIRE(&first == &v[0]);
+  REQUIRE(first.name == "first");
+  for (int i = 2; i <= 16; ++i) {
+    v.emplace_back(i, "record", 1.0);
+  }
+  REQUIRE(Record::copies == 0);
+  REQUIRE(Record::moves == 0);
+
+  // Growing moves the existing records but still builds the new one in place.
+  v.emplace_back(17, "grown", 2.0);
+  REQUIRE(Record::copies == 0);
+  REQUIRE(Record::moves == 16);
+  REQUIRE(v.size() == 17);
+  REQUIRE(v[16].name == "grown");
+  REQUIRE(v[0].id == 1);
+
+  vector<int> ints;
+  ints.emplace_back();
+  ints.emplace_back(5);
+  REQUIRE(ints[0] == 0);
+  REQUIRE(ints[1] == 5);
+}
+
+TEST_CASE("Vector emplace constructs at a position") {
+  vector<Record> v;
+  for (int i = 0; i < 4; ++i) {
+    v.emplace_back(i, std::to_string(i), 0.0);
+  }
+  Record::copies = 0;
+  auto it = v.emplace(v.begin() + 1, 10, "ten", 1.0);
+  REQUIRE(it == v.begin() + 1);
+  REQUIRE(it->name == "ten");
+  it = v.emplace(v.end(), 20, "twenty", 2.0);
+  REQUIRE(it->id == 20);
+  REQUIRE(Record::copies == 0);
+  REQUIRE(v.size() == 6);
+  REQUIRE(v[0].id == 0);
+  REQUIRE(v[2].id == 1);
+  REQUIRE(v[4].id == 3);
+
+  // Arguments referring to an element that gets shifted.
+  v.emplace(v.begin(), v[1]);
+  REQUIRE(v[0].name == "ten");
+  REQUIRE(v[2].name == "ten");
+  REQUIRE(Record::copies == 1);
+}
+
+TEST_CASE("Vector range insert larger than the vector") {
+  vector<int> v(3, 1);
+  vector<int> many(100, 2);
+  v.insert(v.begin() + 1, many.begin(), many.end());
+  REQUIRE(v.size() == 103);
+  REQUIRE(v.capacity() >= 103);
+  REQUIRE(v[0] == 1);
+  REQUIRE(v[1] == 2);
+  REQUIRE(v[100] == 2);
+  REQUIRE(v[101] == 1);
+
+  vector<std::string> strings(2, "a");
+  strings.insert(strings.end(), 50, std::string("b"));
+  REQUIRE(strings.size() == 52);
+  REQUIRE(strings[51] == "b");
+}
+
+TEST_CASE("Vector growth follows the growth policy") {
+  vector<int, MemoryPoolAllocator, GeometricGrowth<3, 2, 16, false>> half;
+  vector<int, MemoryPoolAllocator, GeometricGrowth<2, 1, 16, false>> doubled;
+  for (int i = 0; i < 17; ++i) {
+    half.push_back(i);
+    doubled.push_back(i);
+  }
+  REQUIRE(half.capacity() == 24);
+  REQUIRE(doubled.capacity() == 32);
+  for (int i = 17; i < 1000; ++i) {
+    half.push_back(i);
+  }
+  REQUIRE(half.size() == 1000);
+  REQUIRE(half[999] == 999);
+}
+
+TEST_CASE("Vector capacity is rounded to the allocator's size class") {
+  using LargeClassPool = BasicMemoryPoolAllocator<LargeClassPoolTraits>;
+  vector<int, LargeClassPool, HalfGrowth> v;
+  // 17 ints grow to 24, 96 bytes, which is a size class of its own.
+  for (int i = 0; i < 17; ++i) {
+    v.push_back(i);
+  }
+  REQUIRE(v.capacity() == 24);
+  // 25 ints grow to 36, 144 bytes, served from the 160-byte class: 40 ints.
+  for (int i = 17; i < 25; ++i) {
+    v.push_back(i);
+  }
+  REQUIRE(v.capacity() == LargeClassPool::GoodSize(36 * sizeof(int)) / 4);
+  for (int i = 25; i < 1000; ++i) {
+    v.push_back(i);
+  }
+  REQUIRE(v.capacity() * sizeof(int) ==
+          LargeClassPool::GoodSize(v.capacity() * sizeof(int)));
+  REQUIRE(v[999] == 999);
+
+  vector<int, LargeClassPool, GeometricGrowth<3, 2, 16, false>> unrounded;
+  for (int i = 0; i < 25; ++i) {
+    unrounded.push_back(i);
+  }
+  REQUIRE(unrounded.capacity() == 36);
+}
+
+TEST_CASE("Vector construction allocates exactly the elements") {
+  vector<long long, MallocAllocator> three(3, 1);
+  REQUIRE(three.capacity() == 3);
+  vector<long long, MallocAllocator> none(0, 1);
+  REQUIRE(none.capacity() == 0);
+  REQUIRE(none.data() == nullptr);
+  vector<long long, MallocAllocator> copy(three);
+  REQUIRE(copy.capacity() == 3);
+  // Rounding to the size class keeps the slack of the block: 3 ints use 16
+  // bytes, so a pool vector gets room for 4.
+  vector<int> rounded(3, 1);
+  REQUIRE(rounded.capacity() ==
+          MemoryPoolAllocator::GoodSize(3 * sizeof(int)) / sizeof(int));
+}
+
+TEST_CASE("Vector reserve") {
+  vector<std::string> v;
+  v.reserve(100);
+  REQUIRE(v.capacity() >= 100);
+  REQUIRE(v.empty());
+  const std::string *storage = v.data();
+  for (int i = 0; i < 100; ++i) {
+    v.push_back(std::to_string(i));
+  }
+  REQUIRE(v.data() == storage);
+
+  // Reserving less than the capacity changes nothing.
+  v.reserve(10);
+  REQUIRE(v.data() == storage);
+  v.reserve(1000);
+  REQUIRE(v.capacity() >= 1000);
+  REQUIRE(v.size() == 100);
+  REQUIRE(v[99] == "99");
+
+  vector<int> ints(5, 3);
+  ints.reserve(1000);
+  REQUIRE(ints.capacity() >= 1000);
+  REQUIRE(ints[4] == 3);
+
+  // A count no allocation can hold throws and leaves the vector alone.
+  const std::size_t capacity = ints.capacity();
+  REQUIRE_THROWS_AS(ints.reserve(static_cast<std::size_t>(-1) / 4),
+                    std::bad_alloc);
+  REQUIRE(ints.capacity() == capacity);
+  REQUIRE(ints[4] == 3);
+}
+
+TEST_CASE("Vector shrink_to_fit") {
+  vector<std::string, MallocAllocator> v;
+  for (int i = 0; i < 20; ++i) {
+    v.push_back(std::to_string(i));
+  }
+  REQUIRE(v.capacity() > 20);
+  v.shrink_to_fit();
+  REQUIRE(v.capacity() == 20);
+  REQUIRE(v[19] == "19");
+
+  vector<int> ints;
+  for (int i = 0; i < 100; ++i) {
+    ints.push_back(i);
+  }
+  ints.erase(ints.begin() + 10, ints.end());
+  ints.shrink_to_fit();
+  REQUIRE(ints.capacity() < 16);
+  REQUIRE(ints[9] == 9);
+
+  ints.clear();
+  ints.shrink_to_fit();
+  REQUIRE(ints.capacity() == 0);
+  REQUIRE(ints.data() == nullptr);
+}
+
+TEST_CASE("Vector without a minimum capacity") {
+  vector<long long, MallocAllocator, CompactGrowth> v;
+  v.push_back(1);
+  REQUIRE(v.capacity() == 1);
+  v.push_back(2);
+  REQUIRE(v.capacity() == 2);
+  v.push_back(3);
+  REQUIRE(v.capacity() == 4);
+  REQUIRE(v[2] == 3);
+}
+
+namespace {
+// A unique_ptr-style handle that counts its moves and the values it frees.
+// `kTriviallyRelocatable` lets the vector move it bytewise, so relocation
+// never calls the move constructor or the destructor.
+struct Handle {
+  static constexpr bool kTriviallyRelocatable = true;
+  static inline int moves = 0;
+  static inline int freed = 0;
+
+  explicit Handle(const int value) : ptr(new int(value)) {}
+  Handle(const Handle &) = delete;
+  Handle(Handle &&other) noexcept : ptr(other.ptr) {
+    other.ptr = nullptr;
+    ++moves;
+  }
+  auto operator=(const Handle &) -> Handle & = delete;
+  auto operator=(Handle &&other) noexcept -> Handle & {
+    Swap(ptr, other.ptr);
+    ++moves;
+    return *this;
+  }
+  ~Handle() {
+    if (ptr != nullptr) {
+      ++freed;
+      delete ptr;
+    }
+  }
+
+  int *ptr;
+};
+} // namespace
+
+TEST_CASE("Vector relocates trivially relocatable elements bytewise") {
+  STATIC_REQUIRE(IsTriviallyRelocatable<Handle>::value);
+  Handle::moves = Handle::freed = 0;
+  {
+    vector<Handle> v;
+    for (int i = 0; i < 100; ++i) {
+      v.emplace_back(i);
+    }
+    v.emplace(v.begin(), -1);
+    v.emplace(v.begin() + 50, -2);
+    REQUIRE(v.size() == 102);
+    REQUIRE(*v[0].ptr == -1);
+    REQUIRE(*v[1].ptr == 0);
+    REQUIRE(*v[50].ptr == -2);
+    REQUIRE(*v[51].ptr == 49);
+    REQUIRE(*v[101].ptr == 99);
+
+    v.erase(v.begin());
+    v.erase(v.begin() + 49);
+    REQUIRE(Handle::freed == 2);
+    v.erase(v.begin() + 10, v.begin() + 20);
+    REQUIRE(Handle::freed == 12);
+    REQUIRE(v.size() == 90);
+    REQUIRE(*v[9].ptr == 9);
+    REQUIRE(*v[10].ptr == 20);
+    REQUIRE(*v[89].ptr == 99);
+
+    v.reserve(1000);
+    v.shrink_to_fit();
+    REQUIRE(v.capacity() < 1000);
+    REQUIRE(*v[89].ptr == 99);
+    // Only the two elements emplaced before the end were moved into place.
+    REQUIRE(Handle::moves == 2);
+  }
+  REQUIRE(Handle::freed == 102);
+}
+
+TEST_CASE("Vector erase destroys the vacated last element") {
+  vector<std::string> v;
+  for (int i = 0; i < 4; ++i) {
+    v.push_back(std::string(50, static_cast<char>('a' + i)));
+  }
+  v.erase(v.begin() + 1);
+  REQUIRE(v.size() == 3);
+  REQUIRE(v[1] == std::string(50, 'c'));
+  REQUIRE(v[2] == std::string(50, 'd'));
+  v.erase(v.begin(), v.begin() + 2);
+  REQUIRE(v.size() == 1);
+  REQUIRE(v[0] == std::string(50, 'd'));
+}